@@ -0,0 +1,85 @@
+#include "tinynes/apu.h"
+
+#include <chrono>
+#include <cstdio>
+
+// Renders audio straight from the APU, without CPU or PPU, and reports the synthesis throughput.
+// A short tune keeps rewriting the pulse, triangle and noise registers once per video frame like
+// a sound driver does.
+
+namespace
+{
+
+constexpr uint32_t SAMPLE_RATE = 44100;
+constexpr uint32_t SECONDS = 120;
+constexpr uint64_t CPU_CLOCKS_PER_FRAME = 29781;
+
+void playNote(tn::APU &apu, uint32_t frame)
+{
+    static constexpr uint16_t PERIODS[] = {0x1AB, 0x17C, 0x152, 0x13F, 0x11C, 0x0FD, 0x0E2, 0x0D5};
+    uint16_t period = PERIODS[(frame / 8) % 8];
+
+    apu.cpuWrite(0x4000, 0xBF);
+    apu.cpuWrite(0x4002, period & 0xFF);
+    apu.cpuWrite(0x4003, 0x08 | (period >> 8));
+    apu.cpuWrite(0x4004, 0x4F | ((frame & 0x10) << 2));
+    apu.cpuWrite(0x4006, (period >> 1) & 0xFF);
+    apu.cpuWrite(0x4007, 0x08 | (period >> 9));
+    apu.cpuWrite(0x4008, 0xFF);
+    apu.cpuWrite(0x400A, (period << 1) & 0xFF);
+    apu.cpuWrite(0x400B, 0x08 | ((period >> 7) & 0x07));
+    apu.cpuWrite(0x400C, 0x3F);
+    apu.cpuWrite(0x400E, frame & 0x0F);
+    apu.cpuWrite(0x400F, 0x08);
+}
+
+void run(tn::APU::SampleMode mode, const char *name, uint8_t mute_mask = 0,
+         bool is_stems = false)
+{
+    tn::APU apu;
+    apu.setSampleRate(SAMPLE_RATE);
+    apu.setSampleMode(mode);
+    apu.setMuteMask(mute_mask);
+    apu.setStemOutput(is_stems);
+    apu.cpuWrite(0x4015, 0x0F);
+
+    uint64_t samples = 0;
+    uint64_t next_frame = 0;
+    uint32_t frame = 0;
+    double checksum = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (samples < static_cast<uint64_t>(SAMPLE_RATE) * SECONDS) {
+        uint64_t clock = apu.nextSampleClock();
+        if (clock >= next_frame) {
+            apu.syncTo(next_frame);
+            playNote(apu, frame);
+            frame += 1;
+            next_frame += CPU_CLOCKS_PER_FRAME;
+            continue;
+        }
+        apu.syncTo(clock);
+        checksum += apu.readSample();
+        samples += 1;
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    double elapsed = std::chrono::duration<double>(stop - start).count();
+    std::printf("bench_apu %-12s: %llu samples in %.3f s, %.2f Msamples/s, %.0fx real time "
+                "(checksum %.6f)\n",
+                name, static_cast<unsigned long long>(samples), elapsed,
+                samples / elapsed * 1e-6, samples / elapsed / SAMPLE_RATE, checksum);
+}
+
+} // namespace
+
+int main()
+{
+    run(tn::APU::SampleMode::POINT, "point");
+    run(tn::APU::SampleMode::BLIP, "blip");
+    run(tn::APU::SampleMode::SINC, "sinc");
+    // muted channels are not synthesized at all
+    run(tn::APU::SampleMode::BLIP, "blip -noise", tn::APU::channelBit(tn::APU::NOISE));
+    run(tn::APU::SampleMode::BLIP, "blip +stems", 0, true);
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef TINYNES_BENCH_COMMON_H
+#define TINYNES_BENCH_COMMON_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "tinynes/bus.h"
+
+// Fixtures shared by the benchmarks
+
+namespace bench
+{
+
+// press start once the title screen is up, then keep running and jumping to the right
+inline uint8_t scriptedInput(int frame)
+{
+    if (frame >= 60 && frame < 70) {
+        return 0x10;
+    }
+    return (frame > 120 && frame % 40 < 20) ? 0x81 : 0x00;
+}
+
+// one frame of the bus with the scripted input of 'frame' on the first controller
+inline void runFrame(tn::Bus &bus, int frame)
+{
+    bus.controller()[0] = scriptedInput(frame);
+    do {
+        bus.clock();
+    } while (!bus.ppu().getFrameState());
+    bus.ppu().setFrameState(false);
+}
+
+// Synthetic iNES image with 'prg_banks' 16 KiB and 'chr_banks' 8 KiB banks, 0 for CHR RAM
+inline void writeImage(const std::filesystem::path &path, uint8_t mapper, uint8_t prg_banks,
+                       uint8_t chr_banks)
+{
+    uint8_t header[16] = {'N', 'E', 'S', 0x1A, prg_banks, chr_banks,
+                          static_cast<uint8_t>((mapper & 0x0F) << 4),
+                          static_cast<uint8_t>(mapper & 0xF0)};
+    std::vector<char> data(prg_banks * 16 * 1024 + chr_banks * 8 * 1024);
+    for (std::size_t idx = 0; idx < data.size(); idx += 1) {
+        data[idx] = static_cast<char>(idx * 131 + (idx >> 10));
+    }
+    std::ofstream ofs(path, std::ofstream::binary);
+    ofs.write(reinterpret_cast<const char *>(header), sizeof(header));
+    ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+} // namespace bench
+
+#endif
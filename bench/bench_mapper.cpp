@@ -0,0 +1,106 @@
+#include "bench_common.h"
+#include "tinynes/cartridge.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+// Measures the cartridge side of the bus for every supported mapper: reads through the bank
+// tables, as the CPU and the PPU issue them, and bank switches through the mapper registers.
+// Each mapper gets a synthetic iNES image with its largest common PRG and CHR layout.
+
+namespace
+{
+
+constexpr uint32_t READS = 1u << 26;
+constexpr uint32_t SWITCHES = 1u << 22;
+
+using SwitchFunc = void (*)(tn::Cartridge &cart, uint8_t bank);
+
+struct MapperCase
+{
+    uint8_t id;
+    const char *name;
+    uint8_t prg_banks; // 16 KiB units
+    uint8_t chr_banks; // 8 KiB units, 0 for CHR RAM
+    SwitchFunc bankSwitch;
+};
+
+void switchNone(tn::Cartridge &cart, uint8_t bank) { cart.cpuWrite(0x8000, bank); }
+
+// five serial writes load the PRG bank register
+void switchMMC1(tn::Cartridge &cart, uint8_t bank)
+{
+    for (uint8_t bit = 0; bit < 5; bit += 1) {
+        cart.cpuWrite(0xE000, static_cast<uint8_t>((bank >> bit) & 0x01));
+    }
+}
+
+// select R6, then write it
+void switchMMC3(tn::Cartridge &cart, uint8_t bank)
+{
+    cart.cpuWrite(0x8000, 0x06);
+    cart.cpuWrite(0x8001, bank);
+}
+
+constexpr MapperCase CASES[] = {
+    {0, "NROM", 2, 1, switchNone},
+    {1, "MMC1", 16, 16, switchMMC1},
+    {2, "UxROM", 16, 0, switchNone},
+    {3, "CNROM", 2, 4, switchNone},
+    {4, "MMC3", 32, 32, switchMMC3},
+    {7, "AxROM", 16, 0, switchNone},
+};
+
+void run(const MapperCase &mapper)
+{
+    auto path = std::filesystem::temp_directory_path()
+                / ("bench_mapper" + std::to_string(mapper.id) + ".nes");
+    bench::writeImage(path, mapper.id, mapper.prg_banks, mapper.chr_banks);
+    tn::Cartridge cart(path.string());
+    std::filesystem::remove(path);
+    if (!cart.isNesFileLoaded()) {
+        std::printf("bench_mapper %-6s: failed to load\n", mapper.name);
+        return;
+    }
+
+    // one CPU read per PPU read, the addresses walk all banks and pages
+    uint32_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t idx = 0; idx < READS; idx += 2) {
+        uint8_t data = 0;
+        cart.cpuRead(static_cast<uint16_t>(0x8000 | ((idx * 97) & 0x7FFF)), data);
+        checksum += data;
+        cart.ppuRead(static_cast<uint16_t>((idx * 61) & 0x1FFF), data);
+        checksum += data;
+    }
+    double read_elapsed
+        = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t idx = 0; idx < SWITCHES; idx += 1) {
+        mapper.bankSwitch(cart, static_cast<uint8_t>(idx));
+        if (cart.isA12Watched()) {
+            cart.ppuA12Rise();
+        }
+    }
+    uint8_t data = 0;
+    cart.cpuRead(0x8000, data);
+    checksum += data;
+    double switch_elapsed
+        = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("bench_mapper %-6s: %.1f Mreads/s, %.2f Mswitches/s (checksum %08x)\n",
+                mapper.name, READS / read_elapsed * 1e-6, SWITCHES / switch_elapsed * 1e-6,
+                checksum);
+}
+
+} // namespace
+
+int main()
+{
+    for (const MapperCase &mapper : CASES) {
+        run(mapper);
+    }
+    return 0;
+}
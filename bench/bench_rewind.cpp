@@ -0,0 +1,73 @@
+#include "bench_common.h"
+#include "tinynes/bus.h"
+#include "tinynes/rewind.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Captures every frame of a minute of play into the rewind history and reports what a capture
+// costs the emulation thread and the worker, and how much memory the history takes. Then steps
+// back frame by frame and checks each restored state against the one saved at that frame.
+//
+// usage: bench_rewind [file.nes] [seconds] [limit MiB]
+
+int main(int argc, char *argv[])
+{
+    std::string rom = argc > 1 ? argv[1] : std::string(TINYNES_WORKSPACE) + "/nesfiles/smb.nes";
+    int frames = (argc > 2 ? std::atoi(argv[2]) : 60) * 60;
+    std::size_t limit = (argc > 3 ? std::atoi(argv[3]) : 32) * std::size_t{1024 * 1024};
+
+    auto cart = std::make_shared<tn::Cartridge>(rom);
+    if (!cart->isNesFileLoaded()) {
+        std::printf("bench_rewind: cannot load %s\n", rom.c_str());
+        return 1;
+    }
+    tn::Bus bus;
+    bus.insertCartridge(cart);
+    bus.reset();
+    tn::Rewind rewind(bus, limit);
+
+    // the states as they were saved, to compare the decoded ones with
+    std::vector<std::vector<uint8_t>> expected(frames);
+    double emulate_us = 0.0;
+    for (int frame = 0; frame < frames; frame += 1) {
+        auto start = std::chrono::steady_clock::now();
+        bench::runFrame(bus, frame);
+        emulate_us += std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start).count();
+        rewind.capture();
+        bus.saveState(expected[frame]);
+    }
+    tn::Rewind::Stats stats = rewind.stats();
+    std::printf("bench_rewind: %s, %d frames captured, %zu kept in %.2f MiB (limit %zu MiB)\n",
+                rom.c_str(), frames, stats.frames, stats.bytes / (1024.0 * 1024.0),
+                limit / (1024 * 1024));
+    std::printf("bench_rewind: capture %.2f us per frame on the emulation thread (%.1f us to "
+                "emulate a frame), %.2f us on the worker, encoded to %.1f%% of %zu bytes\n",
+                stats.capture_us, emulate_us / frames, stats.compress_us, stats.ratio * 100.0,
+                expected.back().size());
+
+    // step back through the whole history
+    int mismatches = 0;
+    int steps = 0;
+    double step_us = 0.0;
+    std::vector<uint8_t> state;
+    for (int frame = frames - 2; frame >= frames - static_cast<int>(stats.frames); frame -= 1) {
+        auto start = std::chrono::steady_clock::now();
+        bool is_ok = rewind.stepBack();
+        step_us += std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - start).count();
+        steps += 1;
+        bus.saveState(state);
+        if (!is_ok || state != expected[frame]) {
+            mismatches += 1;
+        }
+    }
+    std::printf("bench_rewind: stepped back %d frames, %.2f us per step, %d mismatching states\n",
+                steps, steps > 0 ? step_us / steps : 0.0, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
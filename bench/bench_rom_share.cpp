@@ -0,0 +1,93 @@
+#include "bench_common.h"
+#include "tinynes/cartridge.h"
+#include "tinynes/rom_image.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+// Loads many cartridges of the same game, as a batch of emulator instances does, and reports the
+// resident memory each one adds. Half of them are loaded through a copy of the file, which must
+// share the same ROM pages as well. Also reports how long loading a game takes once its file is
+// mapped, which parses the header and reuses the checksum of PRG and CHR ROM the image keeps.
+//
+// usage: bench_rom_share [instances]
+
+namespace
+{
+
+constexpr uint8_t PRG_BANKS = 16; // 256 KiB
+constexpr uint8_t CHR_BANKS = 32; // 256 KiB
+
+// resident set size in KiB, 0 where /proc is not available
+long residentKiB()
+{
+    long pages = 0;
+    long resident = 0;
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    std::fclose(statm);
+    return resident * 4;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int instances = argc > 1 ? std::atoi(argv[1]) : 500;
+    auto dir = std::filesystem::temp_directory_path();
+    auto path = dir / "bench_rom_share.nes";
+    auto copy = dir / "bench_rom_share_copy.nes";
+    // MMC3
+    bench::writeImage(path, 4, PRG_BANKS, CHR_BANKS);
+    bench::writeImage(copy, 4, PRG_BANKS, CHR_BANKS);
+
+    long before = residentKiB();
+    std::vector<std::shared_ptr<tn::Cartridge>> carts;
+    uint32_t checksum = 0;
+    for (int idx = 0; idx < instances; idx += 1) {
+        auto cart = std::make_shared<tn::Cartridge>((idx % 2 == 0 ? path : copy).string());
+        // touch every PRG bank like a running game would
+        for (uint8_t bank = 0; bank < PRG_BANKS * 2; bank += 1) {
+            uint8_t data = 0;
+            cart->cpuWrite(0x8000, 0x06);
+            cart->cpuWrite(0x8001, bank);
+            for (uint16_t addr = 0x8000; addr < 0xA000; addr += 512) {
+                cart->cpuRead(addr, data);
+                checksum += data;
+            }
+        }
+        carts.push_back(cart);
+    }
+    long after = residentKiB();
+
+    // loading a game that is already mapped, the header is parsed and the checksum reused
+    constexpr int LOADS = 200;
+    auto start = std::chrono::steady_clock::now();
+    for (int idx = 0; idx < LOADS; idx += 1) {
+        tn::Cartridge cart(path.string());
+        checksum += cart.info().crc;
+    }
+    double load_us = std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start).count() / LOADS;
+
+    std::printf("bench_rom_share: %d instances of a %d KiB ROM, %zu image(s) mapped\n", instances,
+                (PRG_BANKS * 16 + CHR_BANKS * 8), tn::RomImage::cachedCount());
+    std::printf("bench_rom_share: resident %ld KiB -> %ld KiB, %.1f KiB per instance "
+                "(checksum %08x)\n",
+                before, after, static_cast<double>(after - before) / instances, checksum);
+    std::printf("bench_rom_share: %.1f us per load of a mapped game\n", load_us);
+
+    carts.clear();
+    std::filesystem::remove(path);
+    std::filesystem::remove(copy);
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "bench_common.h"
+#include "tinynes/bus.h"
+#include "tinynes/crc32.h"
+#include "tinynes/run_ahead.h"
+#include "tinynes/vscreen.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Reports the emulation speed with run-ahead of 0 to 3 frames and the cost of each frame run
+// ahead. Also checks the pictures: run N frames ahead, the picture shown after frame f must be
+// frame f + N of a plain run, wherever the input does not change in between.
+//
+// usage: bench_run_ahead [file.nes] [frames]
+
+namespace
+{
+
+uint32_t hashScreen(const std::shared_ptr<tn::VScreen> &screen)
+{
+    return tn::crc32(screen->pixels().data(), screen->pixels().size());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string rom = argc > 1 ? argv[1] : std::string(TINYNES_WORKSPACE) + "/nesfiles/smb.nes";
+    int frames = argc > 2 ? std::atoi(argv[2]) : 1200;
+
+    auto cart = std::make_shared<tn::Cartridge>(rom);
+    if (!cart->isNesFileLoaded()) {
+        std::printf("bench_run_ahead: cannot load %s\n", rom.c_str());
+        return 1;
+    }
+
+    std::vector<uint32_t> expected;
+    int mismatches = 0;
+    double plain_us = 0.0;
+    for (uint32_t ahead = 0; ahead <= tn::RunAhead::MAX_FRAMES; ahead += 1) {
+        tn::Bus bus;
+        bus.insertCartridge(cart->clone());
+        bus.reset();
+        tn::RunAhead run_ahead(bus, ahead);
+
+        std::vector<uint32_t> hashes;
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame += 1) {
+            bench::runFrame(bus, frame);
+            run_ahead.update();
+            hashes.push_back(hashScreen(run_ahead.vScreenMain()));
+        }
+        double elapsed_us = std::chrono::duration<double, std::micro>(
+                                std::chrono::steady_clock::now() - start).count();
+
+        if (ahead == 0) {
+            expected = hashes;
+            plain_us = elapsed_us / frames;
+            std::printf("bench_run_ahead: %s, no run-ahead %.0f fps\n", rom.c_str(),
+                        1e6 / plain_us);
+            continue;
+        }
+        for (int frame = 0; frame + static_cast<int>(ahead) < frames; frame += 1) {
+            bool is_same_input = true;
+            for (uint32_t idx = 1; idx <= ahead; idx += 1) {
+                is_same_input = is_same_input
+                                && bench::scriptedInput(frame + idx) == bench::scriptedInput(frame);
+            }
+            if (is_same_input && hashes[frame] != expected[frame + ahead]) {
+                mismatches += 1;
+            }
+        }
+        tn::RunAhead::Stats stats = run_ahead.stats();
+        std::printf("bench_run_ahead: %u frame(s) ahead %.0f fps, %.0f us per frame run ahead "
+                    "(%.0f%% of a plain frame)\n",
+                    ahead, 1e6 * frames / elapsed_us, stats.frame_us,
+                    100.0 * stats.frame_us / plain_us);
+    }
+    std::printf("bench_run_ahead: %d pictures differ from the plain run\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
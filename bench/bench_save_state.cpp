@@ -0,0 +1,103 @@
+#include "bench_common.h"
+#include "tinynes/bus.h"
+#include "tinynes/crc32.h"
+#include "tinynes/vscreen.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Reports the size of a save state and how long saving and loading one takes, then checks that
+// emulation is deterministic across a restore: the frames run after loading a state, into the
+// same bus and into a second one, must hash the same as the frames run after saving it.
+//
+// usage: bench_save_state [file.nes] [frames]
+
+namespace
+{
+
+// CRC of each frame's picture
+std::vector<uint32_t> runFrames(tn::Bus &bus, int first_frame, int frames)
+{
+    std::vector<uint32_t> hashes;
+    for (int frame = first_frame; frame < first_frame + frames; frame += 1) {
+        bench::runFrame(bus, frame);
+        const auto &pixels = bus.ppu().vScreenMain()->pixels();
+        hashes.push_back(tn::crc32(pixels.data(), pixels.size()));
+    }
+    return hashes;
+}
+
+int countMismatches(const std::vector<uint32_t> &expected, const std::vector<uint32_t> &actual)
+{
+    int mismatches = 0;
+    for (std::size_t idx = 0; idx < expected.size(); idx += 1) {
+        if (expected[idx] != actual[idx]) {
+            if (mismatches == 0) {
+                std::printf("bench_save_state: first mismatch %zu frames after the restore\n",
+                            idx);
+            }
+            mismatches += 1;
+        }
+    }
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string rom = argc > 1 ? argv[1] : std::string(TINYNES_WORKSPACE) + "/nesfiles/smb.nes";
+    int frames = argc > 2 ? std::atoi(argv[2]) : 600;
+
+    auto cart = std::make_shared<tn::Cartridge>(rom);
+    if (!cart->isNesFileLoaded()) {
+        std::printf("bench_save_state: cannot load %s\n", rom.c_str());
+        return 1;
+    }
+    tn::Bus bus;
+    bus.insertCartridge(cart);
+    bus.reset();
+    constexpr int WARMUP_FRAMES = 300;
+    runFrames(bus, 0, WARMUP_FRAMES);
+
+    std::vector<uint8_t> state;
+    bus.saveState(state);
+
+    constexpr int ROUNDS = 20000;
+    std::vector<uint8_t> scratch;
+    auto start = std::chrono::steady_clock::now();
+    for (int idx = 0; idx < ROUNDS; idx += 1) {
+        bus.saveState(scratch);
+    }
+    double save_us = std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start).count() / ROUNDS;
+    start = std::chrono::steady_clock::now();
+    for (int idx = 0; idx < ROUNDS; idx += 1) {
+        bus.loadState(state);
+    }
+    double load_us = std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start).count() / ROUNDS;
+
+    std::printf("bench_save_state: %s, %zu bytes per state (%zu of MachineState)\n", rom.c_str(),
+                state.size(), sizeof(tn::MachineState));
+    std::printf("bench_save_state: save %.2f us, load %.2f us\n", save_us, load_us);
+
+    // the reference run starts from the loaded state as well, loading must not change anything
+    std::vector<uint32_t> expected = runFrames(bus, WARMUP_FRAMES, frames);
+    bool is_loaded = bus.loadState(state);
+    std::vector<uint32_t> same_bus = runFrames(bus, WARMUP_FRAMES, frames);
+
+    tn::Bus other;
+    other.insertCartridge(std::make_shared<tn::Cartridge>(rom));
+    is_loaded = other.loadState(state) && is_loaded;
+    std::vector<uint32_t> other_bus = runFrames(other, WARMUP_FRAMES, frames);
+
+    int mismatches = countMismatches(expected, same_bus) + countMismatches(expected, other_bus);
+    std::printf("bench_save_state: %d frames after a restore, %d mismatching frame hashes\n",
+                frames, mismatches);
+    return is_loaded && mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include "bench_common.h"
+#include "tinynes/bus.h"
+#include "tinynes/crc32.h"
+#include "tinynes/vscreen.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Runs the same frames with the PPU composing on the emulation thread, with no frame composed at
+// all, which is the share of the emulation thread while a render worker composes, and with a
+// render worker, and reports the frame rate of each. Then checks the output: the threaded picture
+// shown after frame f must be the single-threaded picture of frame f - 1, and the CPU RAM after
+// every frame must be the same in all runs, so the sprite zero hits seen by the game did not
+// move.
+//
+// usage: bench_threaded_render [file.nes] [frames]
+
+namespace
+{
+
+enum class Mode
+{
+    COMPOSED,
+    NOT_COMPOSED,
+    THREADED,
+};
+
+struct Run
+{
+    std::vector<uint32_t> pictures;
+    std::vector<uint32_t> ram;
+    double us{0.0};
+};
+
+Run runFrames(const std::shared_ptr<tn::Cartridge> &cart, Mode mode, int frames)
+{
+    tn::Bus bus;
+    bus.insertCartridge(cart->clone());
+    bus.reset();
+    bus.setThreadedRendering(mode == Mode::THREADED);
+    bus.ppu().setFrameRendered(mode == Mode::COMPOSED);
+
+    Run run;
+    for (int frame = 0; frame < frames; frame += 1) {
+        auto start = std::chrono::steady_clock::now();
+        bench::runFrame(bus, frame);
+        run.us += std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - start).count();
+
+        const auto &pixels = bus.ppu().vScreenMain()->pixels();
+        run.pictures.push_back(tn::crc32(pixels.data(), pixels.size()));
+        run.ram.push_back(tn::crc32(bus.cpuRAM().data(), bus.cpuRAM().size()));
+    }
+    return run;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string rom = argc > 1 ? argv[1] : std::string(TINYNES_WORKSPACE) + "/nesfiles/smb.nes";
+    int frames = argc > 2 ? std::atoi(argv[2]) : 1200;
+
+    auto cart = std::make_shared<tn::Cartridge>(rom);
+    if (!cart->isNesFileLoaded()) {
+        std::printf("bench_threaded_render: cannot load %s\n", rom.c_str());
+        return 1;
+    }
+
+    Run single = runFrames(cart, Mode::COMPOSED, frames);
+    Run emulation = runFrames(cart, Mode::NOT_COMPOSED, frames);
+    Run threaded = runFrames(cart, Mode::THREADED, frames);
+    std::printf("bench_threaded_render: %s, single-threaded %.0f fps (%.0f us per frame), "
+                "emulation thread alone %.0f fps (%.0f us per frame, %.0f%% of single-threaded), "
+                "threaded %.0f fps\n",
+                rom.c_str(), 1e6 * frames / single.us, single.us / frames,
+                1e6 * frames / emulation.us, emulation.us / frames,
+                100.0 * emulation.us / single.us, 1e6 * frames / threaded.us);
+
+    int picture_mismatches = 0;
+    int ram_mismatches = 0;
+    for (int frame = 0; frame < frames; frame += 1) {
+        if (frame > 0 && threaded.pictures[frame] != single.pictures[frame - 1]) {
+            picture_mismatches += 1;
+        }
+        if (threaded.ram[frame] != single.ram[frame] || emulation.ram[frame] != single.ram[frame]) {
+            ram_mismatches += 1;
+        }
+    }
+    std::printf("bench_threaded_render: %d pictures and %d CPU RAM states differ\n",
+                picture_mismatches, ram_mismatches);
+    return picture_mismatches == 0 && ram_mismatches == 0 ? 0 : 1;
+}
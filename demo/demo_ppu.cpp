@@ -5,11 +5,11 @@
 
 static bool is_emulation_run{false};
 static int selected_palette{0};
+static bool is_name_table_view{false};
 
 void guiLogic(gui::GUI &gui)
 {
     sf::Sprite sprite;
-    sf::Clock clock;
 
     [[maybe_unused]] sf::Vector2u wsize = gui.window().getSize();
 
@@ -23,7 +23,6 @@ void guiLogic(gui::GUI &gui)
         return 0x00;
     };
 
-    clock.restart();
     while (gui.window().isOpen()) {
         sf::Event event;
         while (gui.window().pollEvent(event)) {
@@ -93,7 +92,6 @@ void guiLogic(gui::GUI &gui)
         // auto emulation
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
             gui.waitKeyReleased(sf::Keyboard::Space);
-            clock.restart();
             is_emulation_run = !is_emulation_run;
         }
 
@@ -110,18 +108,34 @@ void guiLogic(gui::GUI &gui)
             selected_palette &= 0x07;
         }
 
-        if (clock.getElapsedTime().asMicroseconds() > 300) {
-            clock.restart();
-            gui.renderCPU();
-            gui.renderOAM();
-
-            // draw main screen
-            gui.nes()->ppu().vScreenMain()->update(sprite);
-            sprite.setPosition(0, 0);
-            sprite.setScale(1.5, 1.5);
-            gui.window().draw(sprite);
+        // switch between pattern table and nametable debug views
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::N)) {
+            gui.waitKeyReleased(sf::Keyboard::N);
+            is_name_table_view = !is_name_table_view;
+        }
 
-            // draw palette
+        // the window waits for vsync, every loop iteration presents exactly one frame
+        gui.renderCPU();
+        gui.renderOAM();
+
+        // draw main screen
+        gui.nes()->ppu().vScreenMain()->update(sprite);
+        sprite.setPosition(0, 0);
+        sprite.setScale(1.5, 1.5);
+        gui.window().draw(sprite);
+
+        if (is_name_table_view) {
+            // draw the four nametables with the scroll window
+            for (uint8_t idx = 0; idx < 4; idx += 1) {
+                gui.nes()->ppu().vScreenNameTable(idx)->update(sprite);
+                sprite.setPosition(wsize.x * 0.02 + (idx & 0x01) * 64,
+                                   wsize.y * 0.75 + (idx >> 1) * 60);
+                sprite.setScale(0.25, 0.25);
+                gui.window().draw(sprite);
+            }
+        }
+        else {
+            // draw pattern tables
             gui.nes()->ppu().vScreenPatternTable(0, selected_palette)->update(sprite);
             sprite.setPosition(wsize.x * 0.02, wsize.y * 0.75);
             sprite.setScale(0.5, 0.5);
@@ -131,10 +145,20 @@ void guiLogic(gui::GUI &gui)
             sprite.setPosition(wsize.x * 0.3, wsize.y * 0.75);
             sprite.setScale(0.5, 0.5);
             gui.window().draw(sprite);
-
-            gui.window().display();
         }
-        sf::sleep(sf::microseconds(10));
+
+        // draw palettes and sprites
+        gui.nes()->ppu().vScreenPalette()->update(sprite);
+        sprite.setPosition(wsize.x * 0.64, wsize.y * 0.9);
+        sprite.setScale(1.0, 1.0);
+        gui.window().draw(sprite);
+
+        gui.nes()->ppu().vScreenSprites()->update(sprite);
+        sprite.setPosition(wsize.x * 0.57, wsize.y * 0.75);
+        sprite.setScale(0.5, 0.5);
+        gui.window().draw(sprite);
+
+        gui.window().display();
     }
 }
 
@@ -1,17 +1,20 @@
 #include "tinynes/gui.h"
+#include "tinynes/rewind.h"
+#include "tinynes/run_ahead.h"
 #include "tinynes/utils.h"
 #include "tinynes/vscreen.h"
 #include "tinynes/vsound.h"
 
-#include <SFML/System/Sleep.hpp>
 #include <SFML/System/Time.hpp>
 #include <SFML/System/Vector2.hpp>
 #include <SFML/Window/Keyboard.hpp>
 
+#include <cstdlib>
+
 static int selected_palette{0};
 
-void guiRenderGame(gui::GUI &gui, sf::Sprite &sprite, sf::Vector2u &wsize,
-                   [[maybe_unused]] float elapsed_time)
+// read right before the frame is emulated, so the frame already sees the keys
+void guiReadController(gui::GUI &gui)
 {
     std::function<uint8_t(sf::Keyboard::Key, uint8_t, std::string_view)> checker_func
         = [&](auto key, auto val, std::string_view name) -> uint8_t
@@ -23,8 +26,6 @@ void guiRenderGame(gui::GUI &gui, sf::Sprite &sprite, sf::Vector2u &wsize,
         return 0x00;
     };
 
-    gui.window().clear(gui::ONE_DARK.dark);
-
     gui.nes()->controller()[0] = 0x00;
     gui.nes()->controller()[0] |= checker_func(sf::Keyboard::X, 0x80, "X");
     gui.nes()->controller()[0] |= checker_func(sf::Keyboard::Z, 0x40, "Z");
@@ -34,6 +35,12 @@ void guiRenderGame(gui::GUI &gui, sf::Sprite &sprite, sf::Vector2u &wsize,
     gui.nes()->controller()[0] |= checker_func(sf::Keyboard::Down, 0x04, "Down Arrow");
     gui.nes()->controller()[0] |= checker_func(sf::Keyboard::Left, 0x02, "Left Arrow");
     gui.nes()->controller()[0] |= checker_func(sf::Keyboard::Right, 0x01, "Right Arrow");
+}
+
+void guiRenderGame(gui::GUI &gui, tn::VScreen &screen, sf::Sprite &sprite, sf::Vector2u &wsize,
+                   [[maybe_unused]] float elapsed_time)
+{
+    gui.window().clear(gui::ONE_DARK.dark);
 
     // reset
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::R)) {
@@ -49,7 +56,7 @@ void guiRenderGame(gui::GUI &gui, sf::Sprite &sprite, sf::Vector2u &wsize,
     }
 
     // draw main screen
-    gui.nes()->ppu().vScreenMain()->update(sprite);
+    screen.update(sprite);
     sprite.setPosition(0, 0);
     sprite.setScale(2.0, 2.0);
     gui.window().draw(sprite);
@@ -57,10 +64,12 @@ void guiRenderGame(gui::GUI &gui, sf::Sprite &sprite, sf::Vector2u &wsize,
     gui.window().display();
 }
 
-void guiLogic(gui::GUI &gui)
+void guiLogic(gui::GUI &gui, tn::VSound &stream, uint32_t run_ahead_frames)
 {
     sf::Sprite sprite;
     sf::Clock clock;
+    tn::Rewind rewind(*gui.nes());
+    tn::RunAhead run_ahead(*gui.nes(), run_ahead_frames);
 
     sf::Vector2u wsize = gui.window().getSize();
     while (gui.window().isOpen()) {
@@ -73,16 +82,36 @@ void guiLogic(gui::GUI &gui)
                 gui.window().close();
             }
         }
+        // hold Backspace to rewind, each displayed frame goes back one frame and replays it
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::BackSpace)) {
+            rewind.stepBack(2);
+        }
+        // one emulated frame per vsync, the audio rate follows the display
+        guiReadController(gui);
+        if (stream.runFrame()) {
+            rewind.capture();
+            run_ahead.update();
+        }
+
         // RENDER MAIN BEGIN
         auto elapsed = clock.restart();
-        guiRenderGame(gui, sprite, wsize, elapsed.asSeconds());
+        guiRenderGame(gui, *run_ahead.vScreenMain(), sprite, wsize, elapsed.asSeconds());
         // RENDER MAIN END
+    }
 
-        sf::sleep(sf::microseconds(10));
+    tn::Rewind::Stats stats = rewind.stats();
+    spdlog::info("Rewind: {} frames in {:.2f} MiB, capture {:.2f} us, compression {:.2f} us",
+                 stats.frames, stats.bytes / (1024.0 * 1024.0), stats.capture_us,
+                 stats.compress_us);
+    if (run_ahead.frames() > 0) {
+        tn::RunAhead::Stats ahead_stats = run_ahead.stats();
+        spdlog::info("Run-ahead: {} frames, {:.0f} us per frame run ahead", run_ahead.frames(),
+                     ahead_stats.frame_us);
     }
 }
 
-int main()
+// usage: demo_tinynes [file.nes] [run-ahead frames]
+int main(int argc, char *argv[])
 {
     gui::GUI gui;
 
@@ -92,13 +121,28 @@ int main()
     gui.setCPUPosition(wsize.x * 0.64, wsize.y * 0.02);
     gui.setOAMPosition(wsize.x * 0.64, wsize.y * 0.25);
 
-    gui.loadCartridge();
+    if (argc > 1) {
+        gui.loadCartridge(argv[1]);
+    }
+    else {
+        gui.loadCartridge();
+    }
 
     tn::VSound stream;
-    stream.init(512, 1, 44100, gui.nes());
+    stream.init(50, 1, 44100, gui.nes());
+    stream.fill();
     stream.play();
 
-    guiLogic(gui);
+    // 1 to 3 frames hide the input lag of most games, 0 turns run-ahead off
+    uint32_t run_ahead_frames = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 0;
+    guiLogic(gui, stream, run_ahead_frames);
+    stream.stop();
+
+    const auto &metrics = stream.metrics();
+    spdlog::info("Virtual Sound: {} underruns, {} overruns, fill {:.2f}, ratio {:.5f}, "
+                 "drift {:.0f} ppm",
+                 stream.underruns(), stream.overruns(), metrics.fill_level, metrics.ratio,
+                 metrics.drift_ppm);
 
     return 0;
 }
\ No newline at end of file
@@ -1,208 +1,196 @@
 #ifndef TINYNES_APU_H
 #define TINYNES_APU_H
 
+#include <array>
 #include <cstdint>
-#include <functional>
+#include <memory>
+#include <utility>
+
+#include "tinynes/apu_channels.h"
+#include "tinynes/blip_buffer.h"
+#include "tinynes/resampler.h"
 
 namespace tn
 {
 
+class Bus;
+
 // The APU has five channels: two pulse wave generators, a triangle wave, noise, and a delta
 // modulation channel for playing DPCM samples.
 class APU
 {
 public:
-    void cpuWrite(uint16_t addr, uint8_t data);
-    uint8_t cpuRead(uint16_t addr);
-    void clock();
-    void reset();
+    // Everything the channels need to resume exactly where they left off. The mixer and the
+    // output samplers are not part of it, they only shape what was already synthesized.
+    struct State
+    {
+        // APU cycles run so far, one APU cycle lasts two CPU clocks
+        uint64_t apu_cycle{0};
+        uint32_t frame_clock_counter{0};
+        // packed next to each other, the event loop touches all of them on every step
+        apu::PulseChannel<true> pulse1;
+        apu::PulseChannel<false> pulse2;
+        apu::TriangleChannel triangle;
+        apu::NoiseChannel noise;
+        apu::DMCChannel dmc;
+    };
 
-    double getOutputSample();
+    // The state lives in 'state' if given, the bus passes its MachineState
+    explicit APU(State *state = nullptr);
+    APU(const APU &) = delete;
+    APU &operator=(const APU &) = delete;
 
-private:
-    uint32_t frame_clock_counter_{0};
-    uint32_t clock_counter_{0};
+    // NTSC CPU clock rate in Hz
+    static constexpr double CPU_CLOCK_RATE = 1789773.0;
 
-private:
-    // NES Dev wiki - APU Frame Counter: https://www.nesdev.org/wiki/APU_Frame_Counter
-    // NES Dev wiki - APU Pulse, sequencer behavior: https://www.nesdev.org/wiki/APU_Pulse
-    struct Sequencer
-    {
-        uint32_t sequence{0};
-        uint32_t new_sequence{0};
-        uint16_t timer{0};
-        uint16_t reload{0};
-        uint8_t output{0};
-
-        uint8_t clock(bool is_enable, const std::function<void(uint32_t &s)> &doSomething)
-        {
-            if (is_enable) {
-                timer -= 1;
-                if (timer == 0xFFFF) {
-                    timer = reload;
-                    doSomething(sequence);
-                    output = sequence & 0x00000001;
-                }
-            }
-            return output;
-        }
-    };
+    // the DMC channel reads its samples from the CPU bus
+    void connectBus(Bus *bus) { bus_ = bus; }
 
-    struct OscillatorPulse
-    {
-        double frequency{0.0};
-        double duty_cycle{0.0};
-        double amplitude{1.0};
-        double pi{3.1415926535};
-        double harmonics{20};
-
-        double sample(double t)
-        {
-            double a = 0;
-            double b = 0;
-            double p = duty_cycle * 2.0 * pi;
-
-            // accumulate sin() calculation speed
-            auto approxsin = [](double t)
-            {
-                double j = t * 0.15915;
-                j = j - static_cast<int>(j);
-                return 20.785 * j * (j - 0.5) * (j - 1.0);
-            };
-
-            // use sine wave to generate pulse
-            for (double n = 1; n < harmonics; n += 1) {
-                double c = n * frequency * 2.0 * pi * t;
-                a += -approxsin(c) / n;
-                b += -approxsin(c - p * n) / n;
-            }
-            return (2.0 * amplitude / pi) * (a - b);
-        }
-    };
+    // registers must only be accessed after syncTo() the current CPU clock
+    void cpuWrite(uint16_t addr, uint8_t data);
+    uint8_t cpuRead(uint16_t addr);
+    void reset();
 
-    // NES Dev wiki - APU Length Counter: https://www.nesdev.org/wiki/APU_Length_Counter
-    struct LengthCounter
+    /**
+     * The APU runs lazily. Nothing happens until the bus asks it to catch up with 'cpu_clock',
+     * which it does before any register access and whenever the next audio sample is due. The
+     * channels then jump from one timer underflow or frame sequencer step to the next instead of
+     * stepping cycle by cycle.
+     */
+    void syncTo(uint64_t cpu_clock);
+    // Whether the DMC still has sample bytes to read. It cannot start again without a register
+    // write, so this holds for the whole stretch the APU has not caught up with yet.
+    bool isDMCActive() const { return state_->dmc.bytes_remaining > 0; }
+
+    // How output samples at the host rate are derived from the mixer output
+    enum class SampleMode
     {
-        uint8_t counter = 0x00;
-        uint8_t clock(bool is_enable, bool is_halt)
-        {
-            if (!is_enable) {
-                counter = 0;
-            }
-            else if (counter > 0 && !is_halt) {
-                counter -= 1;
-            }
-            return counter;
-        }
+        POINT, // pick the mixer level at the sample time, cheap but aliased
+        BLIP,  // band-limited steps at every level change
+        SINC,  // half-band and polyphase windowed-sinc decimation of the native rate output
     };
 
-    // NES Dev wiki - APU Envelope: https://www.nesdev.org/wiki/APU_Envelope
-    // The NES APU has an envelope generator that controls the volume in one of two ways:
-    // - it can generate a decreasing saw envelope with optional looping
-    // - it can generate a constant volume that a more sophisticated software envelope generator can
-    //   manipulate.
-    struct Envelope
-    {
-        bool is_start{false};
-        bool is_enable{false};
-        uint16_t decay_count{0};
-        uint16_t divider_count{0};
-        uint16_t constant_volume{0};
-        uint16_t output{0};
-
-        void clock(bool is_loop)
-        {
-            if (!is_start) {
-                if (divider_count == 0) {
-                    divider_count = constant_volume;
-
-                    if (decay_count == 0) {
-                        if (is_loop) {
-                            decay_count = 20;
-                        }
-                    }
-                    else {
-                        decay_count -= 1;
-                    }
-                }
-                else {
-                    decay_count -= 1;
-                }
-            }
-            else {
-                is_start = false;
-                decay_count = 20;
-                divider_count = constant_volume;
-            }
-
-            output = is_enable ? decay_count : constant_volume;
-        }
-    };
+    void setSampleRate(uint32_t sample_rate);
+    void setSampleMode(SampleMode mode);
+    SampleMode sampleMode() const { return sample_mode_; }
+    // Scales the number of output samples per emulated second, to be nudged by a rate controller
+    void setSampleRatio(double ratio);
+    // CPU clock at which syncTo() completes the next output sample
+    uint64_t nextSampleClock() const;
+    double readSample();
 
-    // NES Dev wiki - APU Sweep: https://www.nesdev.org/wiki/APU_Sweep
-    // Each of the two NES APU pulse (square) wave channels generate a pulse wave with variable
-    // duty.
-    struct Sweep
-    {
-        bool is_mute{false};
-        bool is_enable{false};
-        bool is_negate{false};
-        bool is_reload{false};
-        uint8_t shifter{0x00};
-        uint8_t timer{0x00};
-        uint8_t period{0x00};
-        uint16_t change_amount{0};
-
-        void track(uint16_t &target)
-        {
-            if (is_enable) {
-                change_amount = target >> shifter;
-                is_mute = (target < 0x8) || (target > 0x7FF);
-            }
-        }
-
-        bool clock(uint16_t &target, bool channel)
-        {
-            bool is_changed = false;
-            if (target >= 8 && change_amount < 0x07FF) {
-                if (timer == 0 && is_enable && shifter > 0 && !is_mute) {
-                    target = is_negate ? target - change_amount - static_cast<int>(channel)
-                                       : target + change_amount;
-                    is_changed = true;
-                }
-            }
-            if (timer == 0 || is_reload) {
-                timer = period;
-                is_reload = false;
-            }
-            else {
-                timer -= 1;
-            }
-            is_mute = (target < 8) || (target > 0x7FF);
-
-            return is_changed;
-        }
-    };
+    // current mixer level, 1.0 is the full scale of a 16 bit sample
+    double getOutputSample() const;
 
-    struct Sound
+    enum Channel : uint8_t
     {
-        double sample{0.0};
-        double output{0.0};
-        bool is_halt{false};
-        bool is_enable{false};
-        Sequencer sequencer;
-        OscillatorPulse osc;
-        Envelope envelope;
-        LengthCounter lc;
-        Sweep sweep;
+        PULSE1,
+        PULSE2,
+        TRIANGLE,
+        NOISE,
+        DMC,
+        CHANNEL_COUNT,
     };
+    static constexpr uint8_t channelBit(Channel channel) { return 1 << channel; }
+    static constexpr uint8_t ALL_CHANNELS = (1 << CHANNEL_COUNT) - 1;
+
+    /**
+     * Channel masks, bit n stands for Channel n. A muted channel drops out of the mixer and, except
+     * for the DMC, is not synthesized at all: its timer is frozen, only the register, length
+     * counter and envelope state keep being tracked. The DMC keeps running muted, its sample reads
+     * and IRQ are visible to the CPU. While any channel is soloed, the others are muted.
+     */
+    void setMuteMask(uint8_t mask);
+    void setSoloMask(uint8_t mask);
+    uint8_t muteMask() const { return mute_mask_; }
+    uint8_t soloMask() const { return solo_mask_; }
+
+    // Stem output synthesizes every channel alone into its own band-limited buffer in the same
+    // pass, readSample() then also takes one sample of each stem
+    void setStemOutput(bool enable);
+    bool isStemOutput() const { return is_stem_output_; }
+    double stemSample(Channel channel) const { return stem_samples_[channel]; }
+
+    // the channel state was replaced, recomputes the mixer level from it
+    void syncState();
 
-    Sound pulse1_;
-    Sound pulse2_;
-    Sound noise_;
-    static uint8_t length_table_[];
-    double global_time_{0.0};
-    bool is_raw_mode_{false};
+private:
+    State *state_{nullptr};
+    std::unique_ptr<State> own_state_;
+
+    // One instance per combination of active pulse, triangle and noise channels, inactive ones
+    // compile away. The DMC always runs.
+    template <uint8_t ACTIVE>
+    void runChannels(uint64_t end_cycle);
+    using RunChannelsFn = void (APU::*)(uint64_t);
+    template <std::size_t... MASKS>
+    static constexpr std::array<RunChannelsFn, sizeof...(MASKS)>
+    makeRunChannelsTable(std::index_sequence<MASKS...>)
+    {
+        return {&APU::runChannels<MASKS>...};
+    }
+    static const std::array<RunChannelsFn, (1 << DMC)> run_channels_table_;
+    RunChannelsFn run_channels_{&APU::runChannels<ALL_CHANNELS & ~(1 << DMC)>};
+
+    uint8_t mute_mask_{0};
+    uint8_t solo_mask_{0};
+    uint8_t active_mask_{ALL_CHANNELS};
+    void updateActiveMask();
+
+    void clockFrameSequencer();
+
+    // NES Dev wiki - APU Mixer: https://www.nesdev.org/wiki/APU_Mixer
+    // The DAC output is not linear, the lookup tables are indexed by the summed 4 bit channel
+    // levels and hold the mixed output in units of a 16 bit sample:
+    //   pulse_table[p1 + p2]             = 95.52 / (8128.0 / (p1 + p2) + 100)
+    //   tnd_table[3 * t + 2 * n + dmc]   = 163.67 / (24329.0 / (3 * t + 2 * n + dmc) + 100)
+    static const std::array<int32_t, 31> pulse_table_;
+    static const std::array<int32_t, 203> tnd_table_;
+    int32_t mixLevel() const;
+    void updateMixer(uint64_t cycle);
+    void updateStems(uint64_t cycle);
+
+    void resetSampler();
+
+    SampleMode sample_mode_{SampleMode::BLIP};
+    uint32_t sample_rate_{44100};
+    double sample_ratio_{1.0};
+    int32_t mix_level_{0};
+
+    BlipBuffer blip_;
+    // APU cycle the current BlipBuffer frame started on
+    uint64_t blip_frame_cycle_{0};
+    uint32_t blip_clocks_needed_{0};
+
+    Resampler resampler_;
+    // APU cycles up to this one have been pushed into the resampler
+    uint64_t resampler_cycle_{0};
+
+    // CPU clock of the next point sample, with 32 bit fraction
+    uint64_t point_clock_{0};
+    uint32_t point_fraction_{0};
+    uint64_t point_step_{0};
+
+    // one pole DC blocker for the POINT and SINC modes, BlipBuffer has its own
+    float dc_input_{0.0F};
+    float dc_output_{0.0F};
+
+    // each channel alone through the DAC, with its own BlipBuffer
+    bool is_stem_output_{false};
+    std::array<BlipBuffer, CHANNEL_COUNT> stem_blips_;
+    std::array<int32_t, CHANNEL_COUNT> stem_levels_{};
+    std::array<double, CHANNEL_COUNT> stem_samples_{};
+    uint64_t stem_frame_cycle_{0};
+
+    Bus *bus_{nullptr};
+    void fetchDMCSample();
+
+    template <typename Pulse>
+    void writePulseControl(Pulse &pulse, uint8_t data);
+    template <typename Pulse>
+    void writePulseSweep(Pulse &pulse, uint8_t data);
+    template <typename Pulse>
+    void writePulseLength(Pulse &pulse, uint8_t data);
 };
 
 } // namespace tn
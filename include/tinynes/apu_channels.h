@@ -0,0 +1,381 @@
+#ifndef TINYNES_APU_CHANNELS_H
+#define TINYNES_APU_CHANNELS_H
+
+#include <cstdint>
+#include <limits>
+
+namespace tn
+{
+
+/**
+ * Sound channels of the 2A03 APU. Each channel type only carries the units it really has and
+ * exposes the same inline interface to the event loop of the APU:
+ *
+ * - untilStep(): APU cycles before the timer underflows, so idle cycles can be skipped at once
+ * - skip(n): run n cycles known to be free of underflows
+ * - clock(): run one cycle, returns whether the waveform has stepped
+ * - level(): current DAC input
+ *
+ * All timers count APU cycles (two CPU clocks), except the triangle timer which counts CPU clocks.
+ */
+namespace apu
+{
+
+constexpr uint32_t IDLE = std::numeric_limits<uint32_t>::max();
+
+// NES Dev wiki - APU Length Counter: https://www.nesdev.org/wiki/APU_Length_Counter
+constexpr uint8_t LENGTH_TABLE[32] = {10, 254, 20,  2,  40, 4,  80, 6,  160, 8,  60,
+                                      10, 14,  12,  26, 14, 12, 16, 24, 18,  48, 20,
+                                      96, 22,  192, 24, 72, 26, 16, 28, 32,  30};
+
+struct LengthCounter
+{
+    uint8_t counter{0};
+
+    void clock(bool is_halt)
+    {
+        if (counter > 0 && !is_halt) {
+            counter -= 1;
+        }
+    }
+};
+
+// NES Dev wiki - APU Envelope: https://www.nesdev.org/wiki/APU_Envelope
+// The NES APU has an envelope generator that controls the volume in one of two ways:
+// - it can generate a decreasing saw envelope with optional looping
+// - it can generate a constant volume that a more sophisticated software envelope generator can
+//   manipulate.
+struct Envelope
+{
+    bool is_start{false};
+    bool is_enable{false};
+    uint8_t decay_count{0};
+    uint8_t divider_count{0};
+    uint8_t constant_volume{0};
+
+    void clock(bool is_loop)
+    {
+        if (is_start) {
+            is_start = false;
+            decay_count = 15;
+            divider_count = constant_volume;
+        }
+        else if (divider_count == 0) {
+            divider_count = constant_volume;
+            if (decay_count > 0) {
+                decay_count -= 1;
+            }
+            else if (is_loop) {
+                decay_count = 15;
+            }
+        }
+        else {
+            divider_count -= 1;
+        }
+    }
+
+    uint8_t volume() const { return is_enable ? decay_count : constant_volume; }
+};
+
+// NES Dev wiki - APU Sweep: https://www.nesdev.org/wiki/APU_Sweep
+// The two pulse channels only differ in how they negate: pulse 1 adds the one's complement of
+// the change amount, pulse 2 the two's complement.
+template <bool IS_PULSE1>
+struct Sweep
+{
+    bool is_enable{false};
+    bool is_negate{false};
+    bool is_reload{false};
+    uint8_t shifter{0};
+    uint8_t period{0};
+    uint8_t divider{0};
+
+    uint16_t target(uint16_t timer_period) const
+    {
+        uint16_t change = timer_period >> shifter;
+        if (is_negate) {
+            return timer_period - change - (IS_PULSE1 ? 1 : 0);
+        }
+        return timer_period + change;
+    }
+
+    // the channel is silenced even while the sweep unit is disabled
+    bool isMute(uint16_t timer_period) const
+    {
+        return timer_period < 8 || (!is_negate && target(timer_period) > 0x7FF);
+    }
+
+    void clock(uint16_t &timer_period)
+    {
+        if (divider == 0 && is_enable && shifter > 0 && !isMute(timer_period)) {
+            timer_period = target(timer_period);
+        }
+        if (divider == 0 || is_reload) {
+            divider = period;
+            is_reload = false;
+        }
+        else {
+            divider -= 1;
+        }
+    }
+};
+
+// NES Dev wiki - APU Pulse: https://www.nesdev.org/wiki/APU_Pulse
+template <bool IS_PULSE1>
+struct PulseChannel
+{
+    static constexpr uint8_t DUTY_TABLE[4] = {0b01000000, 0b01100000, 0b01111000, 0b10011111};
+
+    uint16_t timer{0};
+    uint16_t period{0};
+    uint8_t duty{0};
+    uint8_t step{0};
+    bool is_enable{false};
+    bool is_halt{false};
+    LengthCounter lc;
+    Envelope envelope;
+    Sweep<IS_PULSE1> sweep;
+
+    uint32_t untilStep() const { return is_enable ? timer : IDLE; }
+    void skip(uint32_t cycles)
+    {
+        if (is_enable) {
+            timer -= static_cast<uint16_t>(cycles);
+        }
+    }
+    bool clock()
+    {
+        if (!is_enable) {
+            return false;
+        }
+        if (timer != 0) {
+            timer -= 1;
+            return false;
+        }
+        timer = period;
+        step = (step + 1) & 0x07;
+        return true;
+    }
+
+    uint8_t level() const
+    {
+        if (lc.counter == 0 || sweep.isMute(period) || ((DUTY_TABLE[duty] >> step) & 0x01) == 0) {
+            return 0;
+        }
+        return envelope.volume();
+    }
+};
+
+// NES Dev wiki - APU Triangle: https://www.nesdev.org/wiki/APU_Triangle
+struct TriangleChannel
+{
+    static constexpr uint8_t SEQUENCE[32] = {15, 14, 13, 12, 11, 10, 9,  8,  7,  6,  5,
+                                             4,  3,  2,  1,  0,  0,  1,  2,  3,  4,  5,
+                                             6,  7,  8,  9,  10, 11, 12, 13, 14, 15};
+
+    // CPU clocks
+    uint16_t timer{0};
+    uint16_t period{0};
+    uint8_t step{0};
+    uint8_t linear_counter{0};
+    uint8_t linear_reload{0};
+    bool is_linear_reload{false};
+    bool is_control{false};
+    bool is_enable{false};
+    LengthCounter lc;
+
+    // Periods below 2 produce ultrasonic output, the sequencer is held there like most
+    // emulators do to avoid popping
+    bool isRunning() const
+    {
+        return is_enable && lc.counter > 0 && linear_counter > 0 && period >= 2;
+    }
+
+    // with a period of at least 2, at most one underflow happens per APU cycle
+    uint32_t untilStep() const { return isRunning() ? timer / 2 : IDLE; }
+    void skip(uint32_t cycles)
+    {
+        if (isRunning()) {
+            timer -= static_cast<uint16_t>(cycles * 2);
+        }
+    }
+    bool clock()
+    {
+        if (!isRunning()) {
+            return false;
+        }
+        if (timer >= 2) {
+            timer -= 2;
+            return false;
+        }
+        // underflow on the first or the second CPU clock of this cycle
+        timer = period - (1 - timer);
+        step = (step + 1) & 0x1F;
+        return true;
+    }
+
+    void clockLinearCounter()
+    {
+        if (is_linear_reload) {
+            linear_counter = linear_reload;
+        }
+        else if (linear_counter > 0) {
+            linear_counter -= 1;
+        }
+        if (!is_control) {
+            is_linear_reload = false;
+        }
+    }
+
+    uint8_t level() const { return SEQUENCE[step]; }
+};
+
+// NES Dev wiki - APU Noise: https://www.nesdev.org/wiki/APU_Noise
+struct NoiseChannel
+{
+    // NTSC periods in CPU clocks, halved for the APU cycle timer
+    static constexpr uint16_t PERIOD_TABLE[16] = {4,   8,   16,  32,  64,  96,   128,  160,
+                                                  202, 254, 380, 508, 762, 1016, 2034, 4068};
+
+    uint16_t timer{0};
+    uint16_t period{PERIOD_TABLE[0] / 2 - 1};
+    // 15 bit linear feedback shift register, loaded with 1 on power-up
+    uint16_t shift{1};
+    bool is_mode{false};
+    bool is_enable{false};
+    bool is_halt{false};
+    LengthCounter lc;
+    Envelope envelope;
+
+    uint32_t untilStep() const { return is_enable ? timer : IDLE; }
+    void skip(uint32_t cycles)
+    {
+        if (is_enable) {
+            timer -= static_cast<uint16_t>(cycles);
+        }
+    }
+    bool clock()
+    {
+        if (!is_enable) {
+            return false;
+        }
+        if (timer != 0) {
+            timer -= 1;
+            return false;
+        }
+        timer = period;
+        uint16_t feedback = (shift ^ (shift >> (is_mode ? 6 : 1))) & 0x01;
+        shift = static_cast<uint16_t>((shift >> 1) | (feedback << 14));
+        return true;
+    }
+
+    uint8_t level() const
+    {
+        if (lc.counter == 0 || (shift & 0x01) != 0) {
+            return 0;
+        }
+        return envelope.volume();
+    }
+};
+
+// NES Dev wiki - APU DMC: https://www.nesdev.org/wiki/APU_DMC
+struct DMCChannel
+{
+    // NTSC rates in CPU clocks, halved for the APU cycle timer
+    static constexpr uint16_t RATE_TABLE[16] = {428, 380, 340, 320, 286, 254, 226, 214,
+                                                190, 160, 142, 128, 106, 84,  72,  54};
+
+    uint16_t timer{0};
+    uint16_t period{RATE_TABLE[0] / 2 - 1};
+    uint16_t sample_address{0xC000};
+    uint16_t sample_length{1};
+    uint16_t current_address{0xC000};
+    uint16_t bytes_remaining{0};
+    uint8_t output{0};
+    uint8_t shift{0};
+    uint8_t bits_remaining{8};
+    uint8_t buffer{0};
+    bool is_buffer_full{false};
+    bool is_silence{true};
+    bool is_loop{false};
+    bool is_irq_enable{false};
+    bool is_irq{false};
+
+    bool isIdle() const { return is_silence && !is_buffer_full && bytes_remaining == 0; }
+
+    uint32_t untilStep() const { return isIdle() ? IDLE : timer; }
+    void skip(uint32_t cycles)
+    {
+        if (!isIdle()) {
+            timer -= static_cast<uint16_t>(cycles);
+        }
+    }
+    bool clock()
+    {
+        if (isIdle()) {
+            return false;
+        }
+        if (timer != 0) {
+            timer -= 1;
+            return false;
+        }
+        timer = period;
+
+        bool is_changed = false;
+        if (!is_silence) {
+            if ((shift & 0x01) != 0) {
+                if (output <= 125) {
+                    output += 2;
+                    is_changed = true;
+                }
+            }
+            else if (output >= 2) {
+                output -= 2;
+                is_changed = true;
+            }
+        }
+        shift >>= 1;
+
+        bits_remaining -= 1;
+        if (bits_remaining == 0) {
+            bits_remaining = 8;
+            is_silence = !is_buffer_full;
+            if (is_buffer_full) {
+                shift = buffer;
+                is_buffer_full = false;
+            }
+        }
+        return is_changed;
+    }
+
+    // the memory reader refills the sample buffer as soon as it runs empty
+    bool needsFetch() const { return !is_buffer_full && bytes_remaining > 0; }
+    void fetch(uint8_t data)
+    {
+        buffer = data;
+        is_buffer_full = true;
+        current_address = (current_address == 0xFFFF) ? 0x8000 : current_address + 1;
+        bytes_remaining -= 1;
+        if (bytes_remaining == 0) {
+            if (is_loop) {
+                restart();
+            }
+            else if (is_irq_enable) {
+                is_irq = true;
+            }
+        }
+    }
+    void restart()
+    {
+        current_address = sample_address;
+        bytes_remaining = sample_length;
+    }
+
+    uint8_t level() const { return output; }
+};
+
+} // namespace apu
+
+} // namespace tn
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef TINYNES_AUDIO_SINK_H
+#define TINYNES_AUDIO_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tn
+{
+
+/**
+ * Destination of the samples synthesized by the APU.
+ *
+ * The bus hands over mono samples in [-1, 1] in batches from the emulation thread. An
+ * implementation must not block for longer than it takes to copy them, a sink that talks to a
+ * device or a file does the slow part on its own thread.
+ */
+class AudioSink
+{
+public:
+    virtual ~AudioSink() = default;
+
+    // rate the APU has to produce samples at for this sink
+    virtual uint32_t sampleRate() const = 0;
+    // emulation thread
+    virtual void write(const float *samples, std::size_t count) = 0;
+    // make everything written so far reach its destination
+    virtual void flush() {}
+};
+
+// Discards all samples, for headless runs that do not care about audio
+class NullAudioSink : public AudioSink
+{
+public:
+    explicit NullAudioSink(uint32_t sample_rate = 44100) : sample_rate_(sample_rate) {}
+
+    uint32_t sampleRate() const override { return sample_rate_; }
+    void write([[maybe_unused]] const float *samples, std::size_t count) override
+    {
+        samples_written_ += count;
+    }
+
+    uint64_t samplesWritten() const { return samples_written_; }
+
+private:
+    uint32_t sample_rate_;
+    uint64_t samples_written_{0};
+};
+
+} // namespace tn
+
+#endif
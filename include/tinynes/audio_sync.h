@@ -0,0 +1,57 @@
+#ifndef TINYNES_AUDIO_SYNC_H
+#define TINYNES_AUDIO_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tn
+{
+
+/**
+ * Dynamic rate control between the emulated machine and the host audio device.
+ *
+ * When emulation is paced by the display, the NES produces 60.0988 frames of audio per host
+ * refresh period instead of exactly what the device consumes, so the audio queue slowly drains or
+ * fills up. After every emulated frame the controller looks at the queue fill level and nudges
+ * the resampling ratio by at most MAX_DEVIATION, which keeps the fill near its target without an
+ * audible pitch change.
+ */
+class AudioSync
+{
+public:
+    static constexpr double MAX_DEVIATION = 0.005;
+
+    struct Metrics
+    {
+        std::size_t fill_frames{0};
+        std::size_t target_frames{0};
+        // fill_frames relative to the target, 1.0 is on target
+        double fill_level{0.0};
+        // ratio applied to the output sample rate, above 1.0 produces more samples
+        double ratio{1.0};
+        // long term average of the correction in parts per million, the mismatch between the host
+        // refresh rate and the audio clock
+        double drift_ppm{0.0};
+        uint64_t updates{0};
+    };
+
+public:
+    void reset(std::size_t target_frames);
+    // feed the current queue fill level, returns the ratio to apply
+    double update(std::size_t fill_frames);
+
+    double ratio() const { return metrics_.ratio; }
+    const Metrics &metrics() const { return metrics_; }
+
+private:
+    // low pass filters, the fill level is sampled once per frame and jitters by a frame of audio
+    static constexpr double FILL_SMOOTHING = 0.1;
+    static constexpr double DRIFT_SMOOTHING = 0.002;
+
+    Metrics metrics_;
+    double smoothed_fill_{0.0};
+};
+
+} // namespace tn
+
+#endif
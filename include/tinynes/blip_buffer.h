@@ -0,0 +1,70 @@
+#ifndef TINYNES_BLIP_BUFFER_H
+#define TINYNES_BLIP_BUFFER_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace tn
+{
+
+/**
+ * Band-limited step synthesis buffer.
+ *
+ * Sound channels never compute waveforms themselves. Whenever the output level of the mixer
+ * changes, the difference is added here with the CPU clock it happened on, and the buffer stamps
+ * a precomputed band-limited step (integrated windowed sinc) into the output samples around that
+ * position. Summing the steps yields alias-free samples at the host rate, for the price of a few
+ * multiply-adds per level change.
+ *
+ * Time is counted in clocks from the start of the current frame, endFrame() makes the samples
+ * of that period available for reading and starts a new frame.
+ *
+ * @ref Band-limited sound synthesis: <http://www.slack.net/~ant/bl-synth/>
+ */
+class BlipBuffer
+{
+public:
+    explicit BlipBuffer(uint32_t capacity = 4096);
+
+    // 'sample_rate' can be changed at any time, e.g. to nudge the output rate
+    void setRates(double clock_rate, double sample_rate);
+    void clear();
+
+    void addDelta(uint32_t clock_time, int32_t delta);
+    void endFrame(uint32_t clock_duration);
+
+    // clocks the next frame has to last to make 'samples' more samples available
+    uint32_t clocksNeeded(uint32_t samples) const;
+    uint32_t samplesAvailable() const { return avail_; }
+    uint32_t readSamples(int16_t *out, uint32_t count);
+
+public:
+    static constexpr uint32_t PHASE_BITS = 6;
+    static constexpr uint32_t PHASES = 1 << PHASE_BITS;
+    static constexpr uint32_t HALF_WIDTH = 8;
+    static constexpr uint32_t WIDTH = HALF_WIDTH * 2;
+    // kernel coefficients of each phase sum up to 1 << KERNEL_BITS
+    static constexpr uint32_t KERNEL_BITS = 15;
+    // DC removal, cut-off frequency around sample_rate / (2 * pi * 2^BASS_SHIFT)
+    static constexpr uint32_t BASS_SHIFT = 9;
+
+private:
+    using Kernel = std::array<std::array<int16_t, WIDTH>, PHASES>;
+    static const Kernel &kernel();
+
+private:
+    static constexpr uint32_t TIME_BITS = 32;
+
+    // samples per clock, TIME_BITS fraction bits
+    uint64_t factor_{0};
+    // position of clock 0 of the current frame, relative to the first unread sample
+    uint64_t offset_{0};
+    uint32_t avail_{0};
+    int32_t integrator_{0};
+    std::vector<int32_t> buf_;
+};
+
+} // namespace tn
+
+#endif
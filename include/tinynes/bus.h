@@ -3,11 +3,16 @@
 
 #include <array>
 #include <cstdint>
+#include <vector>
 
 #include "tinynes/cpu.h"
 #include "tinynes/ppu.h"
 #include "tinynes/apu.h"
+#include "tinynes/audio_sink.h"
 #include "tinynes/cartridge.h"
+#include "tinynes/machine_state.h"
+#include "tinynes/nsf.h"
+#include "tinynes/ppu_render_worker.h"
 
 namespace tn
 {
@@ -16,7 +21,7 @@ class Bus
 {
 public:
     Bus();
-    ~Bus() = default;
+    ~Bus();
 
     void cpuWrite(uint64_t addr, uint8_t data);
     uint8_t cpuRead(uint64_t addr, bool read_only = false);
@@ -27,54 +32,103 @@ public:
     bool clock(); // return if sound thread generates a new value
     void reset();
 
+    /**
+     * Player mode: the NSF replaces the cartridge and the PPU is not clocked at all, each clock()
+     * runs one CPU clock. INIT is called on playTrack() and PLAY at the rate the file asks for,
+     * each PLAY call marks a frame so frame paced callers keep working. Inserting a cartridge
+     * leaves player mode.
+     */
+    void insertNSF(const std::shared_ptr<NSF> &nsf);
+    bool isPlayerMode() const { return nsf_ != nullptr; }
+    void playTrack(uint8_t track); // 0-based
+    uint8_t currentTrack() const { return nsf_track_; }
+    auto nsf() { return nsf_; }
+
+    // Compose frames on a worker thread, the displayed picture lags emulation by one frame
+    void setThreadedRendering(bool enable);
+    bool isThreadedRendering() const { return render_worker_ != nullptr; }
+
 public:
     // access device on the bus
     CPU &cpu() { return cpu_; }
     PPU &ppu() { return ppu_; }
     APU &apu() { return apu_; }
-    auto &cpuRAM() { return cpu_ram_; }
+    auto &cpuRAM() { return state_.bus.cpu_ram; }
     auto cartridge() { return cart_; }
-    auto &controller() { return controller_; }
+    auto &controller() { return state_.bus.controller; }
+
+    // CPU, PPU, APU and bus state, the cartridge is not included
+    const MachineState &machineState() const { return state_; }
+    // restores a state taken from machineState(), also of another bus running the same cartridge
+    void setMachineState(const MachineState &state);
+
+    /**
+     * Save states: a small header, the MachineState as it is in memory and the cartridge fields.
+     * 'buffer' is overwritten and keeps its capacity, so saving into the same buffer again does
+     * not allocate. The header carries the format version and the checksum of the game, loading
+     * a state of another game, of another format version or one cut short fails and leaves the
+     * machine untouched. Nothing is saved in player mode.
+     */
+    bool saveState(std::vector<uint8_t> &buffer) const;
+    bool loadState(const uint8_t *data, std::size_t size);
+    bool loadState(const std::vector<uint8_t> &buffer)
+    {
+        return loadState(buffer.data(), buffer.size());
+    }
 
     // APU
     void setAudioSampleFrequency(uint32_t sample_rate);
+    void setAudioSampleMode(APU::SampleMode mode) { apu_.setSampleMode(mode); }
+    // stretch the output rate by a small factor for dynamic rate control
+    void setAudioSampleRatio(double ratio) { apu_.setSampleRatio(ratio); }
     double getAudioSample() { return audio_sample_; }
     void setAudioSample(double val) { audio_sample_ = val; }
 
+    // Samples are also delivered to the sink in batches, the sink is not owned and has to
+    // outlive the bus or be detached with nullptr. Its rate becomes the audio sample rate.
+    void setAudioSink(AudioSink *sink);
+    AudioSink *audioSink() const { return audio_sink_; }
+    // APU::Channel bit masks, see APU::setMuteMask()
+    void setAudioMuteMask(uint8_t mask);
+    void setAudioSoloMask(uint8_t mask);
+    // Stem sink of one APU channel, stem output runs while any is attached. Stem sinks have to
+    // use the sample rate of the main sink.
+    void setAudioStemSink(APU::Channel channel, AudioSink *sink);
+    // deliver the samples of an unfinished batch
+    void flushAudio();
+
 private:
-    // accumulated audio sample time between two system sample time
-    double audio_time_{0.0};
+    static constexpr std::size_t AUDIO_BATCH_SIZE = 256;
+
     // output audio sample value
     double audio_sample_{0.0};
-    double audio_time_in_sys_sample_{0.0};
-    double audio_time_in_nes_clock_{0.0};
+    AudioSink *audio_sink_{nullptr};
+    std::vector<float> audio_batch_;
+    std::array<AudioSink *, APU::CHANNEL_COUNT> stem_sinks_{};
+    std::array<std::vector<float>, APU::CHANNEL_COUNT> stem_batches_;
+    std::size_t audio_batch_count_{0};
+
+    bool sampleAudio();
 
 private:
+    bool clockPlayer();
+
+    std::shared_ptr<NSF> nsf_;
+    uint8_t nsf_track_{0};
+    // PLAY schedule in 1/65536 CPU clocks
+    uint64_t nsf_play_period_{0};
+    uint64_t nsf_next_play_{0};
+
+private:
+    // declared first, the devices are constructed on top of it
+    MachineState state_{};
+    // the devices rebuild what they derive from a replaced state
+    void syncMachineState();
     CPU cpu_; // 6052 CPU
     PPU ppu_; // 2C02 PPU
     APU apu_; // 2A03 APU
-    std::array<uint8_t, 2048> cpu_ram_;
     std::shared_ptr<Cartridge> cart_;
-    // controller
-    uint8_t controller_[2];
-    uint8_t controller_state_[2];
-
-    // record elapsed clock ticks
-    uint64_t sys_clock_counter_{0};
-
-private:
-    uint8_t dma_page_{0x00};
-    uint8_t dma_addr_{0x00};
-    uint8_t dma_data_{0x00};
-
-    // DMA transfers need to be timed accurately. In principle it takes
-    // 512 cycles to read and write the 256 bytes of the OAM memory, a
-    // read followed by a write. However, the CPU needs to be on an "even"
-    // clock cycle, so a dummy cycle of idleness may be required
-    bool dma_dummy_{true};
-
-    //  flag to indicate that a DMA transfer is happening
-    bool dma_transfer_{false};
+    std::unique_ptr<PPURenderWorker> render_worker_;
 };
 } // namespace tn
 
@@ -1,6 +1,9 @@
 #ifndef TINYNES_CARTRIDGE_H
 #define TINYNES_CARTRIDGE_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string_view>
 #include <vector>
@@ -8,29 +11,118 @@ namespace tn
 {
 
 class MapperBase;
+class RomImage;
+class SaveFile;
+class StateReader;
+class StateWriter;
 class Cartridge
 {
 public:
     explicit Cartridge(std::string_view filename);
 
-    bool cpuRead(uint16_t addr, uint8_t &data);
+    // Reads go straight through the bank tables the mapper has set up, CPU $6000-$FFFF is split
+    // into five 8 KiB windows with PRG RAM in the first, PPU $0000-$1FFF into eight 1 KiB windows
+    bool cpuRead(uint16_t addr, uint8_t &data)
+    {
+        if (addr < 0x6000) {
+            return false;
+        }
+        const uint8_t *bank = prg_banks_[(addr - 0x6000) >> 13];
+        if (bank == nullptr) {
+            return false;
+        }
+        data = bank[addr & 0x1FFF];
+        return true;
+    }
+    // PRG RAM writes and mapper register writes, the latter may switch banks
     bool cpuWrite(uint16_t addr, uint8_t data);
 
-    bool ppuRead(uint16_t addr, uint8_t &data);
-    bool ppuWrite(uint16_t addr, uint8_t data);
+    bool ppuRead(uint16_t addr, uint8_t &data)
+    {
+        if (addr > 0x1FFF) {
+            return false;
+        }
+        data = chr_banks_[addr >> 10][addr & 0x03FF];
+        return true;
+    }
+    // writes to CHR ROM are ignored
+    bool ppuWrite(uint16_t addr, uint8_t data)
+    {
+        if (addr > 0x1FFF) {
+            return false;
+        }
+        if (chr_write_banks_[addr >> 10] != nullptr) {
+            chr_write_banks_[addr >> 10][addr & 0x03FF] = data;
+        }
+        return true;
+    }
 
     bool isNesFileLoaded() { return is_file_loaded_; }
 
-    void reset();
-
-public:
     enum MIRROR
     {
         HORIZONTAL,
         VERTICAL,
         ONESCREEN_LO,
         ONESCREEN_HI,
-    } mirror = HORIZONTAL;
+    };
+
+    enum class Region
+    {
+        NTSC,
+        PAL,
+        MULTIPLE,
+        DENDY,
+    };
+
+    // What the header says about the board, after corrections from the ROM database
+    struct Info
+    {
+        bool is_nes2{false};
+        bool is_database_match{false};
+        uint32_t crc{0}; // CRC32 of PRG and CHR ROM
+        uint16_t mapper{0};
+        uint8_t submapper{0};
+        uint32_t prg_rom_size{0};
+        uint32_t chr_rom_size{0};
+        uint32_t prg_ram_size{0};   // volatile
+        uint32_t prg_nvram_size{0}; // battery backed
+        uint32_t chr_ram_size{0};
+        uint32_t chr_nvram_size{0};
+        bool has_trainer{false};
+        bool has_battery{false};
+        bool is_four_screen{false};
+        MIRROR mirror{HORIZONTAL};
+        Region region{Region::NTSC};
+    };
+    const Info &info() const { return info_; }
+
+    // Header of an iNES image in memory, identified by its checksum like a loaded cartridge but
+    // without allocating anything. false if it is no iNES image or shorter than its header says.
+    static bool readInfo(const uint8_t *data, std::size_t size, Info &info);
+
+    void reset();
+
+    // Deep copy including the mapper state, used to give the render worker its own CHR memory
+    std::shared_ptr<Cartridge> clone() const;
+
+    // Mirroring, IRQ line, PRG and CHR RAM and the mapper registers. A state only fits the game
+    // it was saved from, the caller checks that before loading.
+    void saveState(StateWriter &writer) const;
+    void loadState(StateReader &reader);
+
+    // Scanline counters of MMC3 style mappers, the PPU reports A12 rising edges while rendering
+    // and the bus forwards the IRQ line to the CPU
+    bool isA12Watched() const { return is_a12_watched_; }
+    void ppuA12Rise();
+    bool isIRQ() const { return is_irq_; }
+
+    // counts the CHR bank switches that really changed a window, so cached views of the pattern
+    // tables can tell they are out of date
+    uint32_t chrMapGeneration() const { return chr_map_generation_; }
+
+public:
+    MIRROR mirror = HORIZONTAL;
 
 private:
     /**
@@ -42,11 +134,43 @@ private:
      * tile data, you'll need to use a mapper to load more data into the PPU.
      *
      * @ref NES Dev wiki - CHR ROM vs. CHR RAM : <https://www.nesdev.org/wiki/CHR_ROM_vs._CHR_RAM>
+     *
+     * ROM is read in place from the mapped file and shared by every cartridge of the same game,
+     * only the RAM belongs to this cartridge.
      */
-    std::vector<uint8_t> prg_mem_;
-    std::vector<uint8_t> chr_mem_;
+    std::shared_ptr<const RomImage> rom_;
+    const uint8_t *prg_rom_{nullptr};
+    uint32_t prg_rom_size_{0};
+    const uint8_t *chr_rom_{nullptr};
+    uint32_t chr_rom_size_{0};
+    std::vector<uint8_t> chr_ram_;
+    // PRG RAM is either the mapped save file or a private buffer
+    uint8_t *prg_ram_{nullptr};
+    uint32_t prg_ram_size_{0};
+    std::vector<uint8_t> prg_ram_buffer_;
+    std::shared_ptr<SaveFile> save_;
+    bool is_chr_ram_{false};
+    bool is_a12_watched_{false};
+    bool is_irq_{false};
+
+    // bank pointer tables, only re-pointed by the mapper on bank switches. Banks are written
+    // through their write pointer, which is null for ROM and write protected RAM.
+    static constexpr uint32_t PRG_BANK_SIZE = 8 * 1024;
+    static constexpr uint32_t CHR_BANK_SIZE = 1024;
+    std::array<const uint8_t *, 5> prg_banks_{};
+    uint8_t *prg_ram_write_{nullptr};
+    std::array<const uint8_t *, 8> chr_banks_{};
+    std::array<uint8_t *, 8> chr_write_banks_{};
+    uint32_t chr_map_generation_{0};
 
-    uint8_t mapper_id_{0};
+    friend class MapperBase;
+    // map bank 'bank', 'count' windows large, at window 'slot' of $8000-$FFFF (8 KiB windows) or
+    // of the pattern tables (1 KiB windows)
+    void mapPRG(uint8_t slot, int bank, uint8_t count);
+    void mapCHR(uint8_t slot, int bank, uint8_t count);
+    void mapPRGRAM(bool is_enable, bool is_writable);
+
+    Info info_;
     uint8_t prg_banks_num_{0};
     uint8_t chr_banks_num_{0};
 
@@ -64,6 +188,9 @@ private:
     // 4. CHR ROM data, if present (8192 * y bytes)
     // 5. PlayChoice INST-ROM, if present (0 or 8192 bytes)
     // 6. PlayChoice PROM, if present (16 bytes Data, 16 bytes CounterOut)
+    //
+    // NES Dev wiki - NES 2.0: https://www.nesdev.org/wiki/NES_2.0
+    // NES 2.0 is marked by bits 2-3 of byte 7 being 0b10 and gives bytes 8-15 a new meaning.
     struct INESHeader
     {
         uint8_t magic_name[4];
@@ -71,17 +198,22 @@ private:
         uint8_t chr_rom_size; // 8 KB units
         uint8_t mapper1;
         uint8_t mapper2;
-        uint8_t prg_ram_size;
-        uint8_t tv_system1;
-        uint8_t tv_system2;
-        uint8_t unused[5];
-    } header_; // 16 bytes
+        // iNES:    PRG RAM size, TV system, TV system and PRG RAM presence, 5 unused bytes
+        // NES 2.0: mapper MSB and submapper, ROM size MSB, PRG RAM shifts, CHR RAM shifts,
+        //          CPU/PPU timing, system type, miscellaneous ROMs, default expansion device
+        uint8_t ext[8];
+    }; // 16 bytes
 
-    enum class INESFileFormat
+    // everything readInfo() does but the checksum and the database lookup, false if the header
+    // is invalid or the file shorter than it says
+    static bool readHeader(const uint8_t *data, std::size_t size, Info &info);
+    static std::size_t romOffset(const Info &info)
     {
-        iNES1d0,
-        NES2d0,
-    };
+        return sizeof(INESHeader) + (info.has_trainer ? 512 : 0);
+    }
+    static void parseINES(const INESHeader &header, Info &info);
+    static void parseNES2(const INESHeader &header, Info &info);
+    static void applyDatabase(Info &info);
 };
 
 }; // namespace tn
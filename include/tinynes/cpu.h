@@ -1,7 +1,9 @@
 #ifndef TINYNES_CPU_H
 #define TINYNES_CPU_H
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 #include <map>
@@ -25,6 +27,34 @@ class CPU
 public:
     using ASMMap = std::map<uint16_t, std::string>;
 
+    struct Reg
+    {
+        uint8_t a{0x00};      // accumulator
+        uint8_t x{0x00};      // index X
+        uint8_t y{0x00};      // index y
+        uint8_t st{0x00};     // stack pointer
+        uint16_t pc{0x000};   // program counter
+        uint8_t status{0x00}; // status register
+    };
+
+    // Everything the CPU changes while running, plain data so that it can live in MachineState
+    struct State
+    {
+        Reg reg;
+        uint8_t fetched{0x00};     // Represents the working input value to the ALU
+        uint8_t opcode{0x00};      // Is the instruction byte
+        uint8_t cycles{0};         // Counts how many cycles the instruction has remaining
+        uint16_t temp{0x0000};     // A convenience variable used everywhere
+        uint16_t addr_abs{0x0000}; // All used memory addresses end up in here
+        uint16_t addr_rel{0x00};   // Represents absolute address following a branch
+        uint32_t clock_count{0};   // A global accumulation of the number of clocks
+    };
+
+    // The state lives in 'state' if given, the bus passes its MachineState
+    explicit CPU(State *state = nullptr);
+    CPU(const CPU &) = delete;
+    CPU &operator=(const CPU &) = delete;
+
     void connectBus(Bus *b) { bus_ = b; }
 
     // External event functions.
@@ -32,18 +62,21 @@ public:
     void irq();   // Interrupt Request - Executes an instruction at a specific location
     void nmi();   // Non-Maskable Interrupt Request - As above, but cannot be disabled
     void clock();
+    // Enter a subroutine as if a JSR at return_addr - 3 had called it, with A and X preloaded.
+    // The NSF player runs the INIT and PLAY routines of a tune this way.
+    void call(uint16_t addr, uint16_t return_addr, uint8_t a, uint8_t x);
 
     bool complete(); // Instruction complete
     void disassemble(uint16_t addr_begin, uint16_t addr_end, ASMMap &asm_map);
 
 public:
     // reg access
-    uint8_t a() const { return reg_.a; };
-    uint8_t x() const { return reg_.x; };
-    uint8_t y() const { return reg_.y; };
-    uint8_t st() const { return reg_.st; };
-    uint16_t pc() const { return reg_.pc; };
-    uint8_t status() const { return reg_.status; }
+    uint8_t a() const { return state_->reg.a; };
+    uint8_t x() const { return state_->reg.x; };
+    uint8_t y() const { return state_->reg.y; };
+    uint8_t st() const { return state_->reg.st; };
+    uint16_t pc() const { return state_->reg.pc; };
+    uint8_t status() const { return state_->reg.status; }
 
     /// @ref status flags <https://www.nesdev.org/wiki/Status_flags>
     enum FLAGS6502
@@ -58,18 +91,11 @@ public:
         N = (1 << 7), // Negative
     };
 
-    bool checkFlag(FLAGS6502 flag) const { return (reg_.status & flag) != 0; }
+    bool checkFlag(FLAGS6502 flag) const { return (state_->reg.status & flag) != 0; }
 
 private:
-    struct Reg
-    {
-        uint8_t a{0x00};      // accumulator
-        uint8_t x{0x00};      // index X
-        uint8_t y{0x00};      // index y
-        uint8_t st{0x00};     // stack pointer
-        uint16_t pc{0x000};   // program counter
-        uint8_t status{0x00}; // status register
-    } reg_;
+    State *state_{nullptr};
+    std::unique_ptr<State> own_state_;
 
     bool getFlag(FLAGS6502 f);
     void setFlag(FLAGS6502 f, bool v);
@@ -82,14 +108,6 @@ private:
     uint8_t fetch();
 
 private:
-    uint8_t fetched_{0x00};     // Represents the working input value to the ALU
-    uint16_t temp_{0x0000};     // A convenience variable used everywhere
-    uint16_t addr_abs_{0x0000}; // All used memory addresses end up in here
-    uint16_t addr_rel_{0x00};   // Represents absolute address following a branch
-    uint8_t opcode_{0x00};      // Is the instruction byte
-    uint8_t cycles_{0};         // Counts how many cycles the instruction has remaining
-    uint32_t clock_count_{0};   // A global accumulation of the number of clocks
-
     // R650X, R651X data sheet introduces this instruction set opcode matrix
     struct Instruction
     {
@@ -316,11 +316,9 @@ public:
         nes_->cpu().reset();
     }
 
-    void loadCartridge()
+    // any game of the library, e.g. a RomLibrary entry or nesfiles/nestest.nes
+    void loadCartridge(const std::string &file_path = ROOT_DIR + "/nesfiles/smb.nes")
     {
-        // std::string file_path = ROOT_DIR + "/nesfiles/nestest.nes";
-        // std::string file_path = ROOT_DIR + "/nesfiles/donkey_kong.nes";
-        std::string file_path = ROOT_DIR + "/nesfiles/smb.nes";
         cart_ = std::make_shared<tn::Cartridge>(file_path);
         if (!cart_->isNesFileLoaded()) {
             spdlog::error("{} complains it cannot load {}", __func__, file_path);
@@ -0,0 +1,62 @@
+#ifndef TINYNES_MACHINE_STATE_H
+#define TINYNES_MACHINE_STATE_H
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#include "tinynes/apu.h"
+#include "tinynes/cpu.h"
+#include "tinynes/ppu.h"
+
+namespace tn
+{
+
+// What the bus itself keeps between two clocks
+struct BusState
+{
+    std::array<uint8_t, 2048> cpu_ram{};
+    // controller
+    std::array<uint8_t, 2> controller{};
+    std::array<uint8_t, 2> controller_state{};
+
+    // record elapsed clock ticks
+    uint64_t sys_clock_counter{0};
+    // CPU clocks since power on, the time base of the lazily clocked APU
+    uint64_t cpu_clock_counter{0};
+
+    uint8_t dma_page{0x00};
+    uint8_t dma_addr{0x00};
+    uint8_t dma_data{0x00};
+
+    // DMA transfers need to be timed accurately. In principle it takes
+    // 512 cycles to read and write the 256 bytes of the OAM memory, a
+    // read followed by a write. However, the CPU needs to be on an "even"
+    // clock cycle, so a dummy cycle of idleness may be required
+    bool dma_dummy{true};
+
+    //  flag to indicate that a DMA transfer is happening
+    bool dma_transfer{false};
+};
+
+/**
+ * The whole state of the console in one block of plain data: the devices on the bus only hold a
+ * pointer to their part of it. Taking a snapshot is a single copy, and so is restoring one before
+ * the devices resync what they derive from it (mirroring pages, sprite buckets, mixer level).
+ *
+ * The cartridge is not part of it, its RAM and mapper registers vary in size from board to board
+ * and battery-backed PRG RAM lives in the mapped save file.
+ */
+struct MachineState
+{
+    // each device on its own cache lines, they are clocked in turns
+    alignas(64) CPU::State cpu;
+    alignas(64) BusState bus;
+    alignas(64) PPU::State ppu;
+    alignas(64) APU::State apu;
+};
+static_assert(std::is_trivially_copyable_v<MachineState>, "MachineState must be plain data");
+
+} // namespace tn
+
+#endif
@@ -2,33 +2,79 @@
 #define TINYNES_MAPPER_BASE_H
 
 #include <cstdint>
+#include <memory>
+
+#include "tinynes/cartridge.h"
+#include "tinynes/state_stream.h"
 
 namespace tn
 {
 
+/**
+ * Mappers only act on bank switch events. The cartridge reads and writes through tables of
+ * 8 KiB PRG and 1 KiB CHR bank pointers without asking the mapper, a mapper re-points those
+ * tables when one of its registers is written, which is the only virtual call left on the bus.
+ *
+ * A mapper keeps its bank registers and derives every pointer from them in updateBanks(), so a
+ * copy of the mapper can be attached to a copy of the cartridge.
+ */
 class MapperBase
 {
 public:
     MapperBase(uint8_t prg_banks, uint8_t chr_banks)
-        : prg_banks_num(prg_banks), chr_banks_num(chr_banks)
+        : prg_banks_num(prg_banks), chr_banks_num(chr_banks){};
+    virtual ~MapperBase() = default;
+
+    // point the bank tables of 'cart' at its memory according to the current registers
+    void attach(Cartridge *cart)
     {
-        reset();
-    };
+        cart_ = cart;
+        cart_->is_a12_watched_ = isA12Watched();
+        updateBanks();
+    }
+
+    // CPU write to $8000-$FFFF
+    virtual void cpuWriteRegister(uint16_t addr, uint8_t data) = 0;
+
+    // Rising edge of PPU A12 that passed the M2 filter, MMC3 style scanline counters are clocked
+    // by it. The PPU only reports edges to mappers which watch A12.
+    virtual bool isA12Watched() const { return false; }
+    virtual void ppuA12Rise() {}
 
-    // Transform CPU bus address into PRG ROM offset
-    virtual bool cpuMapRead(uint16_t addr, uint32_t &mapped_addr) = 0;
-    virtual bool cpuMapWrite(uint16_t addr, uint32_t &mapped_addr, uint8_t data) = 0;
+    // power-on state of the registers
+    virtual void reset() { updateBanks(); }
 
-    // Transform PPU bus address into CHR ROM offset
-    virtual bool ppuMapRead(uint16_t addr, uint32_t &mapped_addr) = 0;
-    virtual bool ppuMapWrite(uint16_t addr, uint32_t &mapped_addr) = 0;
+    // Copy of the mapper including its current bank registers, attach() it before use
+    virtual std::shared_ptr<MapperBase> clone() const = 0;
 
-    virtual void reset() {}
+    // Bank and IRQ registers for save states, loadState() is followed by attach()
+    virtual void saveState([[maybe_unused]] StateWriter &writer) const {}
+    virtual void loadState([[maybe_unused]] StateReader &reader) {}
 
 protected:
-    uint8_t prg_banks_num{0};
-    uint8_t chr_banks_num{0};
+    virtual void updateBanks() = 0;
+
+    // Bank numbers are in units of the window size and wrap around the available memory,
+    // negative numbers count from the last bank
+    void mapPRG8K(uint8_t slot, int bank) { cart_->mapPRG(slot, bank, 1); }
+    void mapPRG16K(uint8_t slot, int bank) { cart_->mapPRG(slot * 2, bank, 2); }
+    void mapPRG32K(int bank) { cart_->mapPRG(0, bank, 4); }
+    void mapCHR1K(uint8_t slot, int bank) { cart_->mapCHR(slot, bank, 1); }
+    void mapCHR2K(uint8_t slot, int bank) { cart_->mapCHR(slot * 2, bank, 2); }
+    void mapCHR4K(uint8_t slot, int bank) { cart_->mapCHR(slot * 4, bank, 4); }
+    void mapCHR8K(int bank) { cart_->mapCHR(0, bank, 8); }
+    void mapPRGRAM(bool is_enable, bool is_writable) { cart_->mapPRGRAM(is_enable, is_writable); }
+    void setMirror(Cartridge::MIRROR mirror) { cart_->mirror = mirror; }
+    // level of the cartridge IRQ line, it stays asserted until the mapper acknowledges it
+    void setIRQ(bool is_irq) { cart_->is_irq_ = is_irq; }
+
+protected:
+    uint8_t prg_banks_num{0}; // 16 KiB units
+    uint8_t chr_banks_num{0}; // 8 KiB units, 0 means 8 KiB of CHR RAM
+
+private:
+    Cartridge *cart_{nullptr};
 };
 } // namespace tn
 
-#endif
\ No newline at end of file
+#endif
@@ -25,13 +25,19 @@ public:
     //
     //  No mapping for PPU!!!
 
-    bool cpuMapRead(uint16_t addr, uint32_t &mapped_addr) override;
-    bool cpuMapWrite(uint16_t addr, uint32_t &mapped_addr, uint8_t data) override;
-    bool ppuMapRead(uint16_t addr, uint32_t &mapped_addr) override;
-    bool ppuMapWrite(uint16_t addr, uint32_t &mapped_addr) override;
-    void reset() override;
+    // no registers, the banks never move
+    void cpuWriteRegister([[maybe_unused]] uint16_t addr, [[maybe_unused]] uint8_t data) override
+    {
+    }
+    std::shared_ptr<MapperBase> clone() const override
+    {
+        return std::make_shared<Mapper000>(*this);
+    }
+
+protected:
+    void updateBanks() override;
 };
 
 } // namespace tn
 
-#endif
\ No newline at end of file
+#endif
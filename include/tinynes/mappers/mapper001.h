@@ -0,0 +1,66 @@
+#ifndef TINYNES_MAPPERS_MAPPER001_H
+#define TINYNES_MAPPERS_MAPPER001_H
+
+#include "tinynes/mapper_base.h"
+namespace tn
+{
+
+class Mapper001 : public MapperBase
+{
+public:
+    Mapper001(uint8_t prg_banks, uint8_t chr_banks) : MapperBase(prg_banks, chr_banks){};
+    virtual ~Mapper001() = default;
+    // NES Dev wiki - MMC1: <https://www.nesdev.org/wiki/MMC1>
+    //
+    // PRG ROM capacity: 256 KiB (512 KiB on SUROM)
+    // PRG RAM capacity: 8 KiB
+    // CHR capacity: 128 KiB ROM or 8 KiB RAM
+    //
+    //  Registers are loaded serially, one bit per write to $8000-$FFFF starting with bit 0. The
+    //  fifth write copies the shift register to the register selected by bits 13-14 of its
+    //  address, a write with bit 7 set clears the shift register instead.
+    //
+    //  - CPU $6000-$7FFF: 8 KiB PRG RAM bank
+    //  - CPU $8000-$BFFF: 16 KiB PRG ROM bank, either switchable or fixed to the first bank
+    //  - CPU $C000-$FFFF: 16 KiB PRG ROM bank, either fixed to the last bank or switchable
+    //  - PPU $0000-$0FFF: 4 KiB switchable CHR bank
+    //  - PPU $1000-$1FFF: 4 KiB switchable CHR bank
+    //
+    //  [Control ($8000-$9FFF)]   CPPMM
+    //                            |||++- Mirroring (0: one-screen, lower bank; 1: one-screen,
+    //                            |||               upper bank; 2: vertical; 3: horizontal)
+    //                            |++--- PRG ROM bank mode (0, 1: switch 32 KiB at $8000;
+    //                            |                         2: fix first bank at $8000;
+    //                            |                         3: fix last bank at $C000)
+    //                            +----- CHR ROM bank mode (0: switch 8 KiB; 1: switch two 4 KiB)
+    //  [CHR bank 0 ($A000-$BFFF)]
+    //  [CHR bank 1 ($C000-$DFFF)], ignored in 8 KiB mode
+    //  [PRG bank ($E000-$FFFF)]  RPPPP, R disables PRG RAM
+    //
+    //  SUROM uses bit 4 of the CHR bank registers to select the 256 KiB half of PRG ROM.
+
+    void cpuWriteRegister(uint16_t addr, uint8_t data) override;
+    void reset() override;
+    std::shared_ptr<MapperBase> clone() const override
+    {
+        return std::make_shared<Mapper001>(*this);
+    }
+    void saveState(StateWriter &writer) const override;
+    void loadState(StateReader &reader) override;
+
+protected:
+    void updateBanks() override;
+
+private:
+    // bit 4 is a marker which reaches bit 0 once four bits have been shifted in
+    static constexpr uint8_t SHIFT_RESET = 0x10;
+
+    uint8_t shift_{SHIFT_RESET};
+    uint8_t control_{0x0C};
+    uint8_t chr_bank_[2]{0, 0};
+    uint8_t prg_bank_{0};
+};
+
+} // namespace tn
+
+#endif
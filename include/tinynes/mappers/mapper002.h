@@ -0,0 +1,42 @@
+#ifndef TINYNES_MAPPERS_MAPPER002_H
+#define TINYNES_MAPPERS_MAPPER002_H
+
+#include "tinynes/mapper_base.h"
+namespace tn
+{
+
+class Mapper002 : public MapperBase
+{
+public:
+    Mapper002(uint8_t prg_banks, uint8_t chr_banks) : MapperBase(prg_banks, chr_banks){};
+    virtual ~Mapper002() = default;
+    // NES Dev wiki - UxROM: <https://www.nesdev.org/wiki/UxROM>
+    //
+    // PRG ROM capacity: 256 KiB (UNROM) or 4 MiB with oversized banks
+    // PRG RAM: none
+    // CHR capacity: 8 KiB RAM
+    //
+    //  - CPU $8000-$BFFF: 16 KiB switchable PRG ROM bank
+    //  - CPU $C000-$FFFF: 16 KiB PRG ROM bank, fixed to the last bank
+    //
+    //  [Bank select ($8000-$FFFF)]  bank number of $8000-$BFFF
+
+    void cpuWriteRegister(uint16_t addr, uint8_t data) override;
+    void reset() override;
+    std::shared_ptr<MapperBase> clone() const override
+    {
+        return std::make_shared<Mapper002>(*this);
+    }
+    void saveState(StateWriter &writer) const override;
+    void loadState(StateReader &reader) override;
+
+protected:
+    void updateBanks() override;
+
+private:
+    uint8_t prg_bank_{0};
+};
+
+} // namespace tn
+
+#endif
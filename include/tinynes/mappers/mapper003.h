@@ -0,0 +1,42 @@
+#ifndef TINYNES_MAPPERS_MAPPER003_H
+#define TINYNES_MAPPERS_MAPPER003_H
+
+#include "tinynes/mapper_base.h"
+namespace tn
+{
+
+class Mapper003 : public MapperBase
+{
+public:
+    Mapper003(uint8_t prg_banks, uint8_t chr_banks) : MapperBase(prg_banks, chr_banks){};
+    virtual ~Mapper003() = default;
+    // NES Dev wiki - CNROM: <https://www.nesdev.org/wiki/CNROM>
+    //
+    // PRG ROM size: 16 KiB or 32 KiB, not bankswitched
+    // PRG RAM: none
+    // CHR capacity: 32 KiB ROM (2 MiB with oversized banks)
+    //
+    //  - CPU $8000-$FFFF: fixed PRG ROM, mirrored like NROM-128 when only 16 KiB
+    //  - PPU $0000-$1FFF: 8 KiB switchable CHR ROM bank
+    //
+    //  [Bank select ($8000-$FFFF)]  bank number of $0000-$1FFF
+
+    void cpuWriteRegister(uint16_t addr, uint8_t data) override;
+    void reset() override;
+    std::shared_ptr<MapperBase> clone() const override
+    {
+        return std::make_shared<Mapper003>(*this);
+    }
+    void saveState(StateWriter &writer) const override;
+    void loadState(StateReader &reader) override;
+
+protected:
+    void updateBanks() override;
+
+private:
+    uint8_t chr_bank_{0};
+};
+
+} // namespace tn
+
+#endif
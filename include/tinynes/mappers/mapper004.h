@@ -0,0 +1,82 @@
+#ifndef TINYNES_MAPPERS_MAPPER004_H
+#define TINYNES_MAPPERS_MAPPER004_H
+
+#include "tinynes/mapper_base.h"
+namespace tn
+{
+
+class Mapper004 : public MapperBase
+{
+public:
+    Mapper004(uint8_t prg_banks, uint8_t chr_banks) : MapperBase(prg_banks, chr_banks){};
+    virtual ~Mapper004() = default;
+    // NES Dev wiki - MMC3: <https://www.nesdev.org/wiki/MMC3>
+    //
+    // PRG ROM capacity: 512 KiB
+    // PRG RAM capacity: 8 KiB
+    // CHR capacity: 256 KiB
+    //
+    //  - CPU $6000-$7FFF: 8 KiB PRG RAM bank
+    //  - CPU $8000-$9FFF (or $C000-$DFFF): 8 KiB switchable PRG ROM bank
+    //  - CPU $A000-$BFFF: 8 KiB switchable PRG ROM bank
+    //  - CPU $C000-$DFFF (or $8000-$9FFF): 8 KiB PRG ROM bank, fixed to the second-last bank
+    //  - CPU $E000-$FFFF: 8 KiB PRG ROM bank, fixed to the last bank
+    //  - PPU $0000-$07FF (or $1000-$17FF): 2 KiB switchable CHR bank
+    //  - PPU $0800-$0FFF (or $1800-$1FFF): 2 KiB switchable CHR bank
+    //  - PPU $1000-$13FF (or $0000-$03FF): 1 KiB switchable CHR bank
+    //  - PPU $1400-$17FF (or $0400-$07FF): 1 KiB switchable CHR bank
+    //  - PPU $1800-$1BFF (or $0800-$0BFF): 1 KiB switchable CHR bank
+    //  - PPU $1C00-$1FFF (or $0C00-$0FFF): 1 KiB switchable CHR bank
+    //
+    //  Each register pair is selected by bits 13-14 and bit 0 of the address:
+    //
+    //  [Bank select ($8000-$9FFE, even)]     CPMx xRRR
+    //                                        |||   +++- bank register to update on the next write
+    //                                        ||+------- nothing on the MMC3
+    //                                        |+-------- PRG ROM bank mode
+    //                                        +--------- CHR A12 inversion
+    //  [Bank data ($8001-$9FFF, odd)]        new value of the selected bank register
+    //  [Mirroring ($A000-$BFFE, even)]       0: vertical; 1: horizontal
+    //  [PRG RAM protect ($A001-$BFFF, odd)]  RW, R enables the chip, W denies writes
+    //  [IRQ latch ($C000-$DFFE, even)]       reload value of the scanline counter
+    //  [IRQ reload ($C001-$DFFF, odd)]       reloads the counter on the next A12 rising edge
+    //  [IRQ disable ($E000-$FFFE, even)]     also acknowledges a pending IRQ
+    //  [IRQ enable ($E001-$FFFF, odd)]
+    //
+    //  NES Dev wiki - MMC3 scanline counter: <https://www.nesdev.org/wiki/MMC3#IRQ_Specifics>
+    //  The counter is clocked on each rising edge of PPU A12 that follows at least three falling
+    //  edges of M2 with A12 low. With the standard setup of background tiles at $0000 and sprites
+    //  at $1000 this happens once per rendered scanline, when the sprite tiles are fetched.
+
+    void cpuWriteRegister(uint16_t addr, uint8_t data) override;
+    bool isA12Watched() const override { return true; }
+    void ppuA12Rise() override;
+    void reset() override;
+    std::shared_ptr<MapperBase> clone() const override
+    {
+        return std::make_shared<Mapper004>(*this);
+    }
+    void saveState(StateWriter &writer) const override;
+    void loadState(StateReader &reader) override;
+
+protected:
+    void updateBanks() override;
+
+private:
+    void updatePRGBanks();
+    void updateCHRBanks();
+
+private:
+    uint8_t bank_select_{0};
+    uint8_t registers_[8]{0, 2, 4, 5, 6, 7, 0, 1};
+    uint8_t prg_ram_protect_{0x80};
+
+    uint8_t irq_latch_{0};
+    uint8_t irq_counter_{0};
+    bool is_irq_reload_{false};
+    bool is_irq_enable_{false};
+};
+
+} // namespace tn
+
+#endif
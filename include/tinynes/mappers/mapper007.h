@@ -0,0 +1,44 @@
+#ifndef TINYNES_MAPPERS_MAPPER007_H
+#define TINYNES_MAPPERS_MAPPER007_H
+
+#include "tinynes/mapper_base.h"
+namespace tn
+{
+
+class Mapper007 : public MapperBase
+{
+public:
+    Mapper007(uint8_t prg_banks, uint8_t chr_banks) : MapperBase(prg_banks, chr_banks){};
+    virtual ~Mapper007() = default;
+    // NES Dev wiki - AxROM: <https://www.nesdev.org/wiki/AxROM>
+    //
+    // PRG ROM capacity: 256 KiB
+    // PRG RAM: none
+    // CHR capacity: 8 KiB RAM
+    //
+    //  - CPU $8000-$FFFF: 32 KiB switchable PRG ROM bank
+    //  - PPU $2000-$2FFF: one-screen mirroring, the nametable is selectable
+    //
+    //  [Bank select ($8000-$FFFF)]  ---M -PPP
+    //                                  |  +++- 32 KiB PRG ROM bank
+    //                                  +------ one-screen nametable (0: lower; 1: upper)
+
+    void cpuWriteRegister(uint16_t addr, uint8_t data) override;
+    void reset() override;
+    std::shared_ptr<MapperBase> clone() const override
+    {
+        return std::make_shared<Mapper007>(*this);
+    }
+    void saveState(StateWriter &writer) const override;
+    void loadState(StateReader &reader) override;
+
+protected:
+    void updateBanks() override;
+
+private:
+    uint8_t select_{0};
+};
+
+} // namespace tn
+
+#endif
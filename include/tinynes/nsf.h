@@ -0,0 +1,93 @@
+#ifndef TINYNES_NSF_H
+#define TINYNES_NSF_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tn
+{
+
+/**
+ * NES Sound Format music file, the counterpart of Cartridge for the player mode of the bus.
+ *
+ * An NSF holds the sound driver and music data ripped from a game together with two entry points:
+ * INIT sets up a track and PLAY advances it by one tick. The file image is mapped at $8000-$FFFF,
+ * optionally switched in 4 KiB banks through $5FF8-$5FFF, and $6000-$7FFF is work RAM.
+ *
+ * The player parks the CPU on a tiny idle loop at IDLE_ADDR whenever a routine has returned.
+ *
+ * @ref NES Dev wiki - NSF: <https://www.nesdev.org/wiki/NSF>
+ */
+class NSF
+{
+public:
+    // JMP $4100, in the unmapped part of the I/O range
+    static constexpr uint16_t IDLE_ADDR = 0x4100;
+    static constexpr uint32_t DEFAULT_PLAY_PERIOD_US = 16639;
+
+public:
+    explicit NSF(std::string_view filename);
+
+    bool cpuRead(uint16_t addr, uint8_t &data);
+    bool cpuWrite(uint16_t addr, uint8_t data);
+
+    bool isNsfFileLoaded() const { return is_file_loaded_; }
+
+    // initial banks and cleared work RAM, done before INIT of every track
+    void reset();
+
+public:
+    uint8_t totalSongs() const { return header_.total_songs; }
+    // 0-based, as passed to INIT
+    uint8_t startingSong() const
+    {
+        return header_.starting_song > 0 ? header_.starting_song - 1 : 0;
+    }
+    uint16_t initAddr() const { return header_.init_addr; }
+    uint16_t playAddr() const { return header_.play_addr; }
+    // NTSC rate of the PLAY calls
+    uint32_t playPeriodUs() const;
+
+    std::string title() const { return field(header_.song_name); }
+    std::string artist() const { return field(header_.artist_name); }
+    std::string copyright() const { return field(header_.copyright_name); }
+
+private:
+    static std::string field(const uint8_t (&text)[32]);
+
+private:
+    // 128 bytes, all words are little endian
+    struct NSFHeader
+    {
+        uint8_t magic_name[5]; // "NESM\x1A"
+        uint8_t version;
+        uint8_t total_songs;
+        uint8_t starting_song; // 1-based
+        uint16_t load_addr;
+        uint16_t init_addr;
+        uint16_t play_addr;
+        uint8_t song_name[32];
+        uint8_t artist_name[32];
+        uint8_t copyright_name[32];
+        uint16_t ntsc_speed; // microseconds between PLAY calls
+        uint8_t bank_init[8];
+        uint16_t pal_speed;
+        uint8_t tv_system;
+        uint8_t sound_chips; // expansion audio, not emulated
+        uint8_t reserved[4];
+    } header_;
+
+    // file data placed at its load address, padded to whole 4 KiB banks
+    std::vector<uint8_t> prg_mem_;
+    std::array<uint8_t, 8> banks_{};
+    std::array<uint8_t, 8 * 1024> wram_{};
+    bool is_bank_switched_{false};
+    bool is_file_loaded_{false};
+};
+
+} // namespace tn
+
+#endif
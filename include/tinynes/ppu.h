@@ -3,14 +3,17 @@
 
 #include <SFML/Graphics/Color.hpp>
 #include "tinynes/cartridge.h"
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace tn
 {
 
 class Cartridge;
 class VScreen;
+class PPURenderWorker;
 
 /**
  * PPU also has its own memory map, NES Dev wiki provides
@@ -20,7 +23,12 @@ class VScreen;
 class PPU
 {
 public:
-    PPU();
+    struct State;
+
+    // The state lives in 'state' if given, the bus passes its MachineState
+    explicit PPU(State *state = nullptr);
+    PPU(const PPU &) = delete;
+    PPU &operator=(const PPU &) = delete;
 
     uint8_t cpuRead(uint16_t addr, bool read_only = false);
     void cpuWrite(uint16_t addr, uint8_t data);
@@ -28,29 +36,116 @@ public:
     uint8_t ppuRead(uint16_t addr, bool read_only = false);
     void ppuWrite(uint16_t addr, uint8_t data);
 
-    auto vScreenMain() { return vscreen_main_; }
-    auto vScreenNameTable(uint8_t idx) { return vscreen_name_table_[idx]; }
+    std::shared_ptr<VScreen> vScreenMain();
+
+    // Debug views. Their screens are allocated on first use and only redrawn when the PPU memory
+    // they show has been modified since the last call, so they cost nothing unless someone looks.
     std::shared_ptr<VScreen> vScreenPatternTable(uint8_t idx, uint8_t palette);
-    auto oam() { return oam_ptr_; }
+    std::shared_ptr<VScreen> vScreenNameTable(uint8_t idx);
+    std::shared_ptr<VScreen> vScreenPalette();
+    std::shared_ptr<VScreen> vScreenSprites();
+    const uint8_t *oam() const { return reinterpret_cast<const uint8_t *>(state_->oam); }
+    void oamWrite(uint8_t addr, uint8_t data); // OAM DMA
+
+    bool getFrameState() { return state_->frame_complete; }
+    void setFrameState(bool status) { state_->frame_complete = status; }
 
-    bool getFrameState() { return frame_complete_; }
-    void setFrameState(bool status) { frame_complete_ = status; }
+    // Frame skipping keeps every register, scroll, vblank, sprite evaluation and sprite zero hit
+    // behaviour intact, only the pixels of skipped frames are never composed, so the main screen
+    // keeps showing the last rendered frame.
+    // - setFrameSkip(n): render one frame, then skip the next n frames (0 renders all of them)
+    // - setAdaptiveFrameSkip(): skip up to 'max_skip' frames in a row whenever the host falls
+    //   behind real time
+    void setFrameSkip(uint8_t frames);
+    void setAdaptiveFrameSkip(bool enable, uint8_t max_skip = 4);
+    bool isFrameRendered() const { return is_frame_rendered_; }
+    // Whether the next frame is composed, set between two frames. A frame skip setting or a
+    // render worker overrides it at the end of each frame.
+    void setFrameRendered(bool is_rendered) { is_frame_rendered_ = is_rendered; }
+
+    // Position of the next dot to be processed, counted from the start of the pre-render line
+    uint32_t dot() const { return (state_->scanline + 1) * 341 + state_->cycle; }
+
+    /**
+     * Events recorded for the render worker. Everything the CPU does that can change what the PPU
+     * draws passes through cpuRead/cpuWrite, the OAM DMA or a cartridge register write, so
+     * replaying those at the same dot on a copy of the PPU yields the same picture.
+     */
+    struct RenderEvent
+    {
+        enum Type : uint8_t
+        {
+            REG_READ,   // PPU register read with side effects ($2002, $2007)
+            REG_WRITE,  // PPU register write
+            OAM_WRITE,  // OAM DMA byte
+            CART_WRITE, // cartridge register write, e.g. CHR bank switch or mirroring
+            RESET,
+        };
+        uint32_t dot;
+        Type type;
+        uint8_t data;
+        uint16_t addr;
+    };
+
+    void attachRenderWorker(PPURenderWorker *worker);
+    void logCartridgeWrite(uint16_t addr, uint8_t data)
+    {
+        if (render_worker_ != nullptr) {
+            logRenderEvent(RenderEvent::CART_WRITE, addr, data);
+        }
+    }
+    // Copy of this PPU with its own framebuffer, reading CHR through 'cartridge'
+    std::unique_ptr<PPU> cloneForRendering(const std::shared_ptr<Cartridge> &cartridge) const;
+    // takes over the state of 'ppu', keeping this PPU's cartridge and framebuffer
+    void copyStateFrom(const PPU &ppu);
+    void replayRenderEvent(const RenderEvent &event);
+    void swapMainScreen(std::shared_ptr<VScreen> &screen) { vscreen_main_.swap(screen); }
 
 public:
     // PPU system interfaces
     void connectCartridge(const std::shared_ptr<Cartridge> &cartridge);
+    // Mappers may switch the nametable mirroring at runtime, so the bus calls this after every
+    // cartridge register write. The page table is only rebuilt if the mode really changed.
+    void syncMirroring()
+    {
+        if (cart_->mirror != mirror_) {
+            updateMirroring();
+        }
+    }
     void reset();
     void clock();
-    bool nmi{false};
+    // rebuilds what is derived from the state, after the state has been overwritten as a whole
+    void syncState();
+    // set at the start of vertical blank when enabled, the bus forwards it to the CPU
+    bool isNMI() const { return state_->nmi; }
+    void clearNMI() { state_->nmi = false; }
 
 private:
     sf::Color getColorFromPaletteMemory(uint8_t palette, uint8_t pixel);
+    uint8_t getDebugColorIndex(uint8_t palette, uint8_t pixel);
+    void drawScrollWindow(uint8_t idx, bool restore);
+    void rebuildSpriteBuckets();
+    void updateMirroring();
+    void storeOAM(uint8_t addr, uint8_t data);
+    void logRenderEvent(RenderEvent::Type type, uint16_t addr, uint8_t data);
+    void setSpriteZeroHit();
+    void decideFrameSkip();
+    bool isLineRendered(bool is_line_start);
+    void checkA12Rise();
 
 private:
     std::shared_ptr<Cartridge> cart_;
-    bool frame_complete_{false};
-    int32_t scanline_{0};
-    int32_t cycle_{0};
+
+    // frame skipping
+    bool is_frame_rendered_{true};
+    bool is_adaptive_frame_skip_{false};
+    uint8_t frame_skip_{0};
+    uint8_t max_frame_skip_{4};
+    uint8_t frame_skip_count_{0};
+    std::chrono::steady_clock::time_point frame_deadline_;
+
+    // composition is offloaded to this worker when attached
+    PPURenderWorker *render_worker_{nullptr};
 
     // <https://www.nesdev.org/wiki/PPU_registers#PPUCTRL>
     union PPUCTRL // $2000, write
@@ -69,7 +164,7 @@ private:
             uint8_t enable_nmi : 1; // NMI at the start of vertical blanking interval(0: off 1: on)
         };
         uint8_t reg;
-    } control_;
+    };
 
     union PPUMASK // $2001, write
     {
@@ -86,7 +181,7 @@ private:
         };
         uint8_t reg;
 
-    } mask_;
+    };
 
     union PPUSTATUS // $2002, read
     {
@@ -98,7 +193,7 @@ private:
             uint8_t vertical_blank : 1;
         };
         uint8_t reg;
-    } status_;
+    };
 
     // NES Dev wiki - PPU scrolling: https://www.nesdev.org/wiki/PPU_scrolling
     //
@@ -136,37 +231,6 @@ private:
         uint16_t reg{0x0000};
     };
 
-    // PPU internal registers
-    // NES Dev wiki - PPU scrolling, Register controls: <https://www.nesdev.org/wiki/PPU_scrolling>
-    // tells how to use the v,t,x,w registers
-    LoopyRegister vram_addr_;
-    LoopyRegister tram_addr_;
-    uint8_t fine_x_{0};
-
-    // assistant variables used in PPU registers access
-    /**
-     * PPUADDR
-     * Address ($2006) >> write x2
-     *
-     * The CPU writes to VRAM through a pair of registers on the PPU by first loading an address
-     * into PPUADDR and then it writing data repeatedly to PPUDATA. The 16-bit address is written to
-     * PPUADDR one byte at a time, upper byte first. Whether this is the first or second write is
-     * tracked internally by the w register, which is shared with PPUSCROLL.
-     *
-     * After reading PPUSTATUS to clear w (the write latch), write the 16-bit address of VRAM you
-     * want to access here, upper byte first.
-     */
-    uint8_t address_latch_{0};
-    /**
-     * PPUDATA
-     * Data ($2007) <> read/write
-     *
-     * Note that the internal read buffer is updated only on PPUDATA reads. It is not affected by
-     * other PPU processes such as rendering, and it maintains its value indefinitely until the next
-     * read.
-     */
-    uint8_t data_buffer_{0x00};
-
     // Background rendering
     struct BGNextTile
     {
@@ -174,49 +238,13 @@ private:
         uint8_t attribute{0x00};
         uint8_t lsb{0x00};
         uint8_t msb{0x00};
-    } bg_next_tile_;
+    };
 
     struct BGShifter
     {
         uint16_t lo{0x0000};
         uint16_t hi{0x0000};
     };
-    BGShifter bg_shifter_pattern_;
-    BGShifter bg_shifter_attribute_;
-
-private:
-    std::shared_ptr<VScreen> vscreen_main_{nullptr};
-    std::shared_ptr<VScreen> vscreen_name_table_[2]{nullptr, nullptr};
-    std::shared_ptr<VScreen> vscreen_pattern_table_[2]{nullptr, nullptr};
-
-    /**
-     * The NES has four logical nametables, but the NES system board itself has only 2 KiB of VRAM,
-     * enough for two physical nametables; hardware on the cartridge controls address bit 10 of
-     * CIRAM to map one nametable on top of another.
-     *
-     * @ref NES Dev wiki - PPU nametables: https://www.nesdev.org/wiki/PPU_nametables
-     */
-    uint8_t name_table_[2][1024];
-
-    /**
-     * The pattern table is divided into two 256-tile sections: $0000-$0FFF, nicknamed "left", and
-     * $1000-$1FFF, nicknamed "right".
-     * @verbatim PPU addresses within the pattern tables can be decoded as follows:
-     *  DCBA98 76543210
-     *  ---------------
-     *  0HNNNN NNNNPyyy
-     *  |||||| |||||+++- T : Fine Y offset, the row number within a tile
-     *  |||||| ||||+---- P : Bit plane (0: less significant bit; 1: more significant bit)
-     *  ||++++-++++----- N : Tile number from name table
-     *  |+-------------- H : Half of pattern table (0: "left"; 1: "right")
-     *  +--------------- 0 : Pattern table is at $0000-$1FFF
-     * @verbatim
-     * @ref NES Dev wiki - PPU pattern tables: <https://www.nesdev.org/wiki/PPU_pattern_tables>
-     */
-    uint8_t pattern_table_[2][4096];
-
-    /* palette colors */
-    uint8_t palette_table_[32];
 
     // https://www.nesdev.org/wiki/PPU_OAM
     // Byte 0: Y position of top of sprite
@@ -246,36 +274,180 @@ private:
         uint8_t id;        // ID of tile from pattern memory
         uint8_t attribute; // Flags define how sprite should be rendered
         uint8_t x;         // X position of sprite
-    } OAM_[64];
-    uint8_t *oam_ptr_ = reinterpret_cast<uint8_t *>(OAM_);
+    };
+
+public:
+    /**
+     * Everything the PPU changes while emulating, plain data so that it can live in MachineState.
+     * The registers and shifters touched at every dot come first, the memories after them.
+     */
+    struct State
+    {
+        int32_t scanline{0};
+        int32_t cycle{0};
+        bool frame_complete{false};
+        bool nmi{false};
 
-    // A register to store the address when the CPU manually communicates
-    // with OAM via PPU registers. This is not commonly used because it
-    // is very slow, and instead a 256-Byte DMA transfer is used. See
-    // the Bus header for a description of this.
-    uint8_t oam_addr_{0x00};
+        PPUCTRL control{};
+        PPUMASK mask{};
+        PPUSTATUS status{};
 
-    // NES Dev wiki - Sprite overflow games: <https://www.nesdev.org/wiki/Sprite_overflow_games>
-    //
-    // The sprite overflow flag is rarely used, mainly due to bugs when exactly 8 sprites are
-    // present on a scanline. No games rely on the buggy behavior.
-    //
-    // Nonetheless, games can intentionally place 9 or more sprites in a scanline to trigger the
-    // overflow flag consistently, as long as no previous scanlines have exactly 8 sprites.
-    ObjectAttributeEntry sprite_per_scanline_[8];
-    uint8_t sprite_count_;
-    uint8_t sprite_shifter_pattern_lo_[8];
-    uint8_t sprite_shifter_pattern_hi_[8];
-
-    // NES Dev wiki - PPU OAM: < https : // www.nesdev.org/wiki/PPU_OAM#Sprite_0_hits>
-    //  Sprite Zero Collision Flags
-    bool sprite_zero_hit_possible_ = false;
-    bool sprite_zero_being_rendered_ = false;
-
-    // The OAM is conveniently package above to work with, but the DMA
-    // mechanism will need access to it for writing one byte at a time
+        // PPU internal registers
+        // NES Dev wiki - PPU scrolling, Register controls:
+        // <https://www.nesdev.org/wiki/PPU_scrolling> tells how to use the v,t,x,w registers
+        LoopyRegister vram_addr;
+        LoopyRegister tram_addr;
+        uint8_t fine_x{0};
+
+        // assistant variables used in PPU registers access
+        /**
+         * PPUADDR
+         * Address ($2006) >> write x2
+         *
+         * The CPU writes to VRAM through a pair of registers on the PPU by first loading an
+         * address into PPUADDR and then it writing data repeatedly to PPUDATA. The 16-bit address
+         * is written to PPUADDR one byte at a time, upper byte first. Whether this is the first or
+         * second write is tracked internally by the w register, which is shared with PPUSCROLL.
+         *
+         * After reading PPUSTATUS to clear w (the write latch), write the 16-bit address of VRAM
+         * you want to access here, upper byte first.
+         */
+        uint8_t address_latch{0};
+        /**
+         * PPUDATA
+         * Data ($2007) <> read/write
+         *
+         * Note that the internal read buffer is updated only on PPUDATA reads. It is not affected
+         * by other PPU processes such as rendering, and it maintains its value indefinitely until
+         * the next read.
+         */
+        uint8_t data_buffer{0x00};
+
+        BGNextTile bg_next_tile;
+        BGShifter bg_shifter_pattern;
+        BGShifter bg_shifter_attribute;
+
+        // NES Dev wiki - Sprite overflow games:
+        // <https://www.nesdev.org/wiki/Sprite_overflow_games>
+        //
+        // The sprite overflow flag is rarely used, mainly due to bugs when exactly 8 sprites are
+        // present on a scanline. No games rely on the buggy behavior.
+        //
+        // Nonetheless, games can intentionally place 9 or more sprites in a scanline to trigger
+        // the overflow flag consistently, as long as no previous scanlines have exactly 8 sprites.
+        ObjectAttributeEntry sprite_per_scanline[8]{};
+        uint8_t sprite_count{0};
+        uint8_t sprite_shifter_pattern_lo[8]{};
+        uint8_t sprite_shifter_pattern_hi[8]{};
+
+        // NES Dev wiki - PPU OAM: < https : // www.nesdev.org/wiki/PPU_OAM#Sprite_0_hits>
+        //  Sprite Zero Collision Flags
+        bool sprite_zero_hit_possible{false};
+        bool sprite_zero_being_rendered{false};
+
+        // A register to store the address when the CPU manually communicates
+        // with OAM via PPU registers. This is not commonly used because it
+        // is very slow, and instead a 256-Byte DMA transfer is used. See
+        // the Bus header for a description of this.
+        uint8_t oam_addr{0x00};
+        ObjectAttributeEntry oam[64]{};
+
+        /* palette colors */
+        uint8_t palette_table[32]{};
+
+        /**
+         * The NES has four logical nametables, but the NES system board itself has only 2 KiB of
+         * VRAM, enough for two physical nametables; hardware on the cartridge controls address bit
+         * 10 of CIRAM to map one nametable on top of another.
+         *
+         * @ref NES Dev wiki - PPU nametables: https://www.nesdev.org/wiki/PPU_nametables
+         */
+        uint8_t name_table[2][1024]{};
+    };
+
+private:
+    // points into the MachineState of the bus, or to our own state
+    State *state_{nullptr};
+    std::unique_ptr<State> own_state_;
+
+    std::shared_ptr<VScreen> vscreen_main_{nullptr};
+
+    // Every PPU memory region shown by the debug views carries a change counter which is bumped
+    // whenever the region is written. A view remembers the counters it was drawn from and is
+    // only regenerated once one of them moved on, or its own parameters changed. CHR bank
+    // switches are counted by the cartridge.
+    struct DebugStamp
+    {
+        uint32_t chr{0};
+        uint32_t chr_map{0};
+        uint32_t vram{0};
+        uint32_t palette{0};
+        uint32_t oam{0};
+        uint32_t param{0};
+
+        bool operator==(const DebugStamp &other) const
+        {
+            return chr == other.chr && chr_map == other.chr_map && vram == other.vram
+                   && palette == other.palette && oam == other.oam && param == other.param;
+        }
+    };
+    DebugStamp debug_dirty_;
+
+    struct DebugView
+    {
+        std::shared_ptr<VScreen> screen{nullptr};
+        DebugStamp stamp;
+        bool is_valid{false};
+    };
+    DebugView debug_pattern_table_[2];
+    DebugView debug_palette_;
+    DebugView debug_sprites_;
+
+    // Nametable views keep the decoded color indices so that moving the scroll window overlay
+    // only has to restore the pixels below the previous outline.
+    struct DebugNameTableView : DebugView
+    {
+        std::vector<uint8_t> color_index;
+        uint32_t scroll{0};
+    };
+    DebugNameTableView debug_name_table_[4];
+
+    // The four logical nametables $2000, $2400, $2800 and $2C00 are resolved to one of the two
+    // physical tables of the state through this page table. It follows the cartridge mirroring
+    // mode and is only rebuilt when that mode changes, so nametable fetches don't need to branch
+    // on it. Like the sprite buckets below it is derived from the state, and rebuilt when the
+    // state is replaced.
+    Cartridge::MIRROR mirror_{Cartridge::MIRROR::HORIZONTAL};
+    uint8_t *name_table_page_[4]{};
+
+    /**
+     * $3F10/$3F14/$3F18/$3F1C are mirrors of $3F00/$3F04/$3F08/$3F0C, which means the sprite
+     * palettes share their transparent entry with the universal background color.
+     *
+     * @ref NES Dev wiki - PPU palettes: <https://www.nesdev.org/wiki/PPU_palettes#Memory_Map>
+     */
+    static constexpr uint8_t PALETTE_INDEX[32] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+        0x0F, 0x00, 0x11, 0x12, 0x13, 0x04, 0x15, 0x16, 0x17, 0x08, 0x19, 0x1A, 0x1B, 0x0C, 0x1D,
+        0x1E, 0x1F,
+    };
+
+    // OAM only changes through $2004 writes and the $4014 DMA, so instead of scanning all 64
+    // entries at every scanline we sort the OAM indices into per-scanline buckets once and reuse
+    // them until OAM or the sprite size is modified. Each bucket keeps the first 8 sprites in OAM
+    // order, and 'count' saturates at 9 so that the overflow flag can still be derived from it.
+    struct SpriteBucket
+    {
+        uint8_t count;
+        uint8_t index[8];
+    } sprite_buckets_[240];
+    bool sprite_buckets_dirty_{true};
+
+    // While frames are not composed, background tiles and sprite patterns are only fetched and
+    // shifted on the lines the collision-only sprite zero check may look at, see isLineRendered()
+    bool is_line_rendered_{true};
 };
 
 } // namespace tn
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,70 @@
+#ifndef TINYNES_PPU_RENDER_WORKER_H
+#define TINYNES_PPU_RENDER_WORKER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tinynes/ppu.h"
+
+namespace tn
+{
+
+class Cartridge;
+class VScreen;
+
+/**
+ * Renders frames on a separate thread, one frame behind emulation.
+ *
+ * The emulated PPU records every CPU visible event of a frame together with the dot it happened
+ * on. When the frame ends, the log is handed over to a shadow PPU owning its own copy of the
+ * cartridge, which replays the events at the same dots and composes the picture while the
+ * emulation thread already runs the next frame.
+ */
+class PPURenderWorker
+{
+public:
+    PPURenderWorker(const PPU &ppu, const std::shared_ptr<Cartridge> &cartridge);
+    ~PPURenderWorker();
+
+    PPURenderWorker(const PPURenderWorker &) = delete;
+    PPURenderWorker &operator=(const PPURenderWorker &) = delete;
+
+    void record(const PPU::RenderEvent &event) { recording_.push_back(event); }
+    // called by the emulated PPU at the end of each frame
+    void submitFrame();
+    // After the emulated PPU and cartridge were restored, e.g. from a save state, the shadow
+    // starts over from their new state. The thread and the last published frame are kept.
+    void restart(const PPU &ppu, const Cartridge &cartridge);
+
+    // latest completed frame
+    std::shared_ptr<VScreen> vScreenMain();
+
+private:
+    void run();
+    void replay();
+
+private:
+    std::unique_ptr<PPU> shadow_;
+    std::shared_ptr<Cartridge> shadow_cart_;
+    std::shared_ptr<VScreen> front_;
+
+    std::vector<PPU::RenderEvent> recording_;
+    std::vector<PPU::RenderEvent> replaying_;
+    // carries the cartridge state over to the shadow copy in restart()
+    std::vector<uint8_t> cart_state_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool is_busy_{false};
+    // whether the shadow has composed a frame since the start or the last restart()
+    bool is_frame_ready_{false};
+    bool is_quit_{false};
+    std::thread thread_;
+};
+
+} // namespace tn
+
+#endif
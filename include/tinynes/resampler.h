@@ -0,0 +1,81 @@
+#ifndef TINYNES_RESAMPLER_H
+#define TINYNES_RESAMPLER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace tn
+{
+
+/**
+ * Decimates the native rate output of the APU (one sample per APU cycle, ~894.9 kHz) to the host
+ * sample rate.
+ *
+ * Two half-band stages halve the rate twice, then a polyphase windowed-sinc filter interpolates
+ * the ~223.7 kHz signal at arbitrary positions. The phase table is built once per rate pair, the
+ * position step can be nudged at any time through setRatio() to let a rate controller keep the
+ * host buffer fill level stable.
+ */
+class Resampler
+{
+public:
+    Resampler();
+
+    void setRates(double input_rate, double output_rate);
+    // output samples per input second are scaled by 'ratio'
+    void setRatio(double ratio);
+    void clear();
+
+    // append 'count' input samples of the same 'level'
+    void push(int32_t level, uint32_t count);
+
+    // input samples which still have to be pushed until the next output sample is complete
+    uint32_t inputNeeded() const;
+    uint32_t samplesAvailable() const;
+    float readSample();
+
+private:
+    // Half-band low pass, every second coefficient but the center one is zero. Only every other
+    // output is computed, since the next stage drops the rest anyway.
+    struct HalfBand
+    {
+        static constexpr uint32_t TAPS = 15;
+        float coeff[TAPS]{};
+        // input history, stored twice to read any window as one contiguous block
+        float history[TAPS * 2]{};
+        uint32_t pos{0};
+        bool is_odd{false};
+
+        void design();
+        void clear();
+        bool push(float sample, float &output);
+    };
+
+    void pushDecimated(float sample);
+
+private:
+    static constexpr uint32_t PHASE_BITS = 8;
+    static constexpr uint32_t PHASES = 1 << PHASE_BITS;
+    // zero crossings of the sinc on each side, in output samples
+    static constexpr uint32_t ZERO_CROSSINGS = 12;
+
+    HalfBand stage1_;
+    HalfBand stage2_;
+
+    double input_rate_{0.0};
+    double output_rate_{0.0};
+    double ratio_{1.0};
+
+    // PHASES + 1 rows of 'taps_' coefficients, the extra row helps interpolating the last phase
+    std::vector<float> kernel_;
+    uint32_t taps_{0};
+
+    // decimated input and the read position in it, 'step_' decimated samples per output sample
+    std::vector<float> buf_;
+    double pos_{0.0};
+    double step_{0.0};
+};
+
+} // namespace tn
+
+#endif
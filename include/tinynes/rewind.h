@@ -0,0 +1,107 @@
+#ifndef TINYNES_REWIND_H
+#define TINYNES_REWIND_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tn
+{
+
+class Bus;
+
+/**
+ * Rewind history of a bus, one save state per frame.
+ *
+ * capture() only copies the state into a pooled buffer and hands it to a worker thread. Every
+ * 'keyframe_interval' frames the worker keeps a keyframe, the states in between are stored as the
+ * XOR of the state and their keyframe. Both are run-length encoded: most of the machine does not
+ * change within a second, so a delta is mostly zeros. Any frame decodes from its keyframe and its
+ * own delta, the frames in between are not needed.
+ *
+ * The history is a ring bounded by 'memory_limit', the oldest keyframe is dropped together with
+ * its deltas once the limit is reached.
+ */
+class Rewind
+{
+public:
+    struct Stats
+    {
+        std::size_t frames{0}; // states in the history
+        std::size_t bytes{0};  // memory held by the history
+        double capture_us{0.0};  // average time capture() takes on the emulation thread
+        double compress_us{0.0}; // average time the worker spends on one state
+        double ratio{0.0};       // encoded size over state size
+    };
+
+    explicit Rewind(Bus &bus, std::size_t memory_limit = 32 * 1024 * 1024,
+                    uint32_t keyframe_interval = 60);
+    ~Rewind();
+    Rewind(const Rewind &) = delete;
+    Rewind &operator=(const Rewind &) = delete;
+
+    // saves the state of the bus, once per frame
+    void capture();
+
+    // Restores the state captured 'frames' captures before the latest one, or the oldest one if
+    // the history is shorter, and drops the newer ones. false if there was nothing to step to.
+    bool stepBack(uint32_t frames = 1);
+
+    // forgets the history, e.g. after another cartridge was inserted
+    void clear();
+
+    // waits for the worker to store the states captured so far
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        std::vector<uint8_t> data;
+        bool is_keyframe{false};
+    };
+
+    void run();
+    Entry encode(const std::vector<uint8_t> &state);
+    // drops the oldest keyframe and its deltas, unless it is the only keyframe
+    bool dropOldest();
+    // waits until the worker has stored every captured state, 'lock' holds mtx_
+    void waitIdle(std::unique_lock<std::mutex> &lock) const;
+
+private:
+    Bus &bus_;
+    std::size_t memory_limit_;
+    uint32_t keyframe_interval_;
+
+    mutable std::mutex mtx_;
+    mutable std::condition_variable cv_;
+    std::deque<std::vector<uint8_t>> pending_;
+    std::vector<std::vector<uint8_t>> free_buffers_;
+    bool is_busy_{false};
+    bool is_quit_{false};
+
+    std::deque<Entry> ring_;
+    std::size_t bytes_{0};
+    // raw state of the newest keyframe, the base of the deltas after it
+    std::vector<uint8_t> keyframe_;
+    uint32_t since_keyframe_{0};
+    // XOR of a state and its keyframe, and its encoding
+    std::vector<uint8_t> delta_;
+    std::vector<uint8_t> scratch_;
+
+    uint64_t captures_{0};
+    double capture_us_{0.0};
+    uint64_t encoded_{0};
+    double compress_us_{0.0};
+    uint64_t raw_bytes_{0};
+    uint64_t encoded_bytes_{0};
+
+    std::thread thread_;
+};
+
+} // namespace tn
+
+#endif
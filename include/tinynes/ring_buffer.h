@@ -0,0 +1,103 @@
+#ifndef TINYNES_RING_BUFFER_H
+#define TINYNES_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace tn
+{
+
+/**
+ * Lock-free single producer, single consumer ring buffer.
+ *
+ * One thread may push while another one pops without any lock: each side only writes its own
+ * index and publishes it with release semantics after the data has been copied. The capacity is
+ * rounded up to a power of two so that wrapping is a mask, the indices themselves run freely.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(std::size_t min_capacity = 1)
+    {
+        capacity_ = 1;
+        while (capacity_ < min_capacity) {
+            capacity_ <<= 1;
+        }
+        mask_ = capacity_ - 1;
+        data_ = std::make_unique<T[]>(capacity_);
+    }
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    std::size_t capacity() const { return capacity_; }
+
+    // elements ready to pop, exact on the consumer side and a lower bound elsewhere
+    std::size_t size() const
+    {
+        return write_idx_.load(std::memory_order_acquire)
+               - read_idx_.load(std::memory_order_acquire);
+    }
+
+    // free slots, exact on the producer side and a lower bound elsewhere
+    std::size_t space() const { return capacity_ - size(); }
+
+    // producer side, returns how many elements fit
+    std::size_t push(const T *src, std::size_t count)
+    {
+        std::size_t write = write_idx_.load(std::memory_order_relaxed);
+        std::size_t read = read_idx_.load(std::memory_order_acquire);
+        count = std::min(count, capacity_ - (write - read));
+        copyIn(write, src, count);
+        write_idx_.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    bool push(const T &value) { return push(&value, 1) == 1; }
+
+    // consumer side, returns how many elements were available
+    std::size_t pop(T *dst, std::size_t count)
+    {
+        std::size_t read = read_idx_.load(std::memory_order_relaxed);
+        std::size_t write = write_idx_.load(std::memory_order_acquire);
+        count = std::min(count, write - read);
+        copyOut(read, dst, count);
+        read_idx_.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+    // consumer side, drops everything that has been pushed so far
+    void clear() { read_idx_.store(write_idx_.load(std::memory_order_acquire)); }
+
+private:
+    // at most two contiguous runs, before and after the end of the storage
+    void copyIn(std::size_t idx, const T *src, std::size_t count)
+    {
+        std::size_t first = std::min(count, capacity_ - (idx & mask_));
+        std::copy(src, src + first, &data_[idx & mask_]);
+        std::copy(src + first, src + count, &data_[0]);
+    }
+
+    void copyOut(std::size_t idx, T *dst, std::size_t count) const
+    {
+        std::size_t first = std::min(count, capacity_ - (idx & mask_));
+        std::copy(&data_[idx & mask_], &data_[idx & mask_] + first, dst);
+        std::copy(&data_[0], &data_[0] + (count - first), dst + first);
+    }
+
+private:
+    std::unique_ptr<T[]> data_;
+    std::size_t capacity_{0};
+    std::size_t mask_{0};
+
+    // keep the indices on separate cache lines, each one is written by a single thread
+    alignas(64) std::atomic<std::size_t> write_idx_{0};
+    alignas(64) std::atomic<std::size_t> read_idx_{0};
+};
+
+} // namespace tn
+
+#endif
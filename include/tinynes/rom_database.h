@@ -0,0 +1,33 @@
+#ifndef TINYNES_ROM_DATABASE_H
+#define TINYNES_ROM_DATABASE_H
+
+#include <cstdint>
+
+namespace tn
+{
+
+/**
+ * Built-in database of known dumps, used to correct iNES headers which are wrong or lack the
+ * NES 2.0 fields. Games are identified by the CRC32 of their PRG and CHR ROM, header and
+ * trainer excluded, the way NesCartDB and most emulators key them.
+ *
+ * Entries use the NES 2.0 encodings so a match can replace the header fields as they are.
+ */
+struct RomDatabaseEntry
+{
+    uint32_t crc;
+    uint16_t mapper;
+    uint8_t submapper;
+    uint8_t mirror;          // 0: horizontal, 1: vertical, 2: four-screen
+    uint8_t prg_ram_shift;   // volatile PRG RAM of 64 << n bytes, 0 for none
+    uint8_t prg_nvram_shift; // battery backed PRG RAM, same encoding
+    uint8_t chr_ram_shift;   // CHR RAM, same encoding
+    uint8_t region;          // 0: NTSC, 1: PAL, 2: multiple regions, 3: Dendy
+};
+
+// binary search of the table sorted by CRC, nullptr for unknown games
+const RomDatabaseEntry *findRomDatabaseEntry(uint32_t crc);
+
+} // namespace tn
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef TINYNES_ROM_IMAGE_H
+#define TINYNES_ROM_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+namespace tn
+{
+
+/**
+ * Read-only ROM file mapped into memory.
+ *
+ * Images are cached process wide by content hash: loading a game that is already mapped,
+ * through any path, returns the existing image. So any number of cartridges running the same
+ * game share a single physical copy of its PRG and CHR ROM, only their RAM is private. Loading
+ * a file which is already mapped skips the mapping and the hash altogether. An image is unmapped
+ * when the last cartridge using it is gone.
+ *
+ * The file must not be rewritten in place while it is mapped, its pages would change under the
+ * running games or fault once truncated. Replacing it through a rename is fine.
+ */
+class RomImage
+{
+public:
+    // nullptr if the file cannot be opened or mapped
+    static std::shared_ptr<const RomImage> load(std::string_view filename);
+    // number of images currently mapped
+    static std::size_t cachedCount();
+
+    ~RomImage();
+    RomImage(const RomImage &) = delete;
+    RomImage &operator=(const RomImage &) = delete;
+
+    const uint8_t *data() const { return data_; }
+    std::size_t size() const { return size_; }
+    // CRC32 of everything after the 16 byte iNES header, the checksum of PRG and CHR ROM for most
+    // files. Files differing only in their header get the same hash but separate images.
+    uint32_t hash() const { return hash_; }
+    // CRC32 of 'size' bytes at 'offset'. Taken from hash() when the range is the same, otherwise
+    // computed on the first call and kept, every cartridge of a game asks for the same range.
+    uint32_t crc(std::size_t offset, std::size_t size) const;
+
+    static constexpr std::size_t HASH_OFFSET = 16;
+
+private:
+    RomImage(const uint8_t *data, std::size_t size, uint32_t hash)
+        : data_(data), size_(size), hash_(hash){};
+
+    const uint8_t *data_{nullptr};
+    std::size_t size_{0};
+    uint32_t hash_{0};
+
+    mutable std::mutex crc_mutex_;
+    mutable std::size_t crc_offset_{0};
+    mutable std::size_t crc_size_{0};
+    mutable uint32_t crc_{0};
+    mutable bool is_crc_valid_{false};
+};
+
+} // namespace tn
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef TINYNES_ROM_LIBRARY_H
+#define TINYNES_ROM_LIBRARY_H
+
+#include "tinynes/cartridge.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tn
+{
+
+/**
+ * Index of the .nes files found under a set of directories.
+ *
+ * A scan stats every file and only reads the ones which are new or whose size or modification
+ * time changed since the index was saved, the others keep their indexed header. Files are read
+ * by a pool of threads: each one maps the file, parses the header and checksums PRG and CHR ROM
+ * the way a cartridge does, but nothing is allocated for the game itself.
+ *
+ * The index file is a flat binary dump of fixed size records followed by the paths, it is simply
+ * rebuilt from scratch when its version does not match.
+ */
+class RomLibrary
+{
+public:
+    struct Entry
+    {
+        std::string path;
+        uint64_t size{0};
+        int64_t mtime_ns{0};
+        bool is_valid{false}; // an iNES image, 'info' is meaningless otherwise
+        Cartridge::Info info;
+    };
+
+    struct ScanStats
+    {
+        std::size_t files{0};   // .nes files found
+        std::size_t parsed{0};  // files read because the index had nothing for them
+        std::size_t invalid{0}; // files which are no iNES image
+        double seconds{0.0};
+
+        double filesPerSecond() const { return seconds > 0.0 ? files / seconds : 0.0; }
+    };
+
+    // loads 'index_file' if it exists, an empty path keeps the index in memory only
+    explicit RomLibrary(std::string_view index_file = {});
+
+    // Replaces the entries by the .nes files under 'directories', recursively. 0 threads uses one
+    // per hardware thread.
+    ScanStats scan(const std::vector<std::string> &directories, unsigned threads = 0);
+
+    // writes the index file, atomically through a rename
+    bool save() const;
+
+    const std::vector<Entry> &entries() const { return entries_; }
+    // first entry of the dump with checksum 'crc', nullptr if there is none
+    const Entry *findByCRC(uint32_t crc) const;
+
+private:
+    bool load();
+
+    std::string index_file_;
+    // sorted by path
+    std::vector<Entry> entries_;
+};
+
+} // namespace tn
+
+#endif
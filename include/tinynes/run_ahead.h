@@ -0,0 +1,72 @@
+#ifndef TINYNES_RUN_AHEAD_H
+#define TINYNES_RUN_AHEAD_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tinynes/bus.h"
+
+namespace tn
+{
+
+class VScreen;
+
+/**
+ * Run-ahead hides the frames of lag a game has between reading the controller and showing the
+ * result. After every frame of the bus, a second instance loads its state and runs 'frames'
+ * frames further with the latest controller input, and that picture is shown instead. The bus
+ * itself never runs ahead, so nothing has to be rolled back: the next frame simply starts from
+ * the real state again.
+ *
+ * The second instance runs on a clone of the cartridge, which never writes the save file, and
+ * has no audio sink. Only its last frame is composed, the ones before it and the frames of the
+ * bus are skipped the way frame skipping does, which keeps sprite zero hits exact.
+ */
+class RunAhead
+{
+public:
+    static constexpr uint32_t MAX_FRAMES = 3;
+
+    struct Stats
+    {
+        uint64_t frames{0};    // updates run ahead so far
+        double update_us{0.0}; // average time update() takes
+        double frame_us{0.0};  // average cost of one frame run ahead, state copy included
+    };
+
+    explicit RunAhead(Bus &bus, uint32_t frames = 1);
+    ~RunAhead();
+    RunAhead(const RunAhead &) = delete;
+    RunAhead &operator=(const RunAhead &) = delete;
+
+    // 0 turns run-ahead off, at most MAX_FRAMES
+    void setFrames(uint32_t frames);
+    uint32_t frames() const { return frames_; }
+
+    // call after each frame of the bus
+    void update();
+
+    // the picture run ahead, that of the bus while run-ahead is off
+    std::shared_ptr<VScreen> vScreenMain();
+
+    Stats stats() const;
+
+private:
+    Bus &bus_;
+    uint32_t frames_{0};
+    // whether the last update() ran ahead
+    bool is_ahead_{false};
+    Bus ahead_;
+    // the cartridge of the bus the clone was made from
+    std::shared_ptr<Cartridge> cart_;
+    std::vector<uint8_t> state_;
+
+    uint64_t updates_{0};
+    uint64_t ahead_frames_{0};
+    double update_us_{0.0};
+};
+
+} // namespace tn
+
+#endif
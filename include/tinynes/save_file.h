@@ -0,0 +1,53 @@
+#ifndef TINYNES_SAVE_FILE_H
+#define TINYNES_SAVE_FILE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace tn
+{
+
+/**
+ * Battery backed RAM kept in a file mapped into memory.
+ *
+ * The emulated RAM is the mapping itself, so a write only has to mark the file dirty. One
+ * background thread shared by all save files msyncs the dirty ones at a fixed cadence: the
+ * emulation thread never waits for the disk, and a write reaches it at most one flush interval
+ * plus the time of the msync later. Destroying the save file flushes it synchronously.
+ */
+class SaveFile
+{
+public:
+    // Opens or creates 'filename', grown to 'size' bytes if shorter. A file can only be open once
+    // per process.
+    SaveFile(std::string_view filename, std::size_t size);
+    ~SaveFile();
+
+    SaveFile(const SaveFile &) = delete;
+    SaveFile &operator=(const SaveFile &) = delete;
+
+    bool isOpen() const { return data_ != nullptr; }
+    uint8_t *data() { return data_; }
+    std::size_t size() const { return size_; }
+
+    // release: the flush that sees the flag also sees the bytes written before it
+    void markDirty() { is_dirty_.store(true, std::memory_order_release); }
+    // blocks until everything written so far is on disk
+    void flush();
+
+    // cadence of the background flush, shared by all save files, 1 s by default
+    static void setFlushInterval(std::chrono::milliseconds interval);
+    static std::chrono::milliseconds flushInterval();
+
+private:
+    uint8_t *data_{nullptr};
+    std::size_t size_{0};
+    std::atomic<bool> is_dirty_{false};
+};
+
+} // namespace tn
+
+#endif
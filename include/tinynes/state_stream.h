@@ -0,0 +1,86 @@
+#ifndef TINYNES_STATE_STREAM_H
+#define TINYNES_STATE_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace tn
+{
+
+/**
+ * Save states are plain byte dumps in host byte order, the bus writes the MachineState in one
+ * piece and the cartridge and its mapper append their own fields one by one. Appending to a
+ * buffer which already has the capacity of the previous state does not allocate.
+ */
+class StateWriter
+{
+public:
+    explicit StateWriter(std::vector<uint8_t> &buffer) : buffer_(buffer) {}
+
+    void write(const void *data, std::size_t size)
+    {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void put(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&value, sizeof(T));
+    }
+
+private:
+    std::vector<uint8_t> &buffer_;
+};
+
+// Reads what a StateWriter wrote. Reading past the end fails the whole reader, which then only
+// yields zeros, so callers check isOK() once at the end.
+class StateReader
+{
+public:
+    StateReader(const uint8_t *data, std::size_t size) : data_(data), size_(size) {}
+
+    bool read(void *data, std::size_t size)
+    {
+        if (size == 0) {
+            return is_ok_;
+        }
+        if (size > size_ - offset_) {
+            is_ok_ = false;
+            offset_ = size_;
+        }
+        if (!is_ok_) {
+            std::memset(data, 0, size);
+            return false;
+        }
+        std::memcpy(data, data_ + offset_, size);
+        offset_ += size;
+        return true;
+    }
+
+    template <typename T>
+    T get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    bool isOK() const { return is_ok_; }
+    bool isEnd() const { return offset_ == size_; }
+
+private:
+    const uint8_t *data_;
+    std::size_t size_;
+    std::size_t offset_{0};
+    bool is_ok_{true};
+};
+
+} // namespace tn
+
+#endif
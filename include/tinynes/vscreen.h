@@ -58,6 +58,8 @@ public:
 
     uint32_t width() const { return texture_.getSize().x; }
     uint32_t height() const { return texture_.getSize().y; }
+    // RGBA, row by row
+    const std::vector<sf::Uint8> &pixels() const { return image_; }
 
 private:
     sf::Texture texture_;
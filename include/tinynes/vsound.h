@@ -1,34 +1,84 @@
 #ifndef TINYNES_VSOUND_H
 #define TINYNES_VSOUND_H
 
+#include <atomic>
 #include <memory>
 #include <utility>
 #include <vector>
 #include <SFML/Config.hpp>
 #include <SFML/Audio/SoundStream.hpp>
 
+#include "tinynes/audio_sink.h"
+#include "tinynes/audio_sync.h"
+#include "tinynes/ring_buffer.h"
+
 namespace tn
 {
 
 class Bus;
-class VSound : public sf::SoundStream
+
+/**
+ * Audio sink playing through an SFML stream, fed through a lock-free queue.
+ *
+ * The emulation thread runs the machine in fill() and the bus writes its mono samples into the
+ * queue until it holds the target latency. The audio thread of SFML only pops finished samples
+ * and duplicates them over the output channels, it never touches the emulator. When the queue
+ * runs dry the last sample is held and an underrun is counted, samples that do not fit count as
+ * overruns.
+ *
+ * The machine can be paced in two ways: fill() lets the audio device set the pace, runFrame()
+ * lets the caller, typically the display refresh, set it while AudioSync bends the sample rate to
+ * keep the queue at its target.
+ */
+class VSound : public sf::SoundStream, public AudioSink
 {
 public:
-    void init(sf::Int16 length, sf::Uint32 channel_count, sf::Uint32 sample_rate,
+    ~VSound() override;
+
+    // latency_ms is the amount of audio kept queued ahead of the device, 10-100 ms. The stream
+    // becomes the audio sink of the bus.
+    void init(sf::Uint32 latency_ms, sf::Uint32 channel_count, sf::Uint32 sample_rate,
               std::shared_ptr<Bus> nes);
 
+    // emulation thread: run the machine until the queue reaches the target latency
+    void fill();
+    // emulation thread: run up to the end of the current video frame and adjust the sample rate to the queue fill level,
+    // returns false when the queue is too full and the frame was skipped
+    bool runFrame();
+
+    uint32_t sampleRate() const override { return getSampleRate(); }
+    // emulation thread: queue samples, the ones that do not fit are dropped
+    void write(const float *samples, std::size_t count) override;
+
+    const AudioSync::Metrics &metrics() const { return sync_.metrics(); }
+
+    std::size_t queuedFrames() const { return queue_ ? queue_->size() : 0; }
+    std::size_t targetFrames() const { return target_frames_; }
+    uint64_t underruns() const { return underrun_count_.load(std::memory_order_relaxed); }
+    uint64_t overruns() const { return overrun_count_.load(std::memory_order_relaxed); }
+
 private:
     bool onGetData(Chunk &data) override;
     void onSeek(sf::Time timeOffset) override;
 
+    static constexpr float MAX_SAMPLE = 32767.0f;
+    static sf::Int16 toInt16(float sample);
+
 private:
     std::shared_ptr<Bus> nes_{nullptr};
+    std::unique_ptr<RingBuffer<sf::Int16>> queue_;
+    std::size_t target_frames_{0};
+    AudioSync sync_;
+
+    // audio thread buffers, one chunk of mono frames and its interleaved copy
+    std::vector<sf::Int16> mono_;
     std::vector<sf::Int16> samples_;
-    std::size_t current_sample_;
+    sf::Int16 last_sample_{0};
 
-    sf::Int16 max_sample_{32767};
+    std::atomic<uint64_t> underrun_count_{0};
+    std::atomic<uint64_t> overrun_count_{0};
 };
 
 } // namespace tn
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,77 @@
+#ifndef TINYNES_WAV_AUDIO_SINK_H
+#define TINYNES_WAV_AUDIO_SINK_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tinynes/audio_sink.h"
+
+namespace tn
+{
+
+/**
+ * Writes samples as 16 bit mono PCM, either into a RIFF WAVE file or as headerless raw data.
+ *
+ * Samples are converted into a front buffer on the emulation thread. A full buffer is swapped
+ * with the back buffer that a background thread writes to disk, so the emulator only waits when
+ * it outpaces the disk by a whole buffer. The WAVE header sizes are patched in on close().
+ */
+class WavAudioSink : public AudioSink
+{
+public:
+    enum class Format
+    {
+        WAV,
+        RAW,
+    };
+
+public:
+    WavAudioSink(std::string_view filename, uint32_t sample_rate, Format format = Format::WAV);
+    ~WavAudioSink() override;
+
+    WavAudioSink(const WavAudioSink &) = delete;
+    WavAudioSink &operator=(const WavAudioSink &) = delete;
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    uint32_t sampleRate() const override { return sample_rate_; }
+    void write(const float *samples, std::size_t count) override;
+    // blocks until all samples written so far are in the file
+    void flush() override;
+    // finish the file, further samples are dropped
+    void close();
+
+    uint64_t samplesWritten() const { return samples_written_; }
+
+private:
+    void run();
+    // hand the front buffer over to the writer thread once it has finished the previous one
+    void submit();
+    void writeHeader(uint32_t data_bytes);
+
+private:
+    // 64K samples, about 1.5 s at 44.1 kHz
+    static constexpr std::size_t BUFFER_SAMPLES = 1 << 16;
+
+    std::FILE *file_{nullptr};
+    uint32_t sample_rate_;
+    Format format_;
+    uint64_t samples_written_{0};
+
+    std::vector<int16_t> front_;
+    std::vector<int16_t> back_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool is_busy_{false};
+    bool is_quit_{false};
+    std::thread thread_;
+};
+
+} // namespace tn
+
+#endif
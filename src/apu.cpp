@@ -1,322 +1,585 @@
 #include "tinynes/apu.h"
+#include "tinynes/bus.h"
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 namespace tn
 {
-uint8_t APU::length_table_[] = {10, 254, 20, 2,  40, 4,  80, 6,  160, 8,  60, 10, 14, 12, 26, 14,
-                                12, 16,  24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30};
+
+namespace
+{
+
+template <size_t N>
+constexpr std::array<int32_t, N> makeMixerTable(double numerator, double denominator)
+{
+    std::array<int32_t, N> table{};
+    for (size_t n = 1; n < N; n += 1) {
+        double level = numerator / (denominator / static_cast<double>(n) + 100.0);
+        table[n] = static_cast<int32_t>(level * 32768.0 + 0.5);
+    }
+    return table;
+}
+
+} // namespace
+
+const std::array<int32_t, 31> APU::pulse_table_ = makeMixerTable<31>(95.52, 8128.0);
+const std::array<int32_t, 203> APU::tnd_table_ = makeMixerTable<203>(163.67, 24329.0);
+
+APU::APU(State *state) : state_(state)
+{
+    if (state_ == nullptr) {
+        own_state_ = std::make_unique<State>();
+        state_ = own_state_.get();
+    }
+    setSampleRate(44100);
+}
+
+void APU::setSampleRate(uint32_t sample_rate)
+{
+    sample_rate_ = sample_rate;
+    resampler_.setRates(CPU_CLOCK_RATE / 2.0, static_cast<double>(sample_rate));
+    setSampleRatio(sample_ratio_);
+    resetSampler();
+}
+
+void APU::setSampleMode(SampleMode mode)
+{
+    sample_mode_ = mode;
+    resetSampler();
+}
+
+void APU::setSampleRatio(double ratio)
+{
+    sample_ratio_ = ratio;
+    double rate = static_cast<double>(sample_rate_) * ratio;
+    blip_.setRates(CPU_CLOCK_RATE, rate);
+    for (auto &blip : stem_blips_) {
+        blip.setRates(CPU_CLOCK_RATE, rate);
+    }
+    resampler_.setRatio(ratio);
+    point_step_ = static_cast<uint64_t>(CPU_CLOCK_RATE / rate * 4294967296.0);
+}
+
+// Output restarts from the current APU cycle, samples still pending are dropped
+void APU::resetSampler()
+{
+    blip_.clear();
+    blip_frame_cycle_ = state_->apu_cycle;
+    blip_clocks_needed_ = blip_.clocksNeeded(1);
+
+    resampler_.clear();
+    resampler_cycle_ = state_->apu_cycle;
+
+    point_clock_ = state_->apu_cycle * 2;
+    point_fraction_ = 0;
+
+    dc_input_ = 0.0F;
+    dc_output_ = 0.0F;
+
+    for (auto &blip : stem_blips_) {
+        blip.clear();
+    }
+    stem_frame_cycle_ = state_->apu_cycle;
+}
 
 void APU::cpuWrite(uint16_t addr, uint8_t data)
 {
     // NES Dev wiki - APU: https://www.nesdev.org/wiki/APU
     switch (addr) {
+    // NES Dev wiki - APU pulse: https://www.nesdev.org/wiki/APU_Pulse
+    // The pulse channels produce a variable-width pulse signal, controlled by volume, envelope,
+    // length, and sweep units.
+    // [$4000/$4004] [DDLC VVVV]    Duty (D), envelope loop / length counter halt (L),
+    //                              constant volume (C), volume/envelope (V)
+    // [$4001/$4005] [EPPP NSSS]    Sweep unit: enabled (E), period (P), negate (N), shift (S)
+    // [$4002/$4006] [TTTT TTTT]    Timer low (T)
+    // [$4003/$4007] [TTTT LTTT]    Length counter load (L), timer high (T)
     case 0x4000:
-        // NES Dev wiki - APU pulse: https://www.nesdev.org/wiki/APU_Pulse
-        // look at Sequencer behavior: Duty Cycle Sequences
-        // The pulse channels produce a variable-width pulse signal, controlled by volume, envelope,
-        // length, and sweep units.
-        // [$4000/$4004] [DDLC VVVV]    Duty (D), envelope loop / length counter halt (L),
-        //                              constant volume (C), volume/envelope (V)
-        // [$4001/$4005] [EPPP NSSS]    Sweep unit: enabled (E), period (P), negate (N), shift (S)
-        // [$4002/$4006] [TTTT TTTT]    Timer low (T)
-        // [$4003/$4007] [TTTT LTTT]    Length counter load (L), timer high (T)
-        switch ((data & 0xC0) >> 6) {
-        case 0x00:
-            pulse1_.sequencer.new_sequence = 0b01000000;
-            pulse1_.osc.duty_cycle = 0.125;
-            break;
-        case 0x01:
-            pulse1_.sequencer.new_sequence = 0b01100000;
-            pulse1_.osc.duty_cycle = 0.250;
-            break;
-        case 0x02:
-            pulse1_.sequencer.new_sequence = 0b01111000;
-            pulse1_.osc.duty_cycle = 0.500;
-            break;
-        case 0x03:
-            pulse1_.sequencer.new_sequence = 0b10011111;
-            pulse1_.osc.duty_cycle = 0.750;
-            break;
-        }
-        pulse1_.sequencer.sequence = pulse1_.sequencer.new_sequence;
-        pulse1_.is_halt = static_cast<bool>(data & 0x20);
-        pulse1_.envelope.is_enable = !static_cast<bool>(data & 0x10);
-        pulse1_.envelope.constant_volume = (data & 0x0F);
+        writePulseControl(state_->pulse1, data);
         break;
-    // pulse channel 1 sweep setup
     case 0x4001:
-        pulse1_.sweep.shifter = data & 0x07;
-        pulse1_.sweep.is_negate = static_cast<bool>(data & 0x08);
-        pulse1_.sweep.period = (data & 0x70) >> 4;
-        pulse1_.sweep.is_enable = static_cast<bool>(data & 0x80);
-        pulse1_.sweep.is_reload = true;
+        writePulseSweep(state_->pulse1, data);
         break;
-    // pulse 1 timer Low 8 bits
     case 0x4002:
-        pulse1_.sequencer.reload = (pulse1_.sequencer.reload & 0xFF00) | data;
+        state_->pulse1.period = (state_->pulse1.period & 0xFF00) | data;
         break;
-    // Pulse 1 length counter load and timer high 3 bits
     case 0x4003:
-        pulse1_.sequencer.reload
-            = static_cast<uint16_t>((data & 0x07)) << 8 | (pulse1_.sequencer.reload & 0x00FF);
-        pulse1_.sequencer.timer = pulse1_.sequencer.reload;
-        pulse1_.sequencer.sequence = pulse1_.sequencer.new_sequence;
-        pulse1_.lc.counter = length_table_[(data & 0xF8) >> 3];
-        pulse1_.envelope.is_start = true;
+        writePulseLength(state_->pulse1, data);
         break;
     case 0x4004:
-        switch ((data & 0xC0) >> 6) {
-        case 0x00:
-            pulse2_.sequencer.new_sequence = 0b01000000;
-            pulse2_.osc.duty_cycle = 0.125;
-            break;
-        case 0x01:
-            pulse2_.sequencer.new_sequence = 0b01100000;
-            pulse2_.osc.duty_cycle = 0.250;
-            break;
-        case 0x02:
-            pulse2_.sequencer.new_sequence = 0b01111000;
-            pulse2_.osc.duty_cycle = 0.500;
-            break;
-        case 0x03:
-            pulse2_.sequencer.new_sequence = 0b10011111;
-            pulse2_.osc.duty_cycle = 0.750;
-            break;
-        }
-        pulse2_.sequencer.sequence = pulse1_.sequencer.new_sequence;
-        pulse2_.is_halt = static_cast<bool>(data & 0x20);
-        pulse2_.envelope.is_enable = !static_cast<bool>(data & 0x10);
-        pulse2_.envelope.constant_volume = (data & 0x0F);
+        writePulseControl(state_->pulse2, data);
         break;
-        break;
-    // pulse channel 2 sweep setup
     case 0x4005:
-        pulse2_.sweep.shifter = data & 0x07;
-        pulse2_.sweep.is_negate = static_cast<bool>(data & 0x08);
-        pulse2_.sweep.period = (data & 0x70) >> 4;
-        pulse2_.sweep.is_enable = static_cast<bool>(data & 0x80);
-        pulse2_.sweep.is_reload = true;
+        writePulseSweep(state_->pulse2, data);
         break;
-    // pulse 2 timer low 8 bits
     case 0x4006:
-        pulse2_.sequencer.reload = (pulse2_.sequencer.reload & 0xFF00) | data;
+        state_->pulse2.period = (state_->pulse2.period & 0xFF00) | data;
         break;
-    // pulse 2 length counter load and timer high 3 bits
     case 0x4007:
-        pulse2_.sequencer.reload
-            = static_cast<uint16_t>((data & 0x07)) << 8 | (pulse2_.sequencer.reload & 0x00FF);
-        pulse2_.sequencer.timer = pulse2_.sequencer.reload;
-        pulse2_.sequencer.sequence = pulse2_.sequencer.new_sequence;
-        pulse2_.lc.counter = length_table_[(data & 0xF8) >> 3];
-        pulse2_.envelope.is_start = true;
+        writePulseLength(state_->pulse2, data);
         break;
+    // NES Dev wiki - APU Triangle: https://www.nesdev.org/wiki/APU_Triangle
+    // [$4008] [CRRR RRRR]    Length counter halt / linear counter control (C), reload value (R)
+    // [$400A] [LLLL LLLL]    Timer low (L)
+    // [$400B] [llll lHHH]    Length counter load (l), timer high (H)
     case 0x4008:
+        state_->triangle.is_control = static_cast<bool>(data & 0x80);
+        state_->triangle.linear_reload = data & 0x7F;
+        break;
+    case 0x400A:
+        state_->triangle.period = (state_->triangle.period & 0xFF00) | data;
+        break;
+    case 0x400B:
+        state_->triangle.period
+            = static_cast<uint16_t>((data & 0x07) << 8) | (state_->triangle.period & 0x00FF);
+        if (state_->triangle.is_enable) {
+            state_->triangle.lc.counter = apu::LENGTH_TABLE[(data & 0xF8) >> 3];
+        }
+        state_->triangle.is_linear_reload = true;
         break;
+    // NES Dev wiki - APU Noise: https://www.nesdev.org/wiki/APU_Noise
+    // [$400C] [--LC VVVV]    Envelope loop / length counter halt (L), constant volume (C),
+    //                        volume/envelope (V)
+    // [$400E] [M--- PPPP]    Mode flag (M), timer period index (P)
+    // [$400F] [LLLL L---]    Length counter load (L)
     case 0x400C:
-        noise_.envelope.constant_volume = (data & 0x0F);
-        noise_.envelope.is_enable = !static_cast<bool>(data & 0x10);
-        noise_.is_halt = static_cast<bool>(data & 0x20);
+        state_->noise.envelope.constant_volume = (data & 0x0F);
+        state_->noise.envelope.is_enable = !static_cast<bool>(data & 0x10);
+        state_->noise.is_halt = static_cast<bool>(data & 0x20);
         break;
     case 0x400E:
-        switch (data & 0x0F) {
-        case 0x00:
-            noise_.sequencer.reload = 0;
-            break;
-        case 0x01:
-            noise_.sequencer.reload = 4;
-            break;
-        case 0x02:
-            noise_.sequencer.reload = 8;
-            break;
-        case 0x03:
-            noise_.sequencer.reload = 16;
-            break;
-        case 0x04:
-            noise_.sequencer.reload = 32;
-            break;
-        case 0x05:
-            noise_.sequencer.reload = 64;
-            break;
-        case 0x06:
-            noise_.sequencer.reload = 96;
-            break;
-        case 0x07:
-            noise_.sequencer.reload = 128;
-            break;
-        case 0x08:
-            noise_.sequencer.reload = 160;
-            break;
-        case 0x09:
-            noise_.sequencer.reload = 202;
-            break;
-        case 0x0A:
-            noise_.sequencer.reload = 254;
-            break;
-        case 0x0B:
-            noise_.sequencer.reload = 380;
-            break;
-        case 0x0C:
-            noise_.sequencer.reload = 508;
-            break;
-        case 0x0D:
-            noise_.sequencer.reload = 1016;
-            break;
-        case 0x0E:
-            noise_.sequencer.reload = 2034;
-            break;
-        case 0x0F:
-            noise_.sequencer.reload = 4068;
-            break;
-        }
+        state_->noise.is_mode = static_cast<bool>(data & 0x80);
+        state_->noise.period = apu::NoiseChannel::PERIOD_TABLE[data & 0x0F] / 2 - 1;
         break;
     case 0x400F:
-        pulse1_.envelope.is_start = true;
-        pulse2_.envelope.is_start = true;
-        noise_.envelope.is_start = true;
-        noise_.lc.counter = length_table_[(data & 0xF8) >> 3];
+        if (state_->noise.is_enable) {
+            state_->noise.lc.counter = apu::LENGTH_TABLE[(data & 0xF8) >> 3];
+        }
+        state_->noise.envelope.is_start = true;
+        break;
+    // NES Dev wiki - APU DMC: https://www.nesdev.org/wiki/APU_DMC
+    // [$4010] [IL-- RRRR]    IRQ enable (I), loop (L), rate index (R)
+    // [$4011] [-DDD DDDD]    Direct load (D)
+    // [$4012] [AAAA AAAA]    Sample address = %11AAAAAA.AA000000 = $C000 + (A * 64)
+    // [$4013] [LLLL LLLL]    Sample length = %LLLL.LLLL0001 = (L * 16) + 1 bytes
+    case 0x4010:
+        state_->dmc.is_irq_enable = static_cast<bool>(data & 0x80);
+        state_->dmc.is_loop = static_cast<bool>(data & 0x40);
+        state_->dmc.period = apu::DMCChannel::RATE_TABLE[data & 0x0F] / 2 - 1;
+        if (!state_->dmc.is_irq_enable) {
+            state_->dmc.is_irq = false;
+        }
+        break;
+    case 0x4011:
+        state_->dmc.output = data & 0x7F;
+        break;
+    case 0x4012:
+        state_->dmc.sample_address = static_cast<uint16_t>(0xC000 + data * 64);
         break;
+    case 0x4013:
+        state_->dmc.sample_length = static_cast<uint16_t>(data * 16 + 1);
+        break;
+    // [$4015] [---D NT21]    Enable DMC (D), noise (N), triangle (T), and pulse channels (2/1)
     case 0x4015:
-        pulse1_.is_enable = static_cast<bool>(data & 0x01);
-        pulse2_.is_enable = static_cast<bool>(data & 0x02);
-        noise_.is_enable = static_cast<bool>(data & 0x04);
+        state_->pulse1.is_enable = static_cast<bool>(data & 0x01);
+        state_->pulse2.is_enable = static_cast<bool>(data & 0x02);
+        state_->triangle.is_enable = static_cast<bool>(data & 0x04);
+        state_->noise.is_enable = static_cast<bool>(data & 0x08);
+        // disabling a channel clears its length counter right away
+        if (!state_->pulse1.is_enable) {
+            state_->pulse1.lc.counter = 0;
+        }
+        if (!state_->pulse2.is_enable) {
+            state_->pulse2.lc.counter = 0;
+        }
+        if (!state_->triangle.is_enable) {
+            state_->triangle.lc.counter = 0;
+        }
+        if (!state_->noise.is_enable) {
+            state_->noise.lc.counter = 0;
+        }
+        state_->dmc.is_irq = false;
+        if ((data & 0x10) == 0) {
+            state_->dmc.bytes_remaining = 0;
+        }
+        else if (state_->dmc.bytes_remaining == 0) {
+            state_->dmc.restart();
+            fetchDMCSample();
+        }
         break;
     }
+
+    // the written value takes effect on the next APU cycle
+    updateMixer(state_->apu_cycle);
+}
+
+// [$4015] [IF-D NT21]    DMC interrupt (I), frame interrupt (F), DMC active (D),
+//                        length counter > 0 (N/T/2/1)
+uint8_t APU::cpuRead(uint16_t addr)
+{
+    uint8_t data = 0x00;
+    if (addr == 0x4015) {
+        data |= state_->pulse1.lc.counter > 0 ? 0x01 : 0x00;
+        data |= state_->pulse2.lc.counter > 0 ? 0x02 : 0x00;
+        data |= state_->triangle.lc.counter > 0 ? 0x04 : 0x00;
+        data |= state_->noise.lc.counter > 0 ? 0x08 : 0x00;
+        data |= state_->dmc.bytes_remaining > 0 ? 0x10 : 0x00;
+        data |= state_->dmc.is_irq ? 0x80 : 0x00;
+    }
+    return data;
+}
+
+template <typename Pulse>
+void APU::writePulseControl(Pulse &pulse, uint8_t data)
+{
+    pulse.duty = (data & 0xC0) >> 6;
+    pulse.is_halt = static_cast<bool>(data & 0x20);
+    pulse.envelope.is_enable = !static_cast<bool>(data & 0x10);
+    pulse.envelope.constant_volume = (data & 0x0F);
 }
 
-uint8_t APU::cpuRead([[maybe_unused]] uint16_t addr) { return 0x00; }
+template <typename Pulse>
+void APU::writePulseSweep(Pulse &pulse, uint8_t data)
+{
+    pulse.sweep.shifter = data & 0x07;
+    pulse.sweep.is_negate = static_cast<bool>(data & 0x08);
+    pulse.sweep.period = (data & 0x70) >> 4;
+    pulse.sweep.is_enable = static_cast<bool>(data & 0x80);
+    pulse.sweep.is_reload = true;
+}
 
-void APU::clock()
+template <typename Pulse>
+void APU::writePulseLength(Pulse &pulse, uint8_t data)
 {
-    bool reach_quarter_frame_clock = false;
-    bool reach_half_frame_clock = false;
+    pulse.period = static_cast<uint16_t>((data & 0x07) << 8) | (pulse.period & 0x00FF);
+    if (pulse.is_enable) {
+        pulse.lc.counter = apu::LENGTH_TABLE[(data & 0xF8) >> 3];
+    }
+    // restart the sequencer and the envelope
+    pulse.step = 0;
+    pulse.envelope.is_start = true;
+}
 
-    global_time_ += 0.3333333 / 1789773.0;
+void APU::fetchDMCSample()
+{
+    if (state_->dmc.needsFetch()) {
+        // the CPU stall of the fetch is not emulated
+        uint16_t addr = state_->dmc.current_address;
+        state_->dmc.fetch(bus_ != nullptr ? bus_->cpuRead(addr, true) : 0x00);
+    }
+}
 
-    // The sequencer is clocked on every other CPU cycle, so 2 CPU cycles = 1 APU cycle.
-    // 3 PPU cycles = 1 CPU cycles.
-    if (clock_counter_ % 6 == 0) {
-        frame_clock_counter_ += 1;
+void APU::syncTo(uint64_t cpu_clock)
+{
+    // The sequencer is clocked on every other CPU cycle, so 2 CPU cycles = 1 APU cycle. APU cycles
+    // fall on even CPU clocks, 'cpu_clock' itself included.
+    uint64_t target = cpu_clock / 2 + 1;
 
+    while (state_->apu_cycle < target) {
         // 4-Step Sequence Mode - Mode 0: 4-Step Sequence (bit 7 of $4017 clear):
         // https://www.nesdev.org/wiki/APU_Frame_Counter
-        if (frame_clock_counter_ == 3729) {
-            reach_quarter_frame_clock = true;
+        uint32_t next_step = 14916;
+        if (state_->frame_clock_counter < 3729) {
+            next_step = 3729;
         }
-
-        if (frame_clock_counter_ == 7457) {
-            reach_quarter_frame_clock = true;
-            reach_half_frame_clock = true;
+        else if (state_->frame_clock_counter < 7457) {
+            next_step = 7457;
         }
-
-        if (frame_clock_counter_ == 11186) {
-            reach_quarter_frame_clock = true;
+        else if (state_->frame_clock_counter < 11186) {
+            next_step = 11186;
         }
+        uint64_t step_cycle = state_->apu_cycle + (next_step - state_->frame_clock_counter - 1);
 
-        if (frame_clock_counter_ == 14916) {
-            reach_quarter_frame_clock = true;
-            reach_half_frame_clock = true;
-            frame_clock_counter_ = 0;
+        if (step_cycle >= target) {
+            state_->frame_clock_counter += static_cast<uint32_t>(target - state_->apu_cycle);
+            (this->*run_channels_)(target);
+            break;
         }
 
-        // quarter frame "beats" adjust the volume envelope
-        if (reach_quarter_frame_clock) {
-            pulse1_.envelope.clock(pulse1_.is_halt);
-            pulse2_.envelope.clock(pulse2_.is_halt);
-            noise_.envelope.clock(noise_.is_halt);
+        state_->frame_clock_counter = next_step;
+        (this->*run_channels_)(step_cycle);
+        // frame sequencer "beats" act before the channels are clocked in the same cycle
+        clockFrameSequencer();
+        (this->*run_channels_)(step_cycle + 1);
+        updateMixer(step_cycle);
+    }
+
+    if (sample_mode_ == SampleMode::BLIP) {
+        uint32_t frame_clocks = static_cast<uint32_t>(state_->apu_cycle - blip_frame_cycle_) * 2;
+        if (frame_clocks >= blip_clocks_needed_) {
+            blip_.endFrame(frame_clocks);
+            blip_frame_cycle_ = state_->apu_cycle;
         }
+    }
+    else if (sample_mode_ == SampleMode::SINC) {
+        resampler_.push(mix_level_, static_cast<uint32_t>(state_->apu_cycle - resampler_cycle_));
+        resampler_cycle_ = state_->apu_cycle;
+    }
+}
 
-        // Half frame "beats" adjust the note length counter and
-        // frequency sweep units
-        if (reach_half_frame_clock) {
-            pulse1_.lc.clock(pulse1_.is_enable, pulse1_.is_halt);
-            pulse2_.lc.clock(pulse2_.is_enable, pulse2_.is_halt);
-            noise_.lc.clock(noise_.is_enable, noise_.is_halt);
-            pulse1_.sweep.clock(pulse1_.sequencer.reload, 0);
-            pulse2_.sweep.clock(pulse1_.sequencer.reload, 1);
+/**
+ * Advances the channel timers up to, but not including, 'end_cycle'. A timer underflows on the
+ * cycle it starts at 0, so the closest timer value tells how many cycles can be skipped at once
+ * before any waveform changes. Channels missing from ACTIVE are left frozen, the DMC runs anyway
+ * because the CPU sees its sample reads and IRQ.
+ */
+template <uint8_t ACTIVE>
+void APU::runChannels(uint64_t end_cycle)
+{
+    State &s = *state_;
+    constexpr bool IS_PULSE1 = (ACTIVE & channelBit(PULSE1)) != 0;
+    constexpr bool IS_PULSE2 = (ACTIVE & channelBit(PULSE2)) != 0;
+    constexpr bool IS_TRIANGLE = (ACTIVE & channelBit(TRIANGLE)) != 0;
+    constexpr bool IS_NOISE = (ACTIVE & channelBit(NOISE)) != 0;
+
+    while (s.apu_cycle < end_cycle) {
+        uint64_t remain = end_cycle - s.apu_cycle;
+        uint32_t skip = std::min({IS_PULSE1 ? s.pulse1.untilStep() : apu::IDLE,
+                                  IS_PULSE2 ? s.pulse2.untilStep() : apu::IDLE,
+                                  IS_TRIANGLE ? s.triangle.untilStep() : apu::IDLE,
+                                  IS_NOISE ? s.noise.untilStep() : apu::IDLE,
+                                  s.dmc.untilStep()});
+        if (skip >= remain) {
+            skip = static_cast<uint32_t>(remain);
         }
 
-        // update pulse1 channel
-        pulse1_.sequencer.clock(pulse1_.is_enable,
-                                [](uint32_t &s)
-                                {
-                                    // Shift right by 1 bit, wrapping around
-                                    s = ((s & 0x0001) << 7) | ((s & 0x00FE) >> 1);
-                                });
-        // pulse1_.sample = static_cast<double>(pulse1_.sequencer.output);
-        // f = fCPU / (16 × (t + 1)), fCPU; 1.789773MHz NTSC
-        pulse1_.osc.frequency
-            = 1789773.0 / (16.0 * static_cast<double>(pulse1_.sequencer.reload + 1));
-
-        pulse1_.osc.amplitude = static_cast<double>(pulse1_.envelope.output - 1) / 16.0;
-        pulse1_.sample = pulse1_.osc.sample(global_time_);
-        if (pulse1_.lc.counter > 0 && pulse1_.sequencer.timer >= 8 && !pulse1_.sweep.is_mute
-            && pulse1_.envelope.output > 2)
-        {
-            pulse1_.output += (pulse1_.sample - pulse1_.output) * 0.5;
+        if constexpr (IS_PULSE1) {
+            s.pulse1.skip(skip);
         }
-        else {
-            pulse1_.output = 0;
+        if constexpr (IS_PULSE2) {
+            s.pulse2.skip(skip);
         }
-
-        // update pulse2 channel
-        pulse2_.sequencer.clock(pulse2_.is_enable,
-                                [](uint32_t &s)
-                                {
-                                    // Shift right by 1 bit, wrapping around
-                                    s = ((s & 0x0001) << 7) | ((s & 0x00FE) >> 1);
-                                });
-        pulse2_.osc.frequency
-            = 1789773.0 / (16.0 * static_cast<double>(pulse2_.sequencer.reload + 1));
-        pulse2_.osc.amplitude = static_cast<double>(pulse2_.envelope.output - 1) / 16.0;
-        pulse2_.sample = pulse2_.osc.sample(global_time_);
-
-        if (pulse2_.lc.counter > 0 && pulse2_.sequencer.timer >= 8 && !pulse2_.sweep.is_mute
-            && pulse2_.envelope.output > 2)
-        {
-            pulse2_.output += (pulse2_.sample - pulse2_.output) * 0.5;
+        if constexpr (IS_TRIANGLE) {
+            s.triangle.skip(skip);
         }
-        else {
-            pulse2_.output = 0;
+        if constexpr (IS_NOISE) {
+            s.noise.skip(skip);
         }
-
-        // update noise
-        noise_.sequencer.clock(noise_.is_enable,
-                               [](uint32_t &s)
-                               {
-                                   s = (((s & 0x0001) ^ ((s & 0x0002) >> 1)) << 14)
-                                       | ((s & 0x7FFF) >> 1);
-                               });
-
-        if (noise_.lc.counter > 0 && noise_.sequencer.timer >= 8) {
-            noise_.output = static_cast<double>(noise_.sequencer.output)
-                            * (static_cast<double>(noise_.envelope.output - 1) / 16.0);
+        s.dmc.skip(skip);
+        s.apu_cycle += skip;
+        if (skip == remain) {
+            break;
         }
 
-        if (!pulse1_.is_enable) {
-            pulse1_.output = 0;
+        // at least one timer underflows on this cycle
+        bool is_changed = false;
+        if constexpr (IS_PULSE1) {
+            is_changed |= s.pulse1.clock();
         }
-        if (!pulse2_.is_enable) {
-            pulse2_.output = 0;
+        if constexpr (IS_PULSE2) {
+            is_changed |= s.pulse2.clock();
         }
-        if (!noise_.is_enable) {
-            noise_.output = 0;
+        if constexpr (IS_TRIANGLE) {
+            is_changed |= s.triangle.clock();
         }
+        if constexpr (IS_NOISE) {
+            is_changed |= s.noise.clock();
+        }
+        is_changed |= s.dmc.clock();
+        fetchDMCSample();
+        if (is_changed) {
+            updateMixer(s.apu_cycle);
+        }
+        s.apu_cycle += 1;
+    }
+}
+
+const std::array<APU::RunChannelsFn, (1 << APU::DMC)> APU::run_channels_table_
+    = APU::makeRunChannelsTable(std::make_index_sequence<(1 << APU::DMC)>{});
+
+void APU::setMuteMask(uint8_t mask)
+{
+    mute_mask_ = mask & ALL_CHANNELS;
+    updateActiveMask();
+}
+
+void APU::setSoloMask(uint8_t mask)
+{
+    solo_mask_ = mask & ALL_CHANNELS;
+    updateActiveMask();
+}
+
+void APU::updateActiveMask()
+{
+    uint8_t audible = solo_mask_ != 0 ? solo_mask_ : ALL_CHANNELS;
+    active_mask_ = audible & ~mute_mask_;
+    run_channels_ = run_channels_table_[active_mask_ & ~channelBit(DMC)];
+    // channels dropping out or coming back change the mixer output right away
+    updateMixer(state_->apu_cycle);
+}
+
+void APU::clockFrameSequencer()
+{
+    State &s = *state_;
+    bool reach_half_frame_clock = (s.frame_clock_counter == 7457 || s.frame_clock_counter == 14916);
+    if (s.frame_clock_counter == 14916) {
+        s.frame_clock_counter = 0;
     }
-    // Frequency sweepers change at high frequency
-    pulse1_.sweep.track(pulse1_.sequencer.reload);
-    pulse2_.sweep.track(pulse2_.sequencer.reload);
 
-    clock_counter_ += 1;
+    // quarter frame "beats" adjust the volume envelope and the triangle linear counter
+    s.pulse1.envelope.clock(s.pulse1.is_halt);
+    s.pulse2.envelope.clock(s.pulse2.is_halt);
+    s.noise.envelope.clock(s.noise.is_halt);
+    s.triangle.clockLinearCounter();
+
+    // Half frame "beats" adjust the note length counter and
+    // frequency sweep units
+    if (reach_half_frame_clock) {
+        s.pulse1.lc.clock(s.pulse1.is_halt);
+        s.pulse2.lc.clock(s.pulse2.is_halt);
+        s.triangle.lc.clock(s.triangle.is_control);
+        s.noise.lc.clock(s.noise.is_halt);
+        s.pulse1.sweep.clock(s.pulse1.period);
+        s.pulse2.sweep.clock(s.pulse2.period);
+    }
 }
 
 void APU::reset() {}
 
-double APU::getOutputSample()
+void APU::syncState()
+{
+    // the sampler clocks are relative to the APU cycle, which may have jumped either way
+    resetSampler();
+    updateMixer(state_->apu_cycle);
+}
+
+int32_t APU::mixLevel() const
+{
+    const State &s = *state_;
+    auto level = [this](Channel channel, uint8_t value)
+    { return (active_mask_ & channelBit(channel)) != 0 ? value : 0; };
+    return pulse_table_[level(PULSE1, s.pulse1.level()) + level(PULSE2, s.pulse2.level())]
+           + tnd_table_[3 * level(TRIANGLE, s.triangle.level()) + 2 * level(NOISE, s.noise.level())
+                        + level(DMC, s.dmc.level())];
+}
+
+// Only changes of the mixer output reach the samplers, stamped with the APU cycle they happen on
+void APU::updateMixer(uint64_t cycle)
 {
-    if (is_raw_mode_) {
-        return (pulse1_.sample - 0.5) * 0.5 + (pulse2_.sample - 0.5) * 0.5;
+    if (is_stem_output_) {
+        updateStems(cycle);
+    }
+
+    int32_t level = mixLevel();
+    if (level == mix_level_) {
+        return;
     }
-    return ((1.0 * pulse1_.output) - 0.8) * 0.1 + ((1.0 * pulse2_.output) - 0.8) * 0.1
-           + ((2.0 * (noise_.output - 0.5))) * 0.1;
+
+    if (sample_mode_ == SampleMode::BLIP) {
+        blip_.addDelta(static_cast<uint32_t>(cycle - blip_frame_cycle_) * 2, level - mix_level_);
+    }
+    else if (sample_mode_ == SampleMode::SINC) {
+        // the previous level lasted until this cycle
+        resampler_.push(mix_level_, static_cast<uint32_t>(cycle - resampler_cycle_));
+        resampler_cycle_ = cycle;
+    }
+    mix_level_ = level;
 }
-} // namespace tn
\ No newline at end of file
+
+// Every stem is a single channel through its part of the DAC, so the stems do not sum up exactly
+// to the nonlinear mix
+void APU::updateStems(uint64_t cycle)
+{
+    auto active = [this](Channel channel) { return (active_mask_ & channelBit(channel)) != 0; };
+    const std::array<int32_t, CHANNEL_COUNT> levels = {
+        active(PULSE1) ? pulse_table_[state_->pulse1.level()] : 0,
+        active(PULSE2) ? pulse_table_[state_->pulse2.level()] : 0,
+        active(TRIANGLE) ? tnd_table_[3 * state_->triangle.level()] : 0,
+        active(NOISE) ? tnd_table_[2 * state_->noise.level()] : 0,
+        active(DMC) ? tnd_table_[state_->dmc.level()] : 0,
+    };
+    uint32_t clock_time = static_cast<uint32_t>(cycle - stem_frame_cycle_) * 2;
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch += 1) {
+        if (levels[ch] != stem_levels_[ch]) {
+            stem_blips_[ch].addDelta(clock_time, levels[ch] - stem_levels_[ch]);
+            stem_levels_[ch] = levels[ch];
+        }
+    }
+}
+
+void APU::setStemOutput(bool enable)
+{
+    is_stem_output_ = enable;
+    stem_levels_.fill(0);
+    stem_samples_.fill(0.0);
+    for (auto &blip : stem_blips_) {
+        blip.clear();
+    }
+    stem_frame_cycle_ = state_->apu_cycle;
+    if (enable) {
+        updateStems(state_->apu_cycle);
+    }
+}
+
+uint64_t APU::nextSampleClock() const
+{
+    switch (sample_mode_) {
+    case SampleMode::POINT:
+        return point_clock_;
+    case SampleMode::BLIP: {
+        if (blip_.samplesAvailable() > 0) {
+            return 0;
+        }
+        // the frame ends after the APU cycle which completes the needed clocks
+        uint64_t cycles = std::max<uint64_t>((blip_clocks_needed_ + 1) / 2, 1);
+        return (blip_frame_cycle_ + cycles - 1) * 2;
+    }
+    case SampleMode::SINC: {
+        uint64_t cycles = resampler_.inputNeeded();
+        if (cycles == 0) {
+            return 0;
+        }
+        return (resampler_cycle_ + cycles - 1) * 2;
+    }
+    }
+    return 0;
+}
+
+double APU::readSample()
+{
+    if (is_stem_output_) {
+        // the stems follow the main output sample by sample, a stem running one sample short
+        // because of rounding holds its previous value
+        uint32_t frame_clocks = static_cast<uint32_t>(state_->apu_cycle - stem_frame_cycle_) * 2;
+        stem_frame_cycle_ = state_->apu_cycle;
+        for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch += 1) {
+            stem_blips_[ch].endFrame(frame_clocks);
+            int16_t sample = 0;
+            if (stem_blips_[ch].readSamples(&sample, 1) == 1) {
+                stem_samples_[ch] = static_cast<double>(sample) / 32768.0;
+            }
+        }
+    }
+
+    float level = 0.0F;
+    switch (sample_mode_) {
+    case SampleMode::POINT: {
+        level = static_cast<float>(mix_level_);
+        uint64_t fraction = static_cast<uint64_t>(point_fraction_) + (point_step_ & 0xFFFFFFFF);
+        point_clock_ += (point_step_ >> 32) + (fraction >> 32);
+        point_fraction_ = static_cast<uint32_t>(fraction);
+        break;
+    }
+    case SampleMode::BLIP: {
+        int16_t sample = 0;
+        blip_.readSamples(&sample, 1);
+        blip_clocks_needed_ = blip_.clocksNeeded(1);
+        return static_cast<double>(sample) / 32768.0;
+    }
+    case SampleMode::SINC:
+        if (resampler_.samplesAvailable() > 0) {
+            level = resampler_.readSample();
+        }
+        break;
+    }
+
+    // same cut-off as the BlipBuffer bass shift
+    constexpr float POLE = 1.0F - 1.0F / 512.0F;
+    dc_output_ = level - dc_input_ + POLE * dc_output_;
+    dc_input_ = level;
+    return std::clamp(static_cast<double>(dc_output_) / 32768.0, -1.0, 1.0);
+}
+
+double APU::getOutputSample() const { return static_cast<double>(mixLevel()) / 32768.0; }
+} // namespace tn
@@ -0,0 +1,33 @@
+#include "tinynes/audio_sync.h"
+#include <algorithm>
+
+namespace tn
+{
+
+void AudioSync::reset(std::size_t target_frames)
+{
+    metrics_ = Metrics{};
+    metrics_.target_frames = target_frames;
+    metrics_.fill_frames = target_frames;
+    metrics_.fill_level = 1.0;
+    smoothed_fill_ = static_cast<double>(target_frames);
+}
+
+double AudioSync::update(std::size_t fill_frames)
+{
+    double target = static_cast<double>(std::max<std::size_t>(metrics_.target_frames, 1));
+    smoothed_fill_ += (static_cast<double>(fill_frames) - smoothed_fill_) * FILL_SMOOTHING;
+
+    // a queue below its target needs more samples per emulated frame, above it fewer
+    double error = std::clamp((target - smoothed_fill_) / target, -1.0, 1.0);
+    metrics_.ratio = 1.0 + MAX_DEVIATION * error;
+
+    double drift = (metrics_.ratio - 1.0) * 1e6;
+    metrics_.drift_ppm += (drift - metrics_.drift_ppm) * DRIFT_SMOOTHING;
+    metrics_.fill_frames = fill_frames;
+    metrics_.fill_level = static_cast<double>(fill_frames) / target;
+    metrics_.updates += 1;
+    return metrics_.ratio;
+}
+
+} // namespace tn
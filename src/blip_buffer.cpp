@@ -0,0 +1,127 @@
+#include "tinynes/blip_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace tn
+{
+
+BlipBuffer::BlipBuffer(uint32_t capacity)
+    : buf_(capacity + WIDTH, 0)
+{
+    setRates(1789773.0, 44100.0);
+}
+
+void BlipBuffer::setRates(double clock_rate, double sample_rate)
+{
+    double factor = sample_rate / clock_rate * std::ldexp(1.0, TIME_BITS);
+    factor_ = static_cast<uint64_t>(std::ceil(factor));
+}
+
+void BlipBuffer::clear()
+{
+    offset_ = 0;
+    avail_ = 0;
+    integrator_ = 0;
+    std::fill(buf_.begin(), buf_.end(), 0);
+}
+
+void BlipBuffer::addDelta(uint32_t clock_time, int32_t delta)
+{
+    uint64_t pos = offset_ + clock_time * factor_;
+    uint32_t idx = static_cast<uint32_t>(pos >> TIME_BITS);
+    if (idx + WIDTH > buf_.size()) {
+        // nobody reads the samples, drop the change rather than write out of range
+        return;
+    }
+
+    uint32_t phase = static_cast<uint32_t>(pos >> (TIME_BITS - PHASE_BITS)) & (PHASES - 1);
+    const auto &step = kernel()[phase];
+    int32_t *out = &buf_[idx];
+    for (uint32_t k = 0; k < WIDTH; k += 1) {
+        out[k] += delta * step[k];
+    }
+}
+
+void BlipBuffer::endFrame(uint32_t clock_duration)
+{
+    offset_ += clock_duration * factor_;
+    avail_ = std::min(static_cast<uint32_t>(offset_ >> TIME_BITS),
+                      static_cast<uint32_t>(buf_.size() - WIDTH));
+}
+
+uint32_t BlipBuffer::clocksNeeded(uint32_t samples) const
+{
+    uint64_t target = static_cast<uint64_t>(avail_ + samples) << TIME_BITS;
+    if (target <= offset_) {
+        return 0;
+    }
+    return static_cast<uint32_t>((target - offset_ + factor_ - 1) / factor_);
+}
+
+uint32_t BlipBuffer::readSamples(int16_t *out, uint32_t count)
+{
+    count = std::min(count, avail_);
+    for (uint32_t i = 0; i < count; i += 1) {
+        integrator_ += buf_[i];
+        int32_t sample = integrator_ >> KERNEL_BITS;
+        // leaky integration removes the DC offset of the unsigned channel levels
+        integrator_ -= sample * (1 << (KERNEL_BITS - BASS_SHIFT));
+        out[i] = static_cast<int16_t>(std::clamp(sample, -32768, 32767));
+    }
+
+    // shift the remaining samples, including the tails of steps already added, to the front
+    uint32_t remain = static_cast<uint32_t>(offset_ >> TIME_BITS) - count + WIDTH;
+    std::memmove(buf_.data(), buf_.data() + count, remain * sizeof(int32_t));
+    std::memset(buf_.data() + remain, 0, count * sizeof(int32_t));
+
+    offset_ -= static_cast<uint64_t>(count) << TIME_BITS;
+    avail_ -= count;
+    return count;
+}
+
+/**
+ * Each phase holds the differences of a band-limited step whose edge lies 'phase / PHASES'
+ * samples after the first tap, delayed by HALF_WIDTH samples. The impulse is a Blackman windowed
+ * sinc with its cut-off slightly below Nyquist, every phase is normalized to unity gain so steps
+ * never leave a residue behind in the integrator.
+ */
+const BlipBuffer::Kernel &BlipBuffer::kernel()
+{
+    static const Kernel table = []()
+    {
+        constexpr double PI = 3.14159265358979323846;
+        constexpr double CUTOFF = 0.9;
+
+        Kernel k{};
+        for (uint32_t phase = 0; phase < PHASES; phase += 1) {
+            double frac = static_cast<double>(phase) / PHASES;
+            std::array<double, WIDTH> impulse{};
+            double sum = 0.0;
+            for (uint32_t tap = 0; tap < WIDTH; tap += 1) {
+                double t = static_cast<double>(tap) - (HALF_WIDTH - 0.5) - frac;
+                double x = PI * CUTOFF * t;
+                double sinc = (std::fabs(x) < 1e-9) ? 1.0 : std::sin(x) / x;
+                double w = (t + HALF_WIDTH) / WIDTH;
+                double window = 0.42 - 0.5 * std::cos(2.0 * PI * w) + 0.08 * std::cos(4.0 * PI * w);
+                impulse[tap] = sinc * std::max(window, 0.0);
+                sum += impulse[tap];
+            }
+
+            // quantize with error feedback so every phase sums to exactly 1 << KERNEL_BITS
+            double acc = 0.0;
+            int32_t total = 0;
+            for (uint32_t tap = 0; tap < WIDTH; tap += 1) {
+                acc += impulse[tap] / sum * (1 << KERNEL_BITS);
+                int32_t next = static_cast<int32_t>(std::lround(acc));
+                k[phase][tap] = static_cast<int16_t>(next - total);
+                total = next;
+            }
+        }
+        return k;
+    }();
+    return table;
+}
+
+} // namespace tn
@@ -1,45 +1,85 @@
 #include "tinynes/bus.h"
+#include "tinynes/state_stream.h"
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace tn
 {
 
-Bus::Bus()
+namespace
+{
+
+constexpr char STATE_MAGIC[4] = {'T', 'N', 'S', 'S'};
+// bump whenever MachineState or the fields saved by the cartridge and its mappers change
+constexpr uint32_t STATE_VERSION = 1;
+
+struct StateHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t size;          // whole state, header included
+    uint32_t machine_size;  // sizeof(MachineState), catches layout changes without a version bump
+    uint32_t crc;           // of the game
+};
+
+} // namespace
+
+Bus::Bus() : cpu_(&state_.cpu), ppu_(&state_.ppu), apu_(&state_.apu)
 {
     // connect CPU to main Bus
     cpu_.connectBus(this);
-    // clear RAM at init
-    for (auto &mem : cpu_ram_) {
-        mem = 0x00;
-    }
+    // DMC samples are read from the CPU address space
+    apu_.connectBus(this);
+}
+
+Bus::~Bus()
+{
+    setThreadedRendering(false);
 }
 
 void Bus::cpuWrite(uint64_t addr, uint8_t data)
 {
-    if (cart_->cpuWrite(addr, data)) {
-        // placeholder for future extension
+    // A mapper register write, or one to the NSF bank registers at $5FF8-$5FFF, may switch the
+    // PRG bank the DMC reads its samples from, the APU has to fetch what it is due from the old
+    // bank first
+    bool is_bank_write = addr >= 0x8000 || (isPlayerMode() && addr >= 0x5FF8 && addr <= 0x5FFF);
+    if (is_bank_write && apu_.isDMCActive()) {
+        apu_.syncTo(state_.bus.cpu_clock_counter);
+    }
+    // in player mode the tune maps its bank registers and work RAM instead of a cartridge
+    if (isPlayerMode() && nsf_->cpuWrite(addr, data)) {
+    }
+    else if (!isPlayerMode() && cart_->cpuWrite(addr, data)) {
+        // mapper registers may have switched the nametable mirroring
+        ppu_.syncMirroring();
+        ppu_.logCartridgeWrite(addr, data);
     }
     else if (addr >= 0 && addr <= 0x1FFF) {
         // system internal RAM address range. The range covers 8KB, though
         // there is only 2KB available. That 2KB is "mirrored" through this address range.
-        cpu_ram_[addr & 0x07FF /*2KB*/] = data;
+        state_.bus.cpu_ram[addr & 0x07FF /*2KB*/] = data;
     }
     else if (addr >= 0x2000 && addr <= 0x3FFF) {
-        // PPU registers address range, mirrored every 8 bytes
-        ppu_.cpuWrite(addr & 0x0007, data);
+        // PPU registers address range, mirrored every 8 bytes. The PPU is off in player mode.
+        if (!isPlayerMode()) {
+            ppu_.cpuWrite(addr & 0x0007, data);
+        }
     }
     // APU registers are mapped in range $4000-$4013, $4015 and $4017
     else if ((addr >= 0x4000 && addr <= 0x4013) || addr == 0x4015 || addr == 0x4017) {
+        apu_.syncTo(state_.bus.cpu_clock_counter);
         apu_.cpuWrite(addr, data);
     }
     else if (addr == 0x4014) {
         // A write to this address initiates a DMA transfer
-        dma_page_ = data;
-        dma_addr_ = 0x00;
-        dma_transfer_ = true;
+        state_.bus.dma_page = data;
+        state_.bus.dma_addr = 0x00;
+        state_.bus.dma_transfer = true;
     }
     else if (addr >= 0x4016 && addr <= 0x4017) {
-        controller_state_[addr & 0x0001] = controller_[addr & 0x0001];
+        state_.bus.controller_state[addr & 0x0001] = state_.bus.controller[addr & 0x0001];
     }
 }
 
@@ -47,69 +87,195 @@ uint8_t Bus::cpuRead(uint64_t addr, bool read_only /*unused*/)
 {
     uint8_t data = 0x00;
 
-    // cartridge  access
-    if (cart_->cpuRead(addr, data)) {
+    // tune or cartridge access
+    if (isPlayerMode() && nsf_->cpuRead(addr, data)) {
+    }
+    else if (!isPlayerMode() && cart_->cpuRead(addr, data)) {
     }
     // system internal RAM address range, mirrored every 2048 bytes
     else if (addr >= 0 && addr <= 0x1FFF) {
-        return cpu_ram_[addr & 0x07FF /*2KB*/];
+        return state_.bus.cpu_ram[addr & 0x07FF /*2KB*/];
     }
     // PPU registers address range, mirrored every 8 bytes
-    else if (addr >= 0x2000 && addr <= 0x3FFF) {
+    else if (addr >= 0x2000 && addr <= 0x3FFF && !isPlayerMode()) {
         data = ppu_.cpuRead(addr & 0x0007, read_only);
     }
-    // No need to add APU read because synchronization necessity
+    // APU status, the lazily clocked APU has to catch up first
+    else if (addr == 0x4015) {
+        apu_.syncTo(state_.bus.cpu_clock_counter);
+        data = apu_.cpuRead(addr);
+    }
     else if (addr >= 0x4016 && addr <= 0x4017) {
-        data = static_cast<uint8_t>((controller_state_[addr & 0x0001] & 0x80) > 0);
-        controller_state_[addr & 0x0001] <<= 1;
+        data = static_cast<uint8_t>((state_.bus.controller_state[addr & 0x0001] & 0x80) > 0);
+        state_.bus.controller_state[addr & 0x0001] <<= 1;
     }
     return data;
 }
 
 void Bus::insertCartridge(const std::shared_ptr<Cartridge> &cartridge)
 {
+    bool is_threaded = isThreadedRendering();
+    setThreadedRendering(false);
+    nsf_ = nullptr;
     cart_ = cartridge;
     ppu_.connectCartridge(cartridge);
+    setThreadedRendering(is_threaded);
+}
+
+void Bus::setMachineState(const MachineState &state)
+{
+    state_ = state;
+    syncMachineState();
+}
+
+void Bus::syncMachineState()
+{
+    ppu_.syncState();
+    apu_.syncState();
+    // the worker replays from its own copy of the PPU, which has to start over
+    if (isThreadedRendering()) {
+        render_worker_->restart(ppu_, *cart_);
+    }
+}
+
+bool Bus::saveState(std::vector<uint8_t> &buffer) const
+{
+    buffer.clear();
+    if (isPlayerMode() || cart_ == nullptr) {
+        return false;
+    }
+    StateWriter writer(buffer);
+    StateHeader header{};
+    writer.put(header);
+    writer.put(state_);
+    cart_->saveState(writer);
+
+    std::memcpy(header.magic, STATE_MAGIC, sizeof(STATE_MAGIC));
+    header.version = STATE_VERSION;
+    header.size = static_cast<uint32_t>(buffer.size());
+    header.machine_size = sizeof(MachineState);
+    header.crc = cart_->info().crc;
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    return true;
+}
+
+bool Bus::loadState(const uint8_t *data, std::size_t size)
+{
+    if (isPlayerMode() || cart_ == nullptr) {
+        return false;
+    }
+    StateReader reader(data, size);
+    auto header = reader.get<StateHeader>();
+    // the layout follows from the version and the game, a state with a matching header and size
+    // cannot run short halfway through
+    if (!reader.isOK() || std::memcmp(header.magic, STATE_MAGIC, sizeof(STATE_MAGIC)) != 0
+        || header.version != STATE_VERSION || header.size != size
+        || header.machine_size != sizeof(MachineState) || header.crc != cart_->info().crc)
+    {
+        spdlog::warn("Bus ignores a save state of another game or format");
+        return false;
+    }
+    reader.read(&state_, sizeof(MachineState));
+    // the PPU takes the mirroring from the cartridge
+    cart_->loadState(reader);
+    syncMachineState();
+    return reader.isOK() && reader.isEnd();
+}
+
+void Bus::setThreadedRendering(bool enable)
+{
+    if (enable == isThreadedRendering() || (enable && cart_ == nullptr)) {
+        return;
+    }
+    if (enable) {
+        // the worker starts from a snapshot of the current PPU and cartridge state
+        render_worker_ = std::make_unique<PPURenderWorker>(ppu_, cart_);
+        ppu_.attachRenderWorker(render_worker_.get());
+    }
+    else {
+        ppu_.attachRenderWorker(nullptr);
+        render_worker_.reset();
+    }
+}
+
+void Bus::insertNSF(const std::shared_ptr<NSF> &nsf)
+{
+    // nothing to render without a PPU
+    setThreadedRendering(false);
+    nsf_ = nsf;
+    nsf_play_period_ = static_cast<uint64_t>(nsf_->playPeriodUs() * APU::CPU_CLOCK_RATE / 1e6
+                                              * 65536.0);
+    playTrack(nsf_->startingSong());
+}
+
+// NES Dev wiki - NSF: <https://www.nesdev.org/wiki/NSF#Initializing_a_tune>
+void Bus::playTrack(uint8_t track)
+{
+    nsf_track_ = track;
+    nsf_->reset();
+    for (auto &mem : state_.bus.cpu_ram) {
+        mem = 0x00;
+    }
+
+    // silence all channels, enable the four waveform channels and the 4-step frame sequencer
+    for (uint16_t addr = 0x4000; addr <= 0x4013; addr += 1) {
+        cpuWrite(addr, 0x00);
+    }
+    cpuWrite(0x4015, 0x00);
+    cpuWrite(0x4015, 0x0F);
+    cpuWrite(0x4017, 0x40);
+
+    // INIT gets the song number in A and the NTSC/PAL flag in X
+    cpu_.reset();
+    cpu_.call(nsf_->initAddr(), NSF::IDLE_ADDR, track, 0);
+    nsf_next_play_ = (state_.bus.cpu_clock_counter << 16) + nsf_play_period_;
 }
 
 void Bus::reset()
 {
+    if (isPlayerMode()) {
+        playTrack(nsf_track_);
+        return;
+    }
     cart_->reset();
     cpu_.reset();
     ppu_.reset();
-    sys_clock_counter_ = 0;
+    state_.bus.sys_clock_counter = 0;
 }
 
 bool Bus::clock()
 {
+    if (isPlayerMode()) {
+        return clockPlayer();
+    }
 
+    BusState &bus = state_.bus;
     ppu_.clock();
-    apu_.clock();
 
-    if (sys_clock_counter_ % 3 == 0) {
+    if (bus.sys_clock_counter % 3 == 0) {
         // DMA start?
-        if (dma_transfer_) {
+        if (bus.dma_transfer) {
             // wait until the next even CPU clock cycle before it starts
-            if (dma_dummy_) {
-                if (sys_clock_counter_ % 2 == 1) {
-                    dma_dummy_ = false;
+            if (bus.dma_dummy) {
+                if (bus.sys_clock_counter % 2 == 1) {
+                    bus.dma_dummy = false;
                 }
             }
             else {
                 // DMA can take place!
-                if (sys_clock_counter_ % 2 == 0) {
+                if (bus.sys_clock_counter % 2 == 0) {
                     // On even clock cycles, read from CPU bus
-                    dma_data_ = cpuRead(dma_page_ << 8 | dma_addr_);
+                    bus.dma_data = cpuRead(bus.dma_page << 8 | bus.dma_addr);
                 }
                 else {
                     // On odd clock cycles, write to PPU OAM
-                    ppu_.oam()[dma_addr_] = dma_data_;
-                    dma_addr_ += 1;
+                    ppu_.oamWrite(bus.dma_addr, bus.dma_data);
+                    bus.dma_addr += 1;
                     // If this wraps around, we know that 256 bytes have been written, so end the
                     // DMA transfer, and proceed as normal
-                    if (dma_addr_ == 0x00) {
-                        dma_transfer_ = false;
-                        dma_dummy_ = true;
+                    if (bus.dma_addr == 0x00) {
+                        bus.dma_transfer = false;
+                        bus.dma_dummy = true;
                     }
                 }
             }
@@ -121,36 +287,123 @@ bool Bus::clock()
     }
 
     // indicate if output audio sample is ready
-    // do synchronization!!!
     bool is_audio_sample_ready = false;
-    audio_time_ += audio_time_in_nes_clock_;
-    if (audio_time_ >= audio_time_in_sys_sample_) {
-        // reset audio time accumulator
-        audio_time_ -= audio_time_in_sys_sample_;
-        audio_sample_ = apu_.getOutputSample();
-        is_audio_sample_ready = true;
+    if (bus.sys_clock_counter % 3 == 0) {
+        is_audio_sample_ready = sampleAudio();
+        bus.cpu_clock_counter += 1;
+
+        // The cartridge IRQ line is level triggered, the CPU takes it between instructions
+        // until the mapper acknowledges it
+        if (cart_->isIRQ() && cpu_.complete()) {
+            cpu_.irq();
+        }
     }
 
     // The PPU is capable of emitting an interrupt to indicate the
     // vertical blanking period has been entered.
-    if (ppu_.nmi) {
-        ppu_.nmi = false;
+    if (ppu_.isNMI()) {
+        ppu_.clearNMI();
         cpu_.nmi();
     }
 
-    sys_clock_counter_ += 1;
+    bus.sys_clock_counter += 1;
 
     return is_audio_sample_ready;
 }
 
-void Bus::setAudioSampleFrequency(uint32_t sample_rate)
+bool Bus::clockPlayer()
 {
-    audio_time_in_sys_sample_ = 1.0 / static_cast<double>(sample_rate);
-    // NES Dev wiki - NTSC video: https://www.nesdev.org/wiki/NTSC_video
-    //
-    // The NTSC master clock is 21.47727273 MHz and each PPU pixel lasts
-    // four of these clocks: 186ns.
-    audio_time_in_nes_clock_ = 1.0 / 5369318.1825; // PPU Clock Frequency
+    // PLAY only starts once the previous routine has returned to the idle loop, a late PLAY
+    // delays the next ones
+    if (cpu_.complete() && cpu_.pc() == NSF::IDLE_ADDR
+        && (state_.bus.cpu_clock_counter << 16) >= nsf_next_play_) {
+        cpu_.call(nsf_->playAddr(), NSF::IDLE_ADDR, cpu_.a(), cpu_.x());
+        nsf_next_play_ += nsf_play_period_;
+        ppu_.setFrameState(true);
+    }
+    cpu_.clock();
+
+    bool is_audio_sample_ready = sampleAudio();
+    state_.bus.cpu_clock_counter += 1;
+    state_.bus.sys_clock_counter += 3;
+    return is_audio_sample_ready;
+}
+
+// The APU synthesizes samples at the host rate and only catches up with the CPU when one is due
+bool Bus::sampleAudio()
+{
+    if (state_.bus.cpu_clock_counter < apu_.nextSampleClock()) {
+        return false;
+    }
+    apu_.syncTo(state_.bus.cpu_clock_counter);
+    audio_sample_ = apu_.readSample();
+    if (audio_sink_ != nullptr) {
+        audio_batch_.push_back(static_cast<float>(audio_sample_));
+    }
+    if (apu_.isStemOutput()) {
+        for (uint8_t ch = 0; ch < APU::CHANNEL_COUNT; ch += 1) {
+            if (stem_sinks_[ch] != nullptr) {
+                stem_batches_[ch].push_back(
+                    static_cast<float>(apu_.stemSample(static_cast<APU::Channel>(ch))));
+            }
+        }
+    }
+    if (++audio_batch_count_ == AUDIO_BATCH_SIZE) {
+        flushAudio();
+    }
+    return true;
+}
+
+void Bus::setAudioSampleFrequency(uint32_t sample_rate) { apu_.setSampleRate(sample_rate); }
+
+void Bus::setAudioSink(AudioSink *sink)
+{
+    flushAudio();
+    audio_sink_ = sink;
+    if (audio_sink_ != nullptr) {
+        audio_batch_.reserve(AUDIO_BATCH_SIZE);
+        setAudioSampleFrequency(audio_sink_->sampleRate());
+    }
+}
+
+void Bus::setAudioMuteMask(uint8_t mask)
+{
+    apu_.syncTo(state_.bus.cpu_clock_counter);
+    apu_.setMuteMask(mask);
+}
+
+void Bus::setAudioSoloMask(uint8_t mask)
+{
+    apu_.syncTo(state_.bus.cpu_clock_counter);
+    apu_.setSoloMask(mask);
+}
+
+void Bus::setAudioStemSink(APU::Channel channel, AudioSink *sink)
+{
+    flushAudio();
+    stem_sinks_[channel] = sink;
+    stem_batches_[channel].reserve(AUDIO_BATCH_SIZE);
+    bool is_stem_output = std::any_of(stem_sinks_.begin(), stem_sinks_.end(),
+                                      [](AudioSink *stem) { return stem != nullptr; });
+    if (is_stem_output != apu_.isStemOutput()) {
+        apu_.syncTo(state_.bus.cpu_clock_counter);
+        apu_.setStemOutput(is_stem_output);
+    }
+}
+
+void Bus::flushAudio()
+{
+    if (audio_sink_ != nullptr && !audio_batch_.empty()) {
+        audio_sink_->write(audio_batch_.data(), audio_batch_.size());
+    }
+    audio_batch_.clear();
+    for (uint8_t ch = 0; ch < APU::CHANNEL_COUNT; ch += 1) {
+        if (stem_sinks_[ch] != nullptr && !stem_batches_[ch].empty()) {
+            stem_sinks_[ch]->write(stem_batches_[ch].data(), stem_batches_[ch].size());
+        }
+        stem_batches_[ch].clear();
+    }
+    audio_batch_count_ = 0;
 }
 
 } // namespace tn
\ No newline at end of file
@@ -1,105 +1,356 @@
 #include "tinynes/cartridge.h"
+#include "tinynes/crc32.h"
 #include "tinynes/mappers/mapper000.h"
+#include "tinynes/mappers/mapper001.h"
+#include "tinynes/mappers/mapper002.h"
+#include "tinynes/mappers/mapper003.h"
+#include "tinynes/mappers/mapper004.h"
+#include "tinynes/mappers/mapper007.h"
+#include "tinynes/rom_database.h"
+#include "tinynes/rom_image.h"
+#include "tinynes/save_file.h"
+#include "tinynes/state_stream.h"
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <spdlog/spdlog.h>
 
 namespace tn
 {
 
-Cartridge::Cartridge(std::string_view filename)
+namespace
+{
+
+// NES 2.0 ROM sizes, the exponent-multiplier notation is used when the MSB nibble is $F
+uint32_t nes2RomSize(uint8_t lsb, uint8_t msb, uint32_t unit)
 {
-    std::ifstream ifs;
+    if (msb != 0x0F) {
+        return ((msb << 8) | lsb) * unit;
+    }
+    uint8_t exponent = lsb >> 2;
+    if (exponent > 29) {
+        return UINT32_MAX;
+    }
+    return (1u << exponent) * ((lsb & 0x03) * 2 + 1);
+}
 
-    ifs.open(filename.data(), std::ifstream::binary);
-    if (ifs.is_open()) {
-        // read file header
-        ifs.read(reinterpret_cast<char *>(&header_), sizeof(INESHeader));
+// NES 2.0 RAM sizes are shift counts, 64 << n bytes or none for 0
+uint32_t nes2RamSize(uint8_t shift) { return shift == 0 ? 0 : 64u << shift; }
 
-        // escape trainer to acquire PRG ROM data and CHR ROM data
-        if ((header_.mapper1 & (1 << 2)) != 0) {
-            ifs.seekg(512, std::ifstream::cur);
-        }
+} // namespace
 
-        // assemble mapper id
-        mapper_id_ = (header_.mapper2 & 0xF0) | (header_.mapper1 >> 4);
-        mirror = (header_.mapper1 & 0x01) != 0 ? VERTICAL : HORIZONTAL;
+Cartridge::Cartridge(std::string_view filename)
+{
+    rom_ = RomImage::load(filename);
+    if (rom_ == nullptr) {
+        return;
+    }
+    if (!readHeader(rom_->data(), rom_->size(), info_)) {
+        spdlog::error("Cartridge {} is not a valid iNES file", filename);
+        return;
+    }
+    // the image keeps the checksum, a game already loaded is not hashed again
+    info_.crc = rom_->crc(romOffset(info_), info_.prg_rom_size + info_.chr_rom_size);
+    applyDatabase(info_);
+    mirror = info_.mirror;
 
-        INESFileFormat format = INESFileFormat::iNES1d0;
+    // escape trainer to acquire PRG ROM data and CHR ROM data, ROM is used in place
+    prg_rom_ = rom_->data() + romOffset(info_);
+    prg_rom_size_ = info_.prg_rom_size;
+    chr_rom_ = info_.chr_rom_size > 0 ? prg_rom_ + prg_rom_size_ : nullptr;
+    chr_rom_size_ = info_.chr_rom_size;
 
-        switch (format) {
-        case INESFileFormat::iNES1d0:
-        {
-            prg_banks_num_ = header_.prg_rom_size;
-            prg_mem_.resize(prg_banks_num_ * 16 * 1024);
-            ifs.read(reinterpret_cast<char *>(prg_mem_.data()), prg_mem_.size());
+    if (info_.is_four_screen) {
+        spdlog::warn("Cartridge four-screen mirroring is not supported");
+    }
 
-            chr_banks_num_ = header_.chr_rom_size;
-            // allocate RAM for CHR memory
-            if (chr_banks_num_ == 0) {
-                chr_mem_.resize(8 * 1024);
-            }
-            // allocate space for CHR ROM
-            else {
-                chr_mem_.resize(chr_banks_num_ * 8 * 1024);
+    prg_banks_num_ = static_cast<uint8_t>(std::min<uint32_t>(prg_rom_size_ / (16 * 1024), 255));
+    chr_banks_num_ = static_cast<uint8_t>(std::min<uint32_t>(chr_rom_size_ / (8 * 1024), 255));
+    // allocate RAM for CHR memory
+    if (chr_rom_size_ == 0) {
+        chr_ram_.resize(std::max<uint32_t>(info_.chr_ram_size + info_.chr_nvram_size, 8 * 1024));
+        is_chr_ram_ = true;
+    }
+    // volatile and battery backed PRG RAM share the $6000-$7FFF window, smaller chips are
+    // mirrored to fill it. With a battery the whole window is kept in <rom>.sav.
+    if (info_.prg_ram_size + info_.prg_nvram_size > 0) {
+        prg_ram_size_ = std::max<uint32_t>(info_.prg_ram_size + info_.prg_nvram_size, 8 * 1024);
+        if (info_.prg_nvram_size > 0) {
+            std::string save_name
+                = std::filesystem::path(filename).replace_extension(".sav").string();
+            save_ = std::make_shared<SaveFile>(save_name, prg_ram_size_);
+            if (!save_->isOpen()) {
+                spdlog::warn("Cartridge battery RAM will not be saved");
+                save_.reset();
+                // start from the last save anyway, e.g. while another instance runs the game
+                prg_ram_buffer_.resize(prg_ram_size_);
+                std::ifstream ifs(save_name, std::ifstream::binary);
+                ifs.read(reinterpret_cast<char *>(prg_ram_buffer_.data()), prg_ram_size_);
             }
-            ifs.read(reinterpret_cast<char *>(chr_mem_.data()), chr_mem_.size());
-            break;
         }
-        // <https://www.nesdev.org/wiki/NES_2.0>
-        case INESFileFormat::NES2d0:
-        {
-            break;
+        if (save_ != nullptr) {
+            prg_ram_ = save_->data();
         }
+        else {
+            prg_ram_buffer_.resize(prg_ram_size_);
+            prg_ram_ = prg_ram_buffer_.data();
         }
+    }
 
-        switch (mapper_id_) {
-        case 0:
-            spdlog::info("Cartridge load mapper000");
-            mapper_ = std::make_shared<Mapper000>(prg_banks_num_, chr_banks_num_);
-            break;
-        }
-        is_file_loaded_ = true;
-        ifs.close();
+    switch (info_.mapper) {
+    case 0:
+        spdlog::info("Cartridge load mapper000");
+        mapper_ = std::make_shared<Mapper000>(prg_banks_num_, chr_banks_num_);
+        break;
+    case 1:
+        spdlog::info("Cartridge load mapper001");
+        mapper_ = std::make_shared<Mapper001>(prg_banks_num_, chr_banks_num_);
+        break;
+    case 2:
+        spdlog::info("Cartridge load mapper002");
+        mapper_ = std::make_shared<Mapper002>(prg_banks_num_, chr_banks_num_);
+        break;
+    case 3:
+        spdlog::info("Cartridge load mapper003");
+        mapper_ = std::make_shared<Mapper003>(prg_banks_num_, chr_banks_num_);
+        break;
+    case 4:
+        spdlog::info("Cartridge load mapper004");
+        mapper_ = std::make_shared<Mapper004>(prg_banks_num_, chr_banks_num_);
+        break;
+    case 7:
+        spdlog::info("Cartridge load mapper007");
+        mapper_ = std::make_shared<Mapper007>(prg_banks_num_, chr_banks_num_);
+        break;
+    default:
+        spdlog::error("Cartridge mapper{:03d} is not supported", info_.mapper);
+        return;
     }
+    mapper_->attach(this);
+    is_file_loaded_ = true;
 }
 
-bool Cartridge::cpuRead(uint16_t addr, uint8_t &data)
+bool Cartridge::readInfo(const uint8_t *data, std::size_t size, Info &info)
 {
-    uint32_t mapped_addr = 0;
-    if (mapper_->cpuMapRead(addr, mapped_addr)) {
-        data = prg_mem_[mapped_addr];
-        return true;
+    if (!readHeader(data, size, info)) {
+        return false;
     }
-    return false;
+    // the checksum identifies the dump in the ROM database
+    info.crc = crc32(data + romOffset(info), info.prg_rom_size + info.chr_rom_size);
+    applyDatabase(info);
+    return true;
+}
+
+bool Cartridge::readHeader(const uint8_t *data, std::size_t size, Info &info)
+{
+    if (size < sizeof(INESHeader) || std::memcmp(data, "NES\x1A", 4) != 0) {
+        return false;
+    }
+    INESHeader header;
+    std::memcpy(&header, data, sizeof(INESHeader));
+    info = Info{};
+    info.has_trainer = (header.mapper1 & 0x04) != 0;
+    info.has_battery = (header.mapper1 & 0x02) != 0;
+    info.is_four_screen = (header.mapper1 & 0x08) != 0;
+    info.mirror = (header.mapper1 & 0x01) != 0 ? VERTICAL : HORIZONTAL;
+    if ((header.mapper2 & 0x0C) == 0x08) {
+        parseNES2(header, info);
+    }
+    else {
+        parseINES(header, info);
+    }
+
+    // NES 2.0 exponent sizes can be as small as a byte, the mappers switch whole windows and
+    // have nothing to divide the bank numbers by unless the ROM holds at least one
+    bool is_whole_windows = info.prg_rom_size > 0 && info.prg_rom_size % PRG_BANK_SIZE == 0
+                            && info.chr_rom_size % CHR_BANK_SIZE == 0;
+    return is_whole_windows
+           && size >= romOffset(info) + uint64_t{info.prg_rom_size} + info.chr_rom_size;
+}
+
+void Cartridge::parseINES(const INESHeader &header, Info &info)
+{
+    // Old tools wrote signatures like "DiskDude!" over bytes 7-15, those bytes can only be trusted
+    // when the last four are clear
+    bool is_dirty = (header.ext[4] | header.ext[5] | header.ext[6] | header.ext[7]) != 0;
+    info.mapper = (is_dirty ? 0 : (header.mapper2 & 0xF0)) | (header.mapper1 >> 4);
+    info.prg_rom_size = header.prg_rom_size * 16 * 1024;
+    info.chr_rom_size = header.chr_rom_size * 8 * 1024;
+    info.chr_ram_size = info.chr_rom_size == 0 ? 8 * 1024 : 0;
+
+    // PRG RAM in 8 KiB units, 0 infers 8 KiB for compatibility
+    uint32_t prg_ram_size = (is_dirty || header.ext[0] == 0 ? 1 : header.ext[0]) * 8 * 1024;
+    if (info.has_battery) {
+        info.prg_nvram_size = prg_ram_size;
+    }
+    else {
+        info.prg_ram_size = prg_ram_size;
+    }
+    info.region = !is_dirty && (header.ext[1] & 0x01) != 0 ? Region::PAL : Region::NTSC;
 }
+
+void Cartridge::parseNES2(const INESHeader &header, Info &info)
+{
+    info.is_nes2 = true;
+    info.mapper = ((header.ext[0] & 0x0F) << 8) | (header.mapper2 & 0xF0) | (header.mapper1 >> 4);
+    info.submapper = header.ext[0] >> 4;
+    info.prg_rom_size = nes2RomSize(header.prg_rom_size, header.ext[1] & 0x0F, 16 * 1024);
+    info.chr_rom_size = nes2RomSize(header.chr_rom_size, header.ext[1] >> 4, 8 * 1024);
+    info.prg_ram_size = nes2RamSize(header.ext[2] & 0x0F);
+    info.prg_nvram_size = nes2RamSize(header.ext[2] >> 4);
+    info.chr_ram_size = nes2RamSize(header.ext[3] & 0x0F);
+    info.chr_nvram_size = nes2RamSize(header.ext[3] >> 4);
+    info.region = static_cast<Region>(header.ext[4] & 0x03);
+}
+
+void Cartridge::applyDatabase(Info &info)
+{
+    const RomDatabaseEntry *entry = findRomDatabaseEntry(info.crc);
+    if (entry == nullptr) {
+        return;
+    }
+    info.is_database_match = true;
+
+    MIRROR db_mirror = entry->mirror == 1 ? VERTICAL : HORIZONTAL;
+    uint32_t prg_ram_size = nes2RamSize(entry->prg_ram_shift);
+    uint32_t prg_nvram_size = nes2RamSize(entry->prg_nvram_shift);
+    bool is_corrected = info.mapper != entry->mapper || info.submapper != entry->submapper
+                        || info.mirror != db_mirror || info.is_four_screen != (entry->mirror == 2)
+                        || info.prg_ram_size != prg_ram_size
+                        || info.prg_nvram_size != prg_nvram_size
+                        || info.region != static_cast<Region>(entry->region);
+    if (is_corrected) {
+        spdlog::info("Cartridge header of {:08X} corrected by the ROM database", info.crc);
+    }
+
+    info.mapper = entry->mapper;
+    info.submapper = entry->submapper;
+    info.mirror = db_mirror;
+    info.is_four_screen = entry->mirror == 2;
+    info.prg_ram_size = prg_ram_size;
+    info.prg_nvram_size = prg_nvram_size;
+    info.has_battery = prg_nvram_size > 0;
+    if (info.chr_rom_size == 0) {
+        info.chr_ram_size = nes2RamSize(entry->chr_ram_shift);
+    }
+    info.region = static_cast<Region>(entry->region);
+}
+
 bool Cartridge::cpuWrite(uint16_t addr, uint8_t data)
 {
-    uint32_t mapped_addr = 0;
-    if (mapper_->cpuMapWrite(addr, mapped_addr, data)) {
-        prg_mem_[mapped_addr] = data;
+    if (addr >= 0x8000) {
+        mapper_->cpuWriteRegister(addr, data);
+        return true;
+    }
+    if (addr >= 0x6000 && prg_banks_[0] != nullptr) {
+        if (prg_ram_write_ != nullptr) {
+            prg_ram_write_[addr & 0x1FFF] = data;
+            if (save_ != nullptr) {
+                save_->markDirty();
+            }
+        }
         return true;
     }
     return false;
 }
 
-bool Cartridge::ppuRead(uint16_t addr, uint8_t &data)
+void Cartridge::ppuA12Rise() { mapper_->ppuA12Rise(); }
+
+void Cartridge::mapPRG(uint8_t slot, int bank, uint8_t count)
 {
-    uint32_t mapped_addr = 0;
-    if (mapper_->ppuMapRead(addr, mapped_addr)) {
-        data = chr_mem_[mapped_addr];
-        return true;
+    int windows = static_cast<int>(prg_rom_size_ / PRG_BANK_SIZE);
+    int banks = std::max(windows / count, 1);
+    bank = ((bank % banks) + banks) % banks;
+    for (uint8_t idx = 0; idx < count; idx += 1) {
+        int window = (bank * count + idx) % windows;
+        // slot 0 of the table is PRG RAM at $6000
+        prg_banks_[1 + slot + idx] = prg_rom_ + window * PRG_BANK_SIZE;
     }
-    return false;
 }
-bool Cartridge::ppuWrite(uint16_t addr, uint8_t data)
+
+void Cartridge::mapCHR(uint8_t slot, int bank, uint8_t count)
 {
-    uint32_t mapped_addr = 0;
-    if (mapper_->ppuMapRead(addr, mapped_addr)) {
-        chr_mem_[mapped_addr] = data;
-        return true;
+    uint32_t size = is_chr_ram_ ? static_cast<uint32_t>(chr_ram_.size()) : chr_rom_size_;
+    int windows = static_cast<int>(size / CHR_BANK_SIZE);
+    int banks = std::max(windows / count, 1);
+    bank = ((bank % banks) + banks) % banks;
+    for (uint8_t idx = 0; idx < count; idx += 1) {
+        uint32_t offset = ((bank * count + idx) % windows) * CHR_BANK_SIZE;
+        const uint8_t *window = (is_chr_ram_ ? chr_ram_.data() : chr_rom_) + offset;
+        // mappers like MMC3 rewrite their banks every frame, mostly with the same values
+        if (chr_banks_[slot + idx] == window) {
+            continue;
+        }
+        chr_map_generation_ += 1;
+        if (is_chr_ram_) {
+            chr_banks_[slot + idx] = chr_write_banks_[slot + idx] = chr_ram_.data() + offset;
+        }
+        else {
+            chr_banks_[slot + idx] = chr_rom_ + offset;
+            chr_write_banks_[slot + idx] = nullptr;
+        }
     }
-    return false;
+}
+
+void Cartridge::mapPRGRAM(bool is_enable, bool is_writable)
+{
+    // boards without PRG RAM leave $6000-$7FFF open
+    is_enable = is_enable && prg_ram_ != nullptr;
+    prg_banks_[0] = is_enable ? prg_ram_ : nullptr;
+    prg_ram_write_ = is_enable && is_writable ? prg_ram_ : nullptr;
+}
+
+std::shared_ptr<Cartridge> Cartridge::clone() const
+{
+    auto cart = std::make_shared<Cartridge>(*this);
+    // only the original cartridge writes the save file, copies work on private RAM
+    if (save_ != nullptr) {
+        cart->save_.reset();
+        cart->prg_ram_buffer_.assign(prg_ram_, prg_ram_ + prg_ram_size_);
+    }
+    if (cart->prg_ram_ != nullptr) {
+        cart->prg_ram_ = cart->prg_ram_buffer_.data();
+    }
+    if (mapper_ != nullptr) {
+        // the bank tables still point into our RAM
+        cart->mapper_ = mapper_->clone();
+        cart->mapper_->attach(cart.get());
+    }
+    return cart;
+}
+
+void Cartridge::saveState(StateWriter &writer) const
+{
+    writer.put(static_cast<uint8_t>(mirror));
+    writer.put(is_irq_);
+    writer.write(prg_ram_, prg_ram_size_);
+    if (is_chr_ram_) {
+        writer.write(chr_ram_.data(), chr_ram_.size());
+    }
+    if (mapper_ != nullptr) {
+        mapper_->saveState(writer);
+    }
+}
+
+void Cartridge::loadState(StateReader &reader)
+{
+    auto saved_mirror = static_cast<MIRROR>(reader.get<uint8_t>());
+    is_irq_ = reader.get<bool>();
+    reader.read(prg_ram_, prg_ram_size_);
+    if (save_ != nullptr) {
+        save_->markDirty();
+    }
+    if (is_chr_ram_) {
+        reader.read(chr_ram_.data(), chr_ram_.size());
+    }
+    if (mapper_ != nullptr) {
+        mapper_->loadState(reader);
+        mapper_->attach(this);
+    }
+    // not every mapper derives the mirroring from its registers
+    mirror = saved_mirror;
 }
 
 void Cartridge::reset()
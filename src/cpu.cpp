@@ -7,15 +7,23 @@
 namespace tn
 {
 
+CPU::CPU(State *state) : state_(state)
+{
+    if (state_ == nullptr) {
+        own_state_ = std::make_unique<State>();
+        state_ = own_state_.get();
+    }
+}
+
 // STATUS FLAG FUNCTION
-bool CPU::getFlag(FLAGS6502 f) { return (reg_.status & f) > 0; }
+bool CPU::getFlag(FLAGS6502 f) { return (state_->reg.status & f) > 0; }
 void CPU::setFlag(FLAGS6502 f, bool v)
 {
     if (v) {
-        reg_.status |= f;
+        state_->reg.status |= f;
     }
     else {
-        reg_.status &= ~f;
+        state_->reg.status &= ~f;
     }
 }
 
@@ -27,26 +35,26 @@ void CPU::write(uint16_t addr, uint8_t data) { bus_->cpuWrite(addr, data); }
 // CPU power up state: <https://www.nesdev.org/wiki/CPU_power_up_state#cite_note-2>
 void CPU::reset()
 {
-    addr_abs_ = RESET_VECTOR;
-    uint16_t lo = read(addr_abs_);
-    uint16_t hi = read(addr_abs_ + 1);
-    reg_.pc = (hi << 8) | lo;
+    state_->addr_abs = RESET_VECTOR;
+    uint16_t lo = read(state_->addr_abs);
+    uint16_t hi = read(state_->addr_abs + 1);
+    state_->reg.pc = (hi << 8) | lo;
 
-    reg_.st = 0xFD;
-    reg_.status = 0x00 | U;
+    state_->reg.st = 0xFD;
+    state_->reg.status = 0x00 | U;
 
     // reset internal register
-    reg_.a = 0;
-    reg_.x = 0;
-    reg_.y = 0;
+    state_->reg.a = 0;
+    state_->reg.x = 0;
+    state_->reg.y = 0;
 
     // Clear internal variables
-    addr_rel_ = 0x0000;
-    addr_abs_ = 0x0000;
-    fetched_ = 0x00;
+    state_->addr_rel = 0x0000;
+    state_->addr_abs = 0x0000;
+    state_->fetched = 0x00;
 
     // Reset takes time
-    cycles_ = 8;
+    state_->cycles = 8;
 }
 
 // CPU interrupts: <https://www.nesdev.org/wiki/CPU_interrupts>
@@ -55,29 +63,30 @@ void CPU::reset()
 void CPU::irq()
 {
     // If interrupts are allowed
-    if (getFlag(I)) {
+    if (!getFlag(I)) {
         // push PCH on stack, decrement stack pointer
-        write(0x100 + reg_.st, (reg_.pc >> 8) & 0x00FF);
-        reg_.st -= 1;
+        write(0x100 + state_->reg.st, (state_->reg.pc >> 8) & 0x00FF);
+        state_->reg.st -= 1;
         // push PCL on stack, decrement stack pointer
-        write(0x100 + reg_.st, reg_.pc & 0x00FF);
-        reg_.st -= 1;
+        write(0x100 + state_->reg.st, state_->reg.pc & 0x00FF);
+        state_->reg.st -= 1;
 
-        // push status register on stack, decrement stack pointer
+        // push status register on stack, decrement stack pointer. I is set after the push so
+        // that RTI enables interrupts again.
         setFlag(B, false);
         setFlag(U, true); // always set to 1
+        write(0x100 + state_->reg.st, state_->reg.status);
+        state_->reg.st -= 1;
         setFlag(I, true); // set I flag to clear interrupt state
-        write(0x100 + reg_.st, reg_.status);
-        reg_.st -= 1;
 
         // fetch PCL and PCH from IRQ vector address
-        addr_abs_ = IRQ_VECTOR;
-        uint16_t lo = read(addr_abs_);
-        uint16_t hi = read(addr_abs_ + 1);
-        reg_.pc = (hi << 8) | lo;
+        state_->addr_abs = IRQ_VECTOR;
+        uint16_t lo = read(state_->addr_abs);
+        uint16_t hi = read(state_->addr_abs + 1);
+        state_->reg.pc = (hi << 8) | lo;
 
         // IRQ time cycles
-        cycles_ = 7;
+        state_->cycles = 7;
     }
 }
 
@@ -85,55 +94,73 @@ void CPU::irq()
 void CPU::nmi()
 {
     // push PCH on stack, decrement stack pointer
-    write(0x100 + reg_.st, (reg_.pc >> 8) & 0x00FF);
-    reg_.st -= 1;
+    write(0x100 + state_->reg.st, (state_->reg.pc >> 8) & 0x00FF);
+    state_->reg.st -= 1;
     // push PCL on stack, decrement stack pointer
-    write(0x100 + reg_.st, reg_.pc & 0x00FF);
-    reg_.st -= 1;
+    write(0x100 + state_->reg.st, state_->reg.pc & 0x00FF);
+    state_->reg.st -= 1;
 
     // push status register on stack, decrement stack pointer
     setFlag(B, false);
     setFlag(U, true); // always set to 1
     setFlag(I, true); // set I flag to clear interrupt state
-    write(0x100 + reg_.st, reg_.status);
-    reg_.st -= 1;
+    write(0x100 + state_->reg.st, state_->reg.status);
+    state_->reg.st -= 1;
 
     // fetch PCL and PCH from NMI vector address
-    addr_abs_ = NMI_VECTOR;
-    uint16_t lo = read(addr_abs_);
-    uint16_t hi = read(addr_abs_ + 1);
-    reg_.pc = (hi << 8) | lo;
+    state_->addr_abs = NMI_VECTOR;
+    uint16_t lo = read(state_->addr_abs);
+    uint16_t hi = read(state_->addr_abs + 1);
+    state_->reg.pc = (hi << 8) | lo;
 
     // NMI time cycles
-    cycles_ = 8;
+    state_->cycles = 8;
+}
+
+void CPU::call(uint16_t addr, uint16_t return_addr, uint8_t a, uint8_t x)
+{
+    // RTS adds one to the address popped from the stack
+    uint16_t pushed_addr = return_addr - 1;
+    write(0x0100 + state_->reg.st, (pushed_addr >> 8) & 0x00FF);
+    state_->reg.st -= 1;
+    write(0x0100 + state_->reg.st, pushed_addr & 0x00FF);
+    state_->reg.st -= 1;
+
+    state_->reg.pc = addr;
+    state_->reg.a = a;
+    state_->reg.x = x;
+    state_->reg.y = 0;
+
+    // JSR time cycles
+    state_->cycles = 6;
 }
 
 void CPU::clock()
 {
     // the next instruction is ready to be executed.
-    if (cycles_ == 0) {
+    if (state_->cycles == 0) {
         // read next instruction byte to acquire the info about how to implement this instruction.
-        opcode_ = read(reg_.pc);
+        state_->opcode = read(state_->reg.pc);
 
         // flag U is always 1
         setFlag(U, true);
-        reg_.pc += 1;
+        state_->reg.pc += 1;
 
         // get next instruction cycles
-        cycles_ = lookup_table_[opcode_].cycles;
+        state_->cycles = lookup_table_[state_->opcode].cycles;
 
-        uint8_t additional_cycle1 = (this->*lookup_table_[opcode_].addrmode)();
-        uint8_t additional_cycle2 = (this->*lookup_table_[opcode_].operate)();
-        cycles_ += (additional_cycle1 & additional_cycle2);
+        uint8_t additional_cycle1 = (this->*lookup_table_[state_->opcode].addrmode)();
+        uint8_t additional_cycle2 = (this->*lookup_table_[state_->opcode].operate)();
+        state_->cycles += (additional_cycle1 & additional_cycle2);
 
         setFlag(U, true);
     }
     // update clock
-    clock_count_ += 1;
-    cycles_ -= 1;
+    state_->clock_count += 1;
+    state_->cycles -= 1;
 }
 
-bool CPU::complete() { return cycles_ == 0; }
+bool CPU::complete() { return state_->cycles == 0; }
 
 void CPU::disassemble(uint16_t addr_begin, uint16_t addr_end, ASMMap &asm_map)
 {
@@ -245,7 +272,7 @@ void CPU::disassemble(uint16_t addr_begin, uint16_t addr_end, ASMMap &asm_map)
 // usage.
 uint8_t CPU::IMP()
 {
-    fetched_ = reg_.a;
+    state_->fetched = state_->reg.a;
     return 0;
 }
 
@@ -255,8 +282,8 @@ uint8_t CPU::IMP()
 // used as a value, so we'll prep the read address to point to the next byte
 uint8_t CPU::IMM()
 {
-    addr_abs_ = reg_.pc;
-    reg_.pc += 1;
+    state_->addr_abs = state_->reg.pc;
+    state_->reg.pc += 1;
     return 0;
 }
 
@@ -268,27 +295,27 @@ uint8_t CPU::IMM()
 uint8_t CPU::ZP0()
 {
     // read the offset value stored in next byte
-    addr_abs_ = read(reg_.pc);
-    addr_abs_ &= 0x00FF;
-    reg_.pc += 1;
+    state_->addr_abs = read(state_->reg.pc);
+    state_->addr_abs &= 0x00FF;
+    state_->reg.pc += 1;
     return 0;
 }
 
 // Mode: Zero page indexed with X, 2 bytes
 uint8_t CPU::ZPX()
 {
-    addr_abs_ = read(reg_.pc) + reg_.x;
-    addr_abs_ &= 0x00FF;
-    reg_.pc += 1;
+    state_->addr_abs = read(state_->reg.pc) + state_->reg.x;
+    state_->addr_abs &= 0x00FF;
+    state_->reg.pc += 1;
     return 0;
 }
 
 // Mode: Zero page indexed with Y, 2 bytes
 uint8_t CPU::ZPY()
 {
-    addr_abs_ = read(reg_.pc) + reg_.y;
-    addr_abs_ &= 0x00FF;
-    reg_.pc += 1;
+    state_->addr_abs = read(state_->reg.pc) + state_->reg.y;
+    state_->addr_abs &= 0x00FF;
+    state_->reg.pc += 1;
     return 0;
 }
 // Mode: Relative, 2 bytes
@@ -296,15 +323,15 @@ uint8_t CPU::ZPY()
 uint8_t CPU::REL()
 {
     // read the signed offset from next byte
-    addr_rel_ = read(reg_.pc);
-    reg_.pc += 1;
+    state_->addr_rel = read(state_->reg.pc);
+    state_->reg.pc += 1;
 
     // 'read' function return an unsigned number. So we need to check the
     // sign bit to determine if the number is negative or not. If it is,
-    // we need to make the 'addr_rel_' represented as a signed 16 bits
+    // we need to make the 'state_->addr_rel' represented as a signed 16 bits
     // negative number.
-    if ((addr_rel_ & 0x80) > 0) {
-        addr_rel_ |= 0xFF00;
+    if ((state_->addr_rel & 0x80) > 0) {
+        state_->addr_rel |= 0xFF00;
     }
     return 0;
 }
@@ -314,11 +341,11 @@ uint8_t CPU::REL()
 // (16 bits can access maximum 64 KB memory address space).
 uint8_t CPU::ABS()
 {
-    uint16_t lo = read(reg_.pc);
-    reg_.pc += 1;
-    uint16_t hi = read(reg_.pc);
-    reg_.pc += 1;
-    addr_abs_ = (hi << 8) | lo;
+    uint16_t lo = read(state_->reg.pc);
+    state_->reg.pc += 1;
+    uint16_t hi = read(state_->reg.pc);
+    state_->reg.pc += 1;
+    state_->addr_abs = (hi << 8) | lo;
     return 0;
 }
 
@@ -326,15 +353,15 @@ uint8_t CPU::ABS()
 // This mode may influence the carry out and generate 'oops' cycle
 uint8_t CPU::ABX()
 {
-    uint16_t lo = read(reg_.pc);
-    reg_.pc += 1;
-    uint16_t hi = read(reg_.pc);
-    reg_.pc += 1;
-    addr_abs_ = (hi << 8) | lo;
-    addr_abs_ += reg_.x;
+    uint16_t lo = read(state_->reg.pc);
+    state_->reg.pc += 1;
+    uint16_t hi = read(state_->reg.pc);
+    state_->reg.pc += 1;
+    state_->addr_abs = (hi << 8) | lo;
+    state_->addr_abs += state_->reg.x;
 
     // previous addition operation change the 'hi' byte, causing carry out.
-    if ((addr_abs_ & 0xFF00) != (hi << 8)) {
+    if ((state_->addr_abs & 0xFF00) != (hi << 8)) {
         return 1;
     }
     return 0;
@@ -344,15 +371,15 @@ uint8_t CPU::ABX()
 // This mode may influence the carry out and generate 'oops' cycle
 uint8_t CPU::ABY()
 {
-    uint16_t lo = read(reg_.pc);
-    reg_.pc += 1;
-    uint16_t hi = read(reg_.pc);
-    reg_.pc += 1;
-    addr_abs_ = (hi << 8) | lo;
-    addr_abs_ += reg_.y;
+    uint16_t lo = read(state_->reg.pc);
+    state_->reg.pc += 1;
+    uint16_t hi = read(state_->reg.pc);
+    state_->reg.pc += 1;
+    state_->addr_abs = (hi << 8) | lo;
+    state_->addr_abs += state_->reg.y;
 
     // previous addition operation change the 'hi' byte, causing carry out.
-    if ((addr_abs_ & 0xFF00) != (hi << 8)) {
+    if ((state_->addr_abs & 0xFF00) != (hi << 8)) {
         return 1;
     }
     return 0;
@@ -362,18 +389,18 @@ uint8_t CPU::ABY()
 // The supplied 16-bit address is read to get the actual 16-bit address.
 uint8_t CPU::IND()
 {
-    uint16_t ptr_lo = read(reg_.pc);
-    reg_.pc += 1;
-    uint16_t ptr_hi = read(reg_.pc);
-    reg_.pc += 1;
+    uint16_t ptr_lo = read(state_->reg.pc);
+    state_->reg.pc += 1;
+    uint16_t ptr_hi = read(state_->reg.pc);
+    state_->reg.pc += 1;
     uint16_t ptr = (ptr_hi << 8) | ptr_lo;
 
     // we may encounter page boundary fault because next byte may cross two pages
     if (ptr_lo == 0x00FF) {
-        addr_abs_ = (read(ptr & 0xFF00) << 8) | read(ptr);
+        state_->addr_abs = (read(ptr & 0xFF00) << 8) | read(ptr);
     }
     else {
-        addr_abs_ = (read(ptr + 1) << 8) | read(ptr);
+        state_->addr_abs = (read(ptr + 1) << 8) | read(ptr);
     }
     return 0;
 }
@@ -382,13 +409,13 @@ uint8_t CPU::IND()
 // The 8 bits X offset directly adds to read pointer address
 uint8_t CPU::IZX()
 {
-    uint16_t ptr = read(reg_.pc);
-    reg_.pc += 1;
+    uint16_t ptr = read(state_->reg.pc);
+    state_->reg.pc += 1;
 
-    uint16_t lo = read((ptr + static_cast<uint16_t>(reg_.x)) & 0x00FF);
-    uint16_t hi = read((ptr + static_cast<uint16_t>(reg_.x) + 1) & 0x00FF);
+    uint16_t lo = read((ptr + static_cast<uint16_t>(state_->reg.x)) & 0x00FF);
+    uint16_t hi = read((ptr + static_cast<uint16_t>(state_->reg.x) + 1) & 0x00FF);
 
-    addr_abs_ = (hi << 8) | lo;
+    state_->addr_abs = (hi << 8) | lo;
     return 0;
 }
 
@@ -397,16 +424,16 @@ uint8_t CPU::IZX()
 // This operation may result in page crossing and need to add 'oops' cycle.
 uint8_t CPU::IZY()
 {
-    uint16_t ptr = read(reg_.pc);
-    reg_.pc += 1;
+    uint16_t ptr = read(state_->reg.pc);
+    state_->reg.pc += 1;
 
     uint16_t lo = read(ptr & 0x00FF);
     uint16_t hi = read((ptr + 1) & 0x00FF);
 
-    addr_abs_ = (hi << 8) | lo;
-    addr_abs_ += reg_.y;
+    state_->addr_abs = (hi << 8) | lo;
+    state_->addr_abs += state_->reg.y;
 
-    if ((addr_abs_ & 0xFF00) != (hi << 8)) {
+    if ((state_->addr_abs & 0xFF00) != (hi << 8)) {
         return 1;
     }
     return 0;
@@ -414,13 +441,13 @@ uint8_t CPU::IZY()
 
 // Some instruction like PHA(push accumulator), implied type, have no additional data
 // required. What we need to do is getting data from accumulator. For other instructions,
-// the data is stored in the 'addr_abs_'. So just read from it.
+// the data is stored in the 'state_->addr_abs'. So just read from it.
 uint8_t CPU::fetch()
 {
-    if (!(lookup_table_[opcode_].addrmode == &CPU::IMP)) {
-        fetched_ = read(addr_abs_);
+    if (!(lookup_table_[state_->opcode].addrmode == &CPU::IMP)) {
+        state_->fetched = read(state_->addr_abs);
     }
-    return fetched_;
+    return state_->fetched;
 }
 
 // INSTRUCTION IMPLEMENTATIONS
@@ -454,17 +481,17 @@ uint8_t CPU::ADC()
     fetch();
 
     // A + M + C
-    temp_ = static_cast<uint16_t>(reg_.a) + static_cast<uint16_t>(fetched_)
-            + static_cast<uint16_t>(getFlag(C));
-
-    setFlag(C, temp_ > 0xFF);
-    setFlag(N, (temp_ & 0x80) != 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
-    setFlag(V, ((~(static_cast<uint16_t>(reg_.a) ^ static_cast<uint16_t>(fetched_))
-                 & (static_cast<uint16_t>(reg_.a) ^ temp_))
+    state_->temp = static_cast<uint16_t>(state_->reg.a) + static_cast<uint16_t>(state_->fetched)
+                   + static_cast<uint16_t>(getFlag(C));
+
+    setFlag(C, state_->temp > 0xFF);
+    setFlag(N, (state_->temp & 0x80) != 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
+    setFlag(V, ((~(static_cast<uint16_t>(state_->reg.a) ^ static_cast<uint16_t>(state_->fetched))
+                 & (static_cast<uint16_t>(state_->reg.a) ^ state_->temp))
                 & 0x0080)
                    != 0);
-    reg_.a = temp_ & 0x00FF;
+    state_->reg.a = state_->temp & 0x00FF;
 
     // potentially require 'oops' cycle if page boundary crossed
     return 1;
@@ -477,10 +504,10 @@ uint8_t CPU::AND()
 {
     fetch();
 
-    reg_.a = reg_.a & fetched_;
+    state_->reg.a = state_->reg.a & state_->fetched;
 
-    setFlag(Z, reg_.a == 0);
-    setFlag(N, (reg_.a & 0x80) != 0);
+    setFlag(Z, state_->reg.a == 0);
+    setFlag(N, (state_->reg.a & 0x80) != 0);
 
     return 1;
 }
@@ -492,18 +519,18 @@ uint8_t CPU::ASL()
 {
     fetch();
 
-    temp_ = static_cast<uint16_t>(fetched_) << 1;
+    state_->temp = static_cast<uint16_t>(state_->fetched) << 1;
 
-    setFlag(C, (temp_ & 0xFF00) > 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
-    setFlag(N, (temp_ & 0x80) != 0);
+    setFlag(C, (state_->temp & 0xFF00) > 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
+    setFlag(N, (state_->temp & 0x80) != 0);
 
     // write back to source, accumulator or memory
-    if (lookup_table_[opcode_].addrmode == &CPU::IMP) {
-        reg_.a = temp_ & 0x00FF;
+    if (lookup_table_[state_->opcode].addrmode == &CPU::IMP) {
+        state_->reg.a = state_->temp & 0x00FF;
     }
     else {
-        write(addr_abs_, temp_ & 0x00FF);
+        write(state_->addr_abs, state_->temp & 0x00FF);
     }
 
     return 0;
@@ -514,13 +541,13 @@ uint8_t CPU::ASL()
 uint8_t CPU::BCC()
 {
     if (!getFlag(C)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -530,13 +557,13 @@ uint8_t CPU::BCC()
 uint8_t CPU::BCS()
 {
     if (getFlag(C)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -546,13 +573,13 @@ uint8_t CPU::BCS()
 uint8_t CPU::BEQ()
 {
     if (getFlag(Z)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -569,10 +596,10 @@ uint8_t CPU::BIT()
 {
     fetch();
 
-    temp_ = reg_.a & fetched_;
-    setFlag(Z, (temp_ & 0x00FF) == 0);
-    setFlag(N, (fetched_ & (1 << 7)) != 0);
-    setFlag(V, (fetched_ & (1 << 6)) != 0);
+    state_->temp = state_->reg.a & state_->fetched;
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
+    setFlag(N, (state_->fetched & (1 << 7)) != 0);
+    setFlag(V, (state_->fetched & (1 << 6)) != 0);
 
     return 0;
 }
@@ -582,13 +609,13 @@ uint8_t CPU::BIT()
 uint8_t CPU::BMI()
 {
     if (getFlag(N)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -598,13 +625,13 @@ uint8_t CPU::BMI()
 uint8_t CPU::BNE()
 {
     if (!getFlag(Z)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -614,13 +641,13 @@ uint8_t CPU::BNE()
 uint8_t CPU::BPL()
 {
     if (!getFlag(N)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -638,21 +665,21 @@ uint8_t CPU::BPL()
 // Condition code: B(virtual), I(1)
 uint8_t CPU::BRK()
 {
-    reg_.pc += 1;
+    state_->reg.pc += 1;
 
     setFlag(I, true);
-    write(0x100 + reg_.st, (reg_.pc >> 8) & 0x00FF);
-    reg_.st -= 1;
-    write(0x100 + reg_.st, reg_.pc & 0x00FF);
-    reg_.st -= 1;
+    write(0x100 + state_->reg.st, (state_->reg.pc >> 8) & 0x00FF);
+    state_->reg.st -= 1;
+    write(0x100 + state_->reg.st, state_->reg.pc & 0x00FF);
+    state_->reg.st -= 1;
 
     setFlag(B, true);
-    write(0x100 + reg_.st, reg_.status);
-    reg_.st -= 1;
+    write(0x100 + state_->reg.st, state_->reg.status);
+    state_->reg.st -= 1;
     setFlag(B, false);
 
-    reg_.pc = static_cast<uint16_t>(read(IRQ_VECTOR))
-              | (static_cast<uint16_t>(read(IRQ_VECTOR + 1)) << 8);
+    state_->reg.pc = static_cast<uint16_t>(read(IRQ_VECTOR))
+                     | (static_cast<uint16_t>(read(IRQ_VECTOR + 1)) << 8);
 
     return 0;
 }
@@ -662,13 +689,13 @@ uint8_t CPU::BRK()
 uint8_t CPU::BVC()
 {
     if (!getFlag(V)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -678,13 +705,13 @@ uint8_t CPU::BVC()
 uint8_t CPU::BVS()
 {
     if (getFlag(V)) {
-        cycles_ += 1;
-        addr_abs_ = reg_.pc + addr_rel_;
+        state_->cycles += 1;
+        state_->addr_abs = state_->reg.pc + state_->addr_rel;
 
-        if ((addr_abs_ & 0xFF00) != (reg_.pc & 0xFF00)) {
-            cycles_ += 1;
+        if ((state_->addr_abs & 0xFF00) != (state_->reg.pc & 0xFF00)) {
+            state_->cycles += 1;
         }
-        reg_.pc = addr_abs_;
+        state_->reg.pc = state_->addr_abs;
     }
     return 0;
 }
@@ -731,11 +758,11 @@ uint8_t CPU::CLV()
 uint8_t CPU::CMP()
 {
     fetch();
-    temp_ = static_cast<uint16_t>(reg_.a) - static_cast<uint16_t>(fetched_);
+    state_->temp = static_cast<uint16_t>(state_->reg.a) - static_cast<uint16_t>(state_->fetched);
     // C is set if there is an unsigned overflow
-    setFlag(C, reg_.a >= fetched_);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
-    setFlag(N, (temp_ & 0x80) != 0);
+    setFlag(C, state_->reg.a >= state_->fetched);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
+    setFlag(N, (state_->temp & 0x80) != 0);
 
     return 1;
 }
@@ -746,11 +773,11 @@ uint8_t CPU::CMP()
 uint8_t CPU::CPX()
 {
     fetch();
-    temp_ = static_cast<uint16_t>(reg_.x) - static_cast<uint16_t>(fetched_);
-    setFlag(N, (temp_ & 0x80) != 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
+    state_->temp = static_cast<uint16_t>(state_->reg.x) - static_cast<uint16_t>(state_->fetched);
+    setFlag(N, (state_->temp & 0x80) != 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
     // C is set if there is an unsigned overflow
-    setFlag(C, reg_.x >= fetched_);
+    setFlag(C, state_->reg.x >= state_->fetched);
 
     return 0;
 }
@@ -761,11 +788,11 @@ uint8_t CPU::CPX()
 uint8_t CPU::CPY()
 {
     fetch();
-    temp_ = static_cast<uint16_t>(reg_.y) - static_cast<uint16_t>(fetched_);
-    setFlag(N, (temp_ & 0x80) != 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
+    state_->temp = static_cast<uint16_t>(state_->reg.y) - static_cast<uint16_t>(state_->fetched);
+    setFlag(N, (state_->temp & 0x80) != 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
     // C is set if there is an unsigned overflow
-    setFlag(C, reg_.y >= fetched_);
+    setFlag(C, state_->reg.y >= state_->fetched);
 
     return 0;
 }
@@ -776,10 +803,10 @@ uint8_t CPU::CPY()
 uint8_t CPU::DEC()
 {
     fetch();
-    temp_ = static_cast<uint16_t>(fetched_) - 1;
-    write(addr_abs_, temp_ & 0x00FF);
-    setFlag(N, (temp_ & 0x80) != 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
+    state_->temp = static_cast<uint16_t>(state_->fetched) - 1;
+    write(state_->addr_abs, state_->temp & 0x00FF);
+    setFlag(N, (state_->temp & 0x80) != 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
 
     return 0;
 }
@@ -789,9 +816,9 @@ uint8_t CPU::DEC()
 // Condition code:  N, Z
 uint8_t CPU::DEX()
 {
-    reg_.x -= 1;
-    setFlag(N, (reg_.x & 0x80) != 0);
-    setFlag(Z, reg_.x == 0);
+    state_->reg.x -= 1;
+    setFlag(N, (state_->reg.x & 0x80) != 0);
+    setFlag(Z, state_->reg.x == 0);
 
     return 0;
 }
@@ -801,9 +828,9 @@ uint8_t CPU::DEX()
 // Condition code:  N, Z
 uint8_t CPU::DEY()
 {
-    reg_.y -= 1;
-    setFlag(N, (reg_.y & 0x80) != 0);
-    setFlag(Z, reg_.y == 0);
+    state_->reg.y -= 1;
+    setFlag(N, (state_->reg.y & 0x80) != 0);
+    setFlag(Z, state_->reg.y == 0);
 
     return 0;
 }
@@ -814,9 +841,9 @@ uint8_t CPU::DEY()
 uint8_t CPU::EOR()
 {
     fetch();
-    reg_.a = reg_.a ^ fetched_;
-    setFlag(N, (reg_.a & 0x80) != 0);
-    setFlag(Z, reg_.a == 0);
+    state_->reg.a = state_->reg.a ^ state_->fetched;
+    setFlag(N, (state_->reg.a & 0x80) != 0);
+    setFlag(Z, state_->reg.a == 0);
     return 1;
 }
 
@@ -826,10 +853,10 @@ uint8_t CPU::EOR()
 uint8_t CPU::INC()
 {
     fetch();
-    temp_ = fetched_ + 1;
-    write(addr_abs_, temp_ & 0x00FF);
-    setFlag(N, (temp_ & 0x80) != 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
+    state_->temp = state_->fetched + 1;
+    write(state_->addr_abs, state_->temp & 0x00FF);
+    setFlag(N, (state_->temp & 0x80) != 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
     return 0;
 }
 
@@ -838,9 +865,9 @@ uint8_t CPU::INC()
 // Condition code:  N, Z
 uint8_t CPU::INX()
 {
-    reg_.x += 1;
-    setFlag(N, (reg_.x & 0x80) != 0);
-    setFlag(Z, reg_.x == 0);
+    state_->reg.x += 1;
+    setFlag(N, (state_->reg.x & 0x80) != 0);
+    setFlag(Z, state_->reg.x == 0);
 
     return 0;
 }
@@ -850,9 +877,9 @@ uint8_t CPU::INX()
 // Condition code:  N, Z
 uint8_t CPU::INY()
 {
-    reg_.y += 1;
-    setFlag(N, (reg_.y & 0x80) != 0);
-    setFlag(Z, reg_.y == 0);
+    state_->reg.y += 1;
+    setFlag(N, (state_->reg.y & 0x80) != 0);
+    setFlag(Z, state_->reg.y == 0);
 
     return 0;
 }
@@ -862,7 +889,7 @@ uint8_t CPU::INY()
 //                  (PC+2) -> PCH
 uint8_t CPU::JMP()
 {
-    reg_.pc = addr_abs_;
+    state_->reg.pc = state_->addr_abs;
     return 0;
 }
 
@@ -872,14 +899,14 @@ uint8_t CPU::JMP()
 //                  (PC+2) -> PCH
 uint8_t CPU::JSR()
 {
-    reg_.pc -= 1;
+    state_->reg.pc -= 1;
 
-    write(0x0100 + reg_.st, (reg_.pc >> 8) & 0x00FF);
-    reg_.st -= 1;
-    write(0x0100 + reg_.st, reg_.pc & 0x00FF);
-    reg_.st -= 1;
+    write(0x0100 + state_->reg.st, (state_->reg.pc >> 8) & 0x00FF);
+    state_->reg.st -= 1;
+    write(0x0100 + state_->reg.st, state_->reg.pc & 0x00FF);
+    state_->reg.st -= 1;
 
-    reg_.pc = addr_abs_;
+    state_->reg.pc = state_->addr_abs;
     return 0;
 }
 
@@ -889,9 +916,9 @@ uint8_t CPU::JSR()
 uint8_t CPU::LDA()
 {
     fetch();
-    reg_.a = fetched_;
-    setFlag(N, (reg_.a & 0x80) != 0);
-    setFlag(Z, reg_.a == 0);
+    state_->reg.a = state_->fetched;
+    setFlag(N, (state_->reg.a & 0x80) != 0);
+    setFlag(Z, state_->reg.a == 0);
 
     return 1;
 }
@@ -902,9 +929,9 @@ uint8_t CPU::LDA()
 uint8_t CPU::LDX()
 {
     fetch();
-    reg_.x = fetched_;
-    setFlag(N, (reg_.x & 0x80) != 0);
-    setFlag(Z, reg_.x == 0);
+    state_->reg.x = state_->fetched;
+    setFlag(N, (state_->reg.x & 0x80) != 0);
+    setFlag(Z, state_->reg.x == 0);
     return 1;
 }
 
@@ -914,9 +941,9 @@ uint8_t CPU::LDX()
 uint8_t CPU::LDY()
 {
     fetch();
-    reg_.y = fetched_;
-    setFlag(N, (reg_.y & 0x80) != 0);
-    setFlag(Z, reg_.y == 0);
+    state_->reg.y = state_->fetched;
+    setFlag(N, (state_->reg.y & 0x80) != 0);
+    setFlag(Z, state_->reg.y == 0);
     return 1;
 }
 
@@ -926,16 +953,16 @@ uint8_t CPU::LDY()
 uint8_t CPU::LSR()
 {
     fetch();
-    setFlag(C, (fetched_ & 1) != 0);
-    temp_ = fetched_ >> 1;
-    setFlag(Z, (temp_ & 0x00FF) == 0);
-    setFlag(N, (temp_ & 0x80) != 0);
+    setFlag(C, (state_->fetched & 1) != 0);
+    state_->temp = state_->fetched >> 1;
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
+    setFlag(N, (state_->temp & 0x80) != 0);
 
-    if (lookup_table_[opcode_].addrmode == &CPU::IMP) {
-        reg_.a = temp_ & 0x00FF;
+    if (lookup_table_[state_->opcode].addrmode == &CPU::IMP) {
+        state_->reg.a = state_->temp & 0x00FF;
     }
     else {
-        write(addr_abs_, temp_ & 0x00FF);
+        write(state_->addr_abs, state_->temp & 0x00FF);
     }
     return 0;
 }
@@ -944,7 +971,7 @@ uint8_t CPU::LSR()
 uint8_t CPU::NOP()
 {
     // https://wiki.nesdev.com/w/index.php/CPU_unofficial_opcodes
-    switch (opcode_) {
+    switch (state_->opcode) {
     case 0x1C:
     case 0x3C:
     case 0x5C:
@@ -963,9 +990,9 @@ uint8_t CPU::NOP()
 uint8_t CPU::ORA()
 {
     fetch();
-    reg_.a = reg_.a | fetched_;
-    setFlag(N, (reg_.a & 0x80) != 0);
-    setFlag(Z, reg_.a == 0);
+    state_->reg.a = state_->reg.a | state_->fetched;
+    setFlag(N, (state_->reg.a & 0x80) != 0);
+    setFlag(Z, state_->reg.a == 0);
 
     return 1;
 }
@@ -974,8 +1001,8 @@ uint8_t CPU::ORA()
 // Function:    push A
 uint8_t CPU::PHA()
 {
-    write(0x100 + reg_.st, reg_.a);
-    reg_.st -= 1;
+    write(0x100 + state_->reg.st, state_->reg.a);
+    state_->reg.st -= 1;
 
     return 0;
 }
@@ -985,8 +1012,8 @@ uint8_t CPU::PHA()
 // Note:        Break flag is set to 1 before push ??
 uint8_t CPU::PHP()
 {
-    write(0x100 + reg_.st, reg_.status | B | U);
-    reg_.st -= 1;
+    write(0x100 + state_->reg.st, state_->reg.status | B | U);
+    state_->reg.st -= 1;
     setFlag(B, false);
     setFlag(U, false);
 
@@ -998,10 +1025,10 @@ uint8_t CPU::PHP()
 // Condition code:  N, Z
 uint8_t CPU::PLA()
 {
-    reg_.st += 1;
-    reg_.a = read(0x0100 + reg_.st);
-    setFlag(N, (reg_.a & 0x80) != 0);
-    setFlag(Z, reg_.a == 0);
+    state_->reg.st += 1;
+    state_->reg.a = read(0x0100 + state_->reg.st);
+    setFlag(N, (state_->reg.a & 0x80) != 0);
+    setFlag(Z, state_->reg.a == 0);
 
     return 0;
 }
@@ -1010,8 +1037,8 @@ uint8_t CPU::PLA()
 // Function:    pull SR
 uint8_t CPU::PLP()
 {
-    reg_.st += 1;
-    reg_.status = read(0x0100 + reg_.st);
+    state_->reg.st += 1;
+    state_->reg.status = read(0x0100 + state_->reg.st);
     setFlag(U, true);
 
     return 0;
@@ -1023,15 +1050,15 @@ uint8_t CPU::PLP()
 uint8_t CPU::ROL()
 {
     fetch();
-    temp_ = static_cast<uint16_t>(fetched_ << 1) | static_cast<uint16_t>(getFlag(C));
-    setFlag(C, (temp_ & 0xFF00) != 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
-    setFlag(N, (temp_ & 0x80) != 0);
-    if (lookup_table_[opcode_].addrmode == &CPU::IMP) {
-        reg_.a = temp_ & 0x00FF;
+    state_->temp = static_cast<uint16_t>(state_->fetched << 1) | static_cast<uint16_t>(getFlag(C));
+    setFlag(C, (state_->temp & 0xFF00) != 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
+    setFlag(N, (state_->temp & 0x80) != 0);
+    if (lookup_table_[state_->opcode].addrmode == &CPU::IMP) {
+        state_->reg.a = state_->temp & 0x00FF;
     }
     else {
-        write(addr_abs_, temp_ & 0x00FF);
+        write(state_->addr_abs, state_->temp & 0x00FF);
     }
     return 0;
 }
@@ -1042,15 +1069,16 @@ uint8_t CPU::ROL()
 uint8_t CPU::ROR()
 {
     fetch();
-    temp_ = static_cast<uint16_t>(fetched_ >> 1) | (static_cast<uint16_t>(getFlag(C)) << 7);
-    setFlag(C, (fetched_ & 1) != 0);
-    setFlag(Z, (temp_ & 0x00FF) == 0);
-    setFlag(N, (temp_ & 0x80) != 0);
-    if (lookup_table_[opcode_].addrmode == &CPU::IMP) {
-        reg_.a = temp_ & 0x00FF;
+    state_->temp = static_cast<uint16_t>(state_->fetched >> 1)
+                   | (static_cast<uint16_t>(getFlag(C)) << 7);
+    setFlag(C, (state_->fetched & 1) != 0);
+    setFlag(Z, (state_->temp & 0x00FF) == 0);
+    setFlag(N, (state_->temp & 0x80) != 0);
+    if (lookup_table_[state_->opcode].addrmode == &CPU::IMP) {
+        state_->reg.a = state_->temp & 0x00FF;
     }
     else {
-        write(addr_abs_, temp_ & 0x00FF);
+        write(state_->addr_abs, state_->temp & 0x00FF);
     }
     return 0;
 }
@@ -1061,15 +1089,15 @@ uint8_t CPU::ROR()
 // Function:    pull SR, pull PC
 uint8_t CPU::RTI()
 {
-    reg_.st += 1;
-    reg_.status = read(0x0100 + reg_.st);
-    reg_.status &= ~B;
-    reg_.status &= ~U;
+    state_->reg.st += 1;
+    state_->reg.status = read(0x0100 + state_->reg.st);
+    state_->reg.status &= ~B;
+    state_->reg.status &= ~U;
 
-    reg_.st += 1;
-    reg_.pc = static_cast<uint16_t>(read(0x0100 + reg_.st));
-    reg_.st += 1;
-    reg_.pc |= static_cast<uint16_t>(read(0x0100 + reg_.st)) << 8;
+    state_->reg.st += 1;
+    state_->reg.pc = static_cast<uint16_t>(read(0x0100 + state_->reg.st));
+    state_->reg.st += 1;
+    state_->reg.pc |= static_cast<uint16_t>(read(0x0100 + state_->reg.st)) << 8;
 
     return 0;
 }
@@ -1078,12 +1106,12 @@ uint8_t CPU::RTI()
 // Function:        pull PC, PC+1 -> PC
 uint8_t CPU::RTS()
 {
-    reg_.st += 1;
-    reg_.pc = static_cast<uint16_t>(read(0x0100 + reg_.st));
-    reg_.st += 1;
-    reg_.pc |= static_cast<uint16_t>(read(0x0100 + reg_.st)) << 8;
+    state_->reg.st += 1;
+    state_->reg.pc = static_cast<uint16_t>(read(0x0100 + state_->reg.st));
+    state_->reg.st += 1;
+    state_->reg.pc |= static_cast<uint16_t>(read(0x0100 + state_->reg.st)) << 8;
 
-    reg_.pc += 1;
+    state_->reg.pc += 1;
     return 0;
 }
 
@@ -1095,15 +1123,17 @@ uint8_t CPU::SBC()
     fetch();
 
     // We can invert the bottom 8 bits with bitwise xor
-    uint16_t value = (static_cast<uint16_t>(fetched_)) ^ 0x00FF;
+    uint16_t value = (static_cast<uint16_t>(state_->fetched)) ^ 0x00FF;
 
     // Notice this is exactly the same as addition from here!
-    temp_ = static_cast<uint16_t>(reg_.a) + value + static_cast<uint16_t>(getFlag(C));
-    setFlag(C, (temp_ & 0xFF00) != 0);
-    setFlag(Z, ((temp_ & 0x00FF) == 0));
-    setFlag(V, ((temp_ ^ static_cast<uint16_t>(reg_.a)) & (value ^ temp_) & 0x0080) != 0);
-    setFlag(N, (temp_ & 0x0080) != 0);
-    reg_.a = temp_ & 0x00FF;
+    state_->temp = static_cast<uint16_t>(state_->reg.a) + value + static_cast<uint16_t>(getFlag(C));
+    setFlag(C, (state_->temp & 0xFF00) != 0);
+    setFlag(Z, ((state_->temp & 0x00FF) == 0));
+    setFlag(V, ((state_->temp ^ static_cast<uint16_t>(state_->reg.a)) & (value ^ state_->temp)
+                & 0x0080)
+                   != 0);
+    setFlag(N, (state_->temp & 0x0080) != 0);
+    state_->reg.a = state_->temp & 0x00FF;
     return 1;
 }
 
@@ -1138,7 +1168,7 @@ uint8_t CPU::SEI()
 // Function:    A -> M
 uint8_t CPU::STA()
 {
-    write(addr_abs_, reg_.a);
+    write(state_->addr_abs, state_->reg.a);
     return 0;
 }
 
@@ -1146,7 +1176,7 @@ uint8_t CPU::STA()
 // Function:    X -> M
 uint8_t CPU::STX()
 {
-    write(addr_abs_, reg_.x);
+    write(state_->addr_abs, state_->reg.x);
     return 0;
 }
 
@@ -1154,7 +1184,7 @@ uint8_t CPU::STX()
 // Function:    Y -> M
 uint8_t CPU::STY()
 {
-    write(addr_abs_, reg_.y);
+    write(state_->addr_abs, state_->reg.y);
     return 0;
 }
 
@@ -1163,9 +1193,9 @@ uint8_t CPU::STY()
 // Condition code:  N, Z
 uint8_t CPU::TAX()
 {
-    reg_.x = reg_.a;
-    setFlag(Z, reg_.x == 0x00);
-    setFlag(N, (reg_.x & 0x80) != 0);
+    state_->reg.x = state_->reg.a;
+    setFlag(Z, state_->reg.x == 0x00);
+    setFlag(N, (state_->reg.x & 0x80) != 0);
     return 0;
 }
 
@@ -1174,9 +1204,9 @@ uint8_t CPU::TAX()
 // Condition code: N, Z
 uint8_t CPU::TAY()
 {
-    reg_.y = reg_.a;
-    setFlag(Z, reg_.y == 0x00);
-    setFlag(N, (reg_.y & 0x80) != 0);
+    state_->reg.y = state_->reg.a;
+    setFlag(Z, state_->reg.y == 0x00);
+    setFlag(N, (state_->reg.y & 0x80) != 0);
     return 0;
 }
 
@@ -1185,9 +1215,9 @@ uint8_t CPU::TAY()
 // Condition code:  N, Z
 uint8_t CPU::TSX()
 {
-    reg_.x = reg_.st;
-    setFlag(Z, reg_.x == 0x00);
-    setFlag(N, (reg_.x & 0x80) != 0);
+    state_->reg.x = state_->reg.st;
+    setFlag(Z, state_->reg.x == 0x00);
+    setFlag(N, (state_->reg.x & 0x80) != 0);
     return 0;
 }
 
@@ -1196,9 +1226,9 @@ uint8_t CPU::TSX()
 // Condition code:  N, Z
 uint8_t CPU::TXA()
 {
-    reg_.a = reg_.x;
-    setFlag(Z, reg_.a == 0x00);
-    setFlag(N, (reg_.a & 0x80) != 0);
+    state_->reg.a = state_->reg.x;
+    setFlag(Z, state_->reg.a == 0x00);
+    setFlag(N, (state_->reg.a & 0x80) != 0);
     return 0;
 }
 
@@ -1206,7 +1236,7 @@ uint8_t CPU::TXA()
 // Function:    X -> S
 uint8_t CPU::TXS()
 {
-    reg_.st = reg_.x;
+    state_->reg.st = state_->reg.x;
     return 0;
 }
 
@@ -1215,9 +1245,9 @@ uint8_t CPU::TXS()
 // Condition code:  N, Z
 uint8_t CPU::TYA()
 {
-    reg_.a = reg_.y;
-    setFlag(Z, reg_.a == 0x00);
-    setFlag(N, (reg_.a & 0x80) != 0);
+    state_->reg.a = state_->reg.y;
+    setFlag(Z, state_->reg.a == 0x00);
+    setFlag(N, (state_->reg.a & 0x80) != 0);
     return 0;
 }
 
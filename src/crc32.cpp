@@ -0,0 +1,61 @@
+#include "tinynes/crc32.h"
+
+namespace tn
+{
+
+namespace
+{
+
+struct CRC32Tables
+{
+    uint32_t table[8][256];
+};
+
+// table[0] is the classic bytewise table, table[n] advances table[n - 1] by one more zero byte
+constexpr CRC32Tables makeTables()
+{
+    CRC32Tables tables{};
+    for (uint32_t idx = 0; idx < 256; idx += 1) {
+        uint32_t crc = idx;
+        for (int bit = 0; bit < 8; bit += 1) {
+            crc = (crc >> 1) ^ ((crc & 0x01) != 0 ? 0xEDB88320u : 0u);
+        }
+        tables.table[0][idx] = crc;
+    }
+    for (uint32_t idx = 0; idx < 256; idx += 1) {
+        for (int slice = 1; slice < 8; slice += 1) {
+            uint32_t prev = tables.table[slice - 1][idx];
+            tables.table[slice][idx] = (prev >> 8) ^ tables.table[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr CRC32Tables TABLES = makeTables();
+
+inline uint32_t load32(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+           | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+} // namespace
+
+uint32_t crc32(const uint8_t *data, std::size_t size, uint32_t crc)
+{
+    const auto &t = TABLES.table;
+    crc = ~crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint32_t lo = load32(data) ^ crc;
+        uint32_t hi = load32(data + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+              ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF]
+              ^ t[0][hi >> 24];
+    }
+    for (; size > 0; data += 1, size -= 1) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+    }
+    return ~crc;
+}
+
+} // namespace tn
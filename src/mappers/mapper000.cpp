@@ -3,7 +3,7 @@
 namespace tn
 {
 
-bool Mapper000::cpuMapRead(uint16_t addr, uint32_t &mapped_addr)
+void Mapper000::updateBanks()
 {
     // The generic designation NROM has two PRG ROM capability version, 16K or 32K.
     //      [CPU Address]   [Type]      [PRG ROM]
@@ -12,47 +12,12 @@ bool Mapper000::cpuMapRead(uint16_t addr, uint32_t &mapped_addr)
     //      $C000-$FFFF     Mirror      $8000-$BFFF
     // PRGROM is 32K:
     //      $8000-$FFFF     Map         $0000-$7FFF
+    mapPRG16K(0, 0);
+    mapPRG16K(1, -1);
+    mapPRGRAM(true, true);
 
-    if (addr >= 0x8000 && addr <= 0xFFFF) {
-        mapped_addr = addr & (prg_banks_num > 1 ? 0x7FFF : 0x3FFF);
-        return true;
-    }
-    return false;
+    // CHR RAM when the cartridge has no CHR ROM
+    mapCHR8K(0);
 }
 
-bool Mapper000::cpuMapWrite(uint16_t addr, uint32_t &mapped_addr, [[maybe_unused]] uint8_t data)
-{
-    if (addr >= 0x8000 && addr <= 0xFFFF) {
-        mapped_addr = addr & (prg_banks_num > 1 ? 0x7FFF : 0x3FFF);
-        return true;
-    }
-
-    return false;
-}
-
-bool Mapper000::ppuMapRead(uint16_t addr, uint32_t &mapped_addr)
-{
-    if (addr >= 0x0000 && addr <= 0x1FFF) {
-        mapped_addr = addr;
-        return true;
-    }
-
-    return false;
-}
-
-bool Mapper000::ppuMapWrite(uint16_t addr, uint32_t &mapped_addr)
-{
-    if (addr >= 0x0000 && addr <= 0x1FFF) {
-        // treat it as RAM if no CHR banks exist
-        if (chr_banks_num == 0) {
-            mapped_addr = addr;
-            return true;
-        }
-    }
-
-    return false;
-}
-
-void Mapper000::reset() {}
-
-} // namespace tn
\ No newline at end of file
+} // namespace tn
@@ -0,0 +1,99 @@
+#include "tinynes/mappers/mapper001.h"
+
+namespace tn
+{
+
+void Mapper001::cpuWriteRegister(uint16_t addr, uint8_t data)
+{
+    if ((data & 0x80) != 0) {
+        shift_ = SHIFT_RESET;
+        control_ |= 0x0C;
+        updateBanks();
+        return;
+    }
+
+    bool is_complete = (shift_ & 0x01) != 0;
+    shift_ = (shift_ >> 1) | ((data & 0x01) << 4);
+    if (!is_complete) {
+        return;
+    }
+
+    switch ((addr >> 13) & 0x03) {
+    case 0:
+        control_ = shift_;
+        break;
+    case 1:
+        chr_bank_[0] = shift_;
+        break;
+    case 2:
+        chr_bank_[1] = shift_;
+        break;
+    case 3:
+        prg_bank_ = shift_;
+        break;
+    }
+    shift_ = SHIFT_RESET;
+    updateBanks();
+}
+
+void Mapper001::reset()
+{
+    shift_ = SHIFT_RESET;
+    control_ = 0x0C;
+    chr_bank_[0] = chr_bank_[1] = 0;
+    prg_bank_ = 0;
+    updateBanks();
+}
+
+void Mapper001::saveState(StateWriter &writer) const
+{
+    writer.put(shift_);
+    writer.put(control_);
+    writer.write(chr_bank_, sizeof(chr_bank_));
+    writer.put(prg_bank_);
+}
+
+void Mapper001::loadState(StateReader &reader)
+{
+    shift_ = reader.get<uint8_t>();
+    control_ = reader.get<uint8_t>();
+    reader.read(chr_bank_, sizeof(chr_bank_));
+    prg_bank_ = reader.get<uint8_t>();
+}
+
+void Mapper001::updateBanks()
+{
+    static constexpr Cartridge::MIRROR MIRRORS[4] = {
+        Cartridge::MIRROR::ONESCREEN_LO, Cartridge::MIRROR::ONESCREEN_HI,
+        Cartridge::MIRROR::VERTICAL, Cartridge::MIRROR::HORIZONTAL};
+    setMirror(MIRRORS[control_ & 0x03]);
+
+    // 16 KiB banks, SUROM selects the outer 256 KiB through the first CHR register
+    int outer = prg_banks_num > 16 ? (chr_bank_[0] & 0x10) : 0;
+    int bank = outer | (prg_bank_ & 0x0F);
+    switch ((control_ >> 2) & 0x03) {
+    case 0:
+    case 1:
+        mapPRG32K(bank >> 1);
+        break;
+    case 2:
+        mapPRG16K(0, outer);
+        mapPRG16K(1, bank);
+        break;
+    case 3:
+        mapPRG16K(0, bank);
+        mapPRG16K(1, outer | 0x0F);
+        break;
+    }
+    mapPRGRAM((prg_bank_ & 0x10) == 0, true);
+
+    if ((control_ & 0x10) != 0) {
+        mapCHR4K(0, chr_bank_[0]);
+        mapCHR4K(1, chr_bank_[1]);
+    }
+    else {
+        mapCHR8K(chr_bank_[0] >> 1);
+    }
+}
+
+} // namespace tn
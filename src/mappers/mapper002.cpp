@@ -0,0 +1,35 @@
+#include "tinynes/mappers/mapper002.h"
+
+namespace tn
+{
+
+void Mapper002::cpuWriteRegister([[maybe_unused]] uint16_t addr, uint8_t data)
+{
+    prg_bank_ = data;
+    mapPRG16K(0, prg_bank_);
+}
+
+void Mapper002::reset()
+{
+    prg_bank_ = 0;
+    updateBanks();
+}
+
+void Mapper002::saveState(StateWriter &writer) const
+{
+    writer.put(prg_bank_);
+}
+
+void Mapper002::loadState(StateReader &reader)
+{
+    prg_bank_ = reader.get<uint8_t>();
+}
+
+void Mapper002::updateBanks()
+{
+    mapPRG16K(0, prg_bank_);
+    mapPRG16K(1, -1);
+    mapCHR8K(0);
+}
+
+} // namespace tn
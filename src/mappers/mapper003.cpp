@@ -0,0 +1,35 @@
+#include "tinynes/mappers/mapper003.h"
+
+namespace tn
+{
+
+void Mapper003::cpuWriteRegister([[maybe_unused]] uint16_t addr, uint8_t data)
+{
+    chr_bank_ = data;
+    mapCHR8K(chr_bank_);
+}
+
+void Mapper003::reset()
+{
+    chr_bank_ = 0;
+    updateBanks();
+}
+
+void Mapper003::saveState(StateWriter &writer) const
+{
+    writer.put(chr_bank_);
+}
+
+void Mapper003::loadState(StateReader &reader)
+{
+    chr_bank_ = reader.get<uint8_t>();
+}
+
+void Mapper003::updateBanks()
+{
+    mapPRG16K(0, 0);
+    mapPRG16K(1, -1);
+    mapCHR8K(chr_bank_);
+}
+
+} // namespace tn
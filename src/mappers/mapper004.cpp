@@ -0,0 +1,132 @@
+#include "tinynes/mappers/mapper004.h"
+
+namespace tn
+{
+
+void Mapper004::cpuWriteRegister(uint16_t addr, uint8_t data)
+{
+    bool is_odd = (addr & 0x0001) != 0;
+    switch ((addr >> 13) & 0x03) {
+    case 0:
+        if (!is_odd) {
+            bank_select_ = data;
+            updateBanks();
+        }
+        // R0-R5 are CHR banks, R6 and R7 PRG banks
+        else if ((bank_select_ & 0x07) < 6) {
+            registers_[bank_select_ & 0x07] = data;
+            updateCHRBanks();
+        }
+        else {
+            registers_[bank_select_ & 0x07] = data;
+            updatePRGBanks();
+        }
+        break;
+    case 1:
+        if (is_odd) {
+            prg_ram_protect_ = data;
+            mapPRGRAM((prg_ram_protect_ & 0x80) != 0, (prg_ram_protect_ & 0x40) == 0);
+        }
+        else {
+            setMirror((data & 0x01) != 0 ? Cartridge::MIRROR::HORIZONTAL
+                                         : Cartridge::MIRROR::VERTICAL);
+        }
+        break;
+    case 2:
+        if (is_odd) {
+            irq_counter_ = 0;
+            is_irq_reload_ = true;
+        }
+        else {
+            irq_latch_ = data;
+        }
+        break;
+    case 3:
+        is_irq_enable_ = is_odd;
+        if (!is_odd) {
+            setIRQ(false);
+        }
+        break;
+    }
+}
+
+void Mapper004::ppuA12Rise()
+{
+    if (irq_counter_ == 0 || is_irq_reload_) {
+        irq_counter_ = irq_latch_;
+        is_irq_reload_ = false;
+    }
+    else {
+        irq_counter_ -= 1;
+    }
+    if (irq_counter_ == 0 && is_irq_enable_) {
+        setIRQ(true);
+    }
+}
+
+void Mapper004::reset()
+{
+    bank_select_ = 0;
+    prg_ram_protect_ = 0x80;
+    irq_latch_ = 0;
+    irq_counter_ = 0;
+    is_irq_reload_ = false;
+    is_irq_enable_ = false;
+    setIRQ(false);
+    updateBanks();
+}
+
+void Mapper004::saveState(StateWriter &writer) const
+{
+    writer.put(bank_select_);
+    writer.write(registers_, sizeof(registers_));
+    writer.put(prg_ram_protect_);
+    writer.put(irq_latch_);
+    writer.put(irq_counter_);
+    writer.put(is_irq_reload_);
+    writer.put(is_irq_enable_);
+}
+
+void Mapper004::loadState(StateReader &reader)
+{
+    bank_select_ = reader.get<uint8_t>();
+    reader.read(registers_, sizeof(registers_));
+    prg_ram_protect_ = reader.get<uint8_t>();
+    irq_latch_ = reader.get<uint8_t>();
+    irq_counter_ = reader.get<uint8_t>();
+    is_irq_reload_ = reader.get<bool>();
+    is_irq_enable_ = reader.get<bool>();
+}
+
+void Mapper004::updateBanks()
+{
+    updatePRGBanks();
+    mapPRGRAM((prg_ram_protect_ & 0x80) != 0, (prg_ram_protect_ & 0x40) == 0);
+    updateCHRBanks();
+}
+
+void Mapper004::updatePRGBanks()
+{
+    // PRG ROM bank mode swaps the switchable $8000 bank with the fixed second-last bank
+    bool is_prg_swapped = (bank_select_ & 0x40) != 0;
+    mapPRG8K(is_prg_swapped ? 2 : 0, registers_[6]);
+    mapPRG8K(1, registers_[7]);
+    mapPRG8K(is_prg_swapped ? 0 : 2, -2);
+    mapPRG8K(3, -1);
+}
+
+void Mapper004::updateCHRBanks()
+{
+    // CHR A12 inversion swaps the 2 KiB banks with the 1 KiB banks, the 2 KiB registers ignore
+    // their lowest bit
+    uint8_t inversion = (bank_select_ & 0x80) != 0 ? 4 : 0;
+    mapCHR1K(0 ^ inversion, registers_[0] & 0xFE);
+    mapCHR1K(1 ^ inversion, registers_[0] | 0x01);
+    mapCHR1K(2 ^ inversion, registers_[1] & 0xFE);
+    mapCHR1K(3 ^ inversion, registers_[1] | 0x01);
+    for (uint8_t idx = 0; idx < 4; idx += 1) {
+        mapCHR1K((4 + idx) ^ inversion, registers_[2 + idx]);
+    }
+}
+
+} // namespace tn
@@ -0,0 +1,36 @@
+#include "tinynes/mappers/mapper007.h"
+
+namespace tn
+{
+
+void Mapper007::cpuWriteRegister([[maybe_unused]] uint16_t addr, uint8_t data)
+{
+    select_ = data;
+    updateBanks();
+}
+
+void Mapper007::reset()
+{
+    select_ = 0;
+    updateBanks();
+}
+
+void Mapper007::saveState(StateWriter &writer) const
+{
+    writer.put(select_);
+}
+
+void Mapper007::loadState(StateReader &reader)
+{
+    select_ = reader.get<uint8_t>();
+}
+
+void Mapper007::updateBanks()
+{
+    mapPRG32K(select_ & 0x07);
+    setMirror((select_ & 0x10) != 0 ? Cartridge::MIRROR::ONESCREEN_HI
+                                    : Cartridge::MIRROR::ONESCREEN_LO);
+    mapCHR8K(0);
+}
+
+} // namespace tn
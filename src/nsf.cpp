@@ -0,0 +1,109 @@
+#include "tinynes/nsf.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+namespace tn
+{
+
+NSF::NSF(std::string_view filename)
+{
+    static_assert(sizeof(NSFHeader) == 128, "NSF header is 128 bytes");
+
+    std::ifstream ifs(filename.data(), std::ifstream::binary);
+    if (!ifs.is_open()) {
+        spdlog::error("NSF cannot open {}", filename);
+        return;
+    }
+    ifs.read(reinterpret_cast<char *>(&header_), sizeof(NSFHeader));
+    if (!ifs || std::memcmp(header_.magic_name, "NESM\x1A", 5) != 0) {
+        spdlog::error("NSF {} has no valid header", filename);
+        return;
+    }
+    if (header_.load_addr < 0x8000) {
+        spdlog::error("NSF load address ${:04X} below $8000 is not supported", header_.load_addr);
+        return;
+    }
+    if (header_.sound_chips != 0) {
+        spdlog::warn("NSF expansion audio ${:02X} is not emulated", header_.sound_chips);
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)),
+                              std::istreambuf_iterator<char>());
+
+    // bank switched files start at the offset of the load address in its 4 KiB bank, the others
+    // are mapped linearly from $8000 on
+    is_bank_switched_ = std::any_of(std::begin(header_.bank_init), std::end(header_.bank_init),
+                                    [](uint8_t bank) { return bank != 0; });
+    std::size_t padding = is_bank_switched_ ? (header_.load_addr & 0x0FFF)
+                                            : (header_.load_addr - 0x8000);
+    std::size_t size = (padding + data.size() + 0x0FFF) & ~static_cast<std::size_t>(0x0FFF);
+    prg_mem_.assign(std::max<std::size_t>(size, 0x1000), 0x00);
+    std::copy(data.begin(), data.end(), prg_mem_.begin() + padding);
+
+    reset();
+    is_file_loaded_ = true;
+
+    spdlog::info("NSF load \"{}\" by {}, {} songs, {} KiB{}", title(), artist(), totalSongs(),
+                 prg_mem_.size() / 1024, is_bank_switched_ ? ", bank switched" : "");
+}
+
+void NSF::reset()
+{
+    for (uint8_t idx = 0; idx < 8; idx += 1) {
+        banks_[idx] = is_bank_switched_ ? header_.bank_init[idx] : idx;
+    }
+    wram_.fill(0x00);
+}
+
+uint32_t NSF::playPeriodUs() const
+{
+    return header_.ntsc_speed != 0 ? header_.ntsc_speed : DEFAULT_PLAY_PERIOD_US;
+}
+
+bool NSF::cpuRead(uint16_t addr, uint8_t &data)
+{
+    if (addr >= 0x8000) {
+        std::size_t offset = static_cast<std::size_t>(banks_[(addr - 0x8000) >> 12]) * 0x1000
+                             + (addr & 0x0FFF);
+        data = offset < prg_mem_.size() ? prg_mem_[offset] : 0x00;
+        return true;
+    }
+    if (addr >= 0x6000) {
+        data = wram_[addr & 0x1FFF];
+        return true;
+    }
+    // idle loop: JMP IDLE_ADDR
+    if (addr >= IDLE_ADDR && addr < IDLE_ADDR + 3) {
+        constexpr uint8_t IDLE_LOOP[3] = {0x4C, IDLE_ADDR & 0xFF, IDLE_ADDR >> 8};
+        data = IDLE_LOOP[addr - IDLE_ADDR];
+        return true;
+    }
+    return false;
+}
+
+bool NSF::cpuWrite(uint16_t addr, uint8_t data)
+{
+    if (addr >= 0x6000 && addr <= 0x7FFF) {
+        wram_[addr & 0x1FFF] = data;
+        return true;
+    }
+    if (addr >= 0x5FF8 && addr <= 0x5FFF) {
+        if (is_bank_switched_) {
+            banks_[addr - 0x5FF8] = data;
+        }
+        return true;
+    }
+    return false;
+}
+
+std::string NSF::field(const uint8_t (&text)[32])
+{
+    const char *str = reinterpret_cast<const char *>(text);
+    return std::string(str, strnlen(str, sizeof(text)));
+}
+
+} // namespace tn
@@ -1,6 +1,7 @@
 #include "tinynes/ppu.h"
 #include "tinynes/cartridge.h"
 #include "tinynes/palette_color.h"
+#include "tinynes/ppu_render_worker.h"
 #include "tinynes/vscreen.h"
 
 #include <cstring>
@@ -9,13 +10,16 @@
 namespace tn
 {
 
-PPU::PPU()
+PPU::PPU(State *state) : state_(state)
 {
+    if (state_ == nullptr) {
+        own_state_ = std::make_unique<State>();
+        state_ = own_state_.get();
+    }
+    // horizontal mirroring until a cartridge is connected
+    name_table_page_[0] = name_table_page_[1] = state_->name_table[0];
+    name_table_page_[2] = name_table_page_[3] = state_->name_table[1];
     vscreen_main_ = std::make_shared<VScreen>(256, 240, sf::Color::Black);
-    vscreen_name_table_[0] = std::make_shared<VScreen>(256, 240, sf::Color::Black);
-    vscreen_name_table_[1] = std::make_shared<VScreen>(256, 240, sf::Color::Black);
-    vscreen_pattern_table_[0] = std::make_shared<VScreen>(128, 128, sf::Color::Black);
-    vscreen_pattern_table_[1] = std::make_shared<VScreen>(128, 128, sf::Color::Black);
 }
 
 /**
@@ -35,58 +39,12 @@ sf::Color PPU::getColorFromPaletteMemory(uint8_t palette, uint8_t pixel)
     return sf::Color(COLORS[ppuRead(0x3F00 + (palette << 2) + pixel) & 0x3F]);
 }
 
-/**
- * According to NES Dev wiki description, PPU has a pattern table to define the shapes of tiles that
- * makes update the backgrounds and sprites. Generally, each tile in pattern table is 16 bytes, made
- * of two planes. So we can individually divide them to LSB plane and MSB plane, where the tiles in
- * each plane are 8 bytes size, occupying 8x8 pixels.
- *
- * LSB and MSB tile combines and provide 4 types of pixel functions:
- * - 00: transparent color
- * - 01: color index 1
- * - 10: color index 2
- * - 11: color index 3
- *
- * The planes are stored as 8 bytes of LSB, followed by 8 bytes of MSB.
- *
- * According to [PPU memory map]<https://www.nesdev.org/wiki/PPU_memory_map>, the pattern table is
- * divided into two 256-tile sections: $0000-$0FFF, nicknamed "left", and $1000-$1FFF, nicknamed
- * "right".
- *
- * @param idx pattern table index, 0 'left', 1 'right'
- * @ref NES Dev wiki - PPU pattern tables: <https://www.nesdev.org/wiki/PPU_pattern_tables>
- * @warning Don't forget to call update() function after you require the updated pattern table
- *          sprite.
- * @return Vscreen smart shared pointer used for drawing
- */
-std::shared_ptr<VScreen> PPU::vScreenPatternTable(uint8_t idx, uint8_t palette)
+std::shared_ptr<VScreen> PPU::vScreenMain()
 {
-    for (uint16_t ytile = 0; ytile < 16; ytile += 1) {
-        for (uint16_t xtile = 0; xtile < 16; xtile += 1) {
-            // each tile is 16 bytes !!!
-            uint16_t offset = ytile * 256 + xtile * 16;
-
-            // now loop through the 8x8 pixels  tile
-            for (uint16_t row = 0; row < 8; row += 1) {
-                // If you get confused with the following code, please look at "Bit Planes" example
-                // on <https://www.nesdev.org/wiki/PPU_pattern_tables>. 'ppuRead' read 1 byte each
-                // time.
-                uint8_t tile_lsb = ppuRead(idx * 0x1000 + offset + row + 0x0000);
-                uint8_t tile_msb = ppuRead(idx * 0x1000 + offset + row + 0x0008);
-
-                for (uint16_t col = 0; col < 8; col += 1) {
-                    uint8_t pixel = ((tile_lsb & 0x01) << 1) | (tile_msb & 0x01);
-                    tile_lsb >>= 1;
-                    tile_msb >>= 1;
-
-                    vscreen_pattern_table_[idx]->setPixel(
-                        xtile * 8 + (7 - col), // inverse to draw pixels from left
-                        ytile * 8 + row, getColorFromPaletteMemory(palette, pixel));
-                }
-            }
-        }
+    if (render_worker_ != nullptr) {
+        return render_worker_->vScreenMain();
     }
-    return vscreen_pattern_table_[idx];
+    return vscreen_main_;
 }
 
 uint8_t PPU::cpuRead(uint16_t addr, [[maybe_unused]] bool read_only)
@@ -97,13 +55,13 @@ uint8_t PPU::cpuRead(uint16_t addr, [[maybe_unused]] bool read_only)
     if (read_only) {
         switch (addr) {
         case 0x0000: // PPUCTRL
-            data = control_.reg;
+            data = state_->control.reg;
             break;
         case 0x0001: // PPUMASK
-            data = mask_.reg;
+            data = state_->mask.reg;
             break;
         case 0x0002: // PPUSTATUS
-            data = status_.reg;
+            data = state_->status.reg;
             break;
         case 0x0003: // OAMADDR
             break;
@@ -120,6 +78,10 @@ uint8_t PPU::cpuRead(uint16_t addr, [[maybe_unused]] bool read_only)
         }
     }
     else {
+        if (render_worker_ != nullptr && (addr == 0x0002 || addr == 0x0007)) {
+            logRenderEvent(RenderEvent::REG_READ, addr, 0x00);
+        }
+
         switch (addr) {
         case 0x0000: // PPUCTRL - Not readable
             break;
@@ -127,16 +89,16 @@ uint8_t PPU::cpuRead(uint16_t addr, [[maybe_unused]] bool read_only)
             break;
         case 0x0002: // PPUSTATUS
             // PPUSTATUS has upper 3 bits flag and lower 5 bits stale PPU bus contents.
-            data = (status_.reg & 0xE0) | (data_buffer_ & 0x1F);
+            data = (state_->status.reg & 0xE0) | (state_->data_buffer & 0x1F);
             // clear 'V' bit after reading
-            status_.vertical_blank = 0;
+            state_->status.vertical_blank = 0;
             // After reading PPUSTATUS to clear w (the write latch)
-            address_latch_ = 0;
+            state_->address_latch = 0;
             break;
         case 0x0003: // OAMADDR - Unused
             break;
         case 0x0004: // OAMDATA - Unused
-            data = oam_ptr_[oam_addr_];
+            data = reinterpret_cast<uint8_t *>(state_->oam)[state_->oam_addr];
             break;
         case 0x0005: // PPUSCROLL - Not readable
             break;
@@ -146,17 +108,17 @@ uint8_t PPU::cpuRead(uint16_t addr, [[maybe_unused]] bool read_only)
             // Reads from the NameTable ram get delayed one cycle,
             // so output buffer which contains the data from the
             // previous read request. Reading upper byte first!!!
-            data = data_buffer_;
+            data = state_->data_buffer;
 
             // prepare for next time reading
-            data_buffer_ = ppuRead(vram_addr_.reg);
+            state_->data_buffer = ppuRead(state_->vram_addr.reg);
 
             // If the address was in the palette range, the
             // data is not delayed, so it returns immediately
-            if (vram_addr_.reg >= 0x3F00) {
-                data = data_buffer_;
+            if (state_->vram_addr.reg >= 0x3F00) {
+                data = state_->data_buffer;
             }
-            vram_addr_.reg += (control_.vram_addr_mode ? 32 /*down*/ : 1 /*across*/);
+            state_->vram_addr.reg += (state_->control.vram_addr_mode ? 32 /*down*/ : 1 /*across*/);
             break;
         default:
             break;
@@ -167,22 +129,30 @@ uint8_t PPU::cpuRead(uint16_t addr, [[maybe_unused]] bool read_only)
 }
 void PPU::cpuWrite(uint16_t addr, uint8_t data)
 {
+    if (render_worker_ != nullptr) {
+        logRenderEvent(RenderEvent::REG_WRITE, addr, data);
+    }
+
     switch (addr) {
     case 0x0000: // PPUCTRL
-        control_.reg = data;
-        tram_addr_.nametable_x = control_.name_table_x;
-        tram_addr_.nametable_y = control_.name_table_y;
+        // sprite height decides which scanlines a sprite covers
+        if (((state_->control.reg ^ data) & 0x20) != 0) {
+            sprite_buckets_dirty_ = true;
+        }
+        state_->control.reg = data;
+        state_->tram_addr.nametable_x = state_->control.name_table_x;
+        state_->tram_addr.nametable_y = state_->control.name_table_y;
         break;
     case 0x0001: // PPUMASK
-        mask_.reg = data;
+        state_->mask.reg = data;
         break;
     case 0x0002: // PPUSTATUS
         break;
     case 0x0003: // OAMADDR
-        oam_addr_ = data;
+        state_->oam_addr = data;
         break;
     case 0x0004: // OAMDATA
-        oam_ptr_[oam_addr_] = data;
+        storeOAM(state_->oam_addr, data);
         break;
     // <https://www.nesdev.org/wiki/PPU_registers#PPUSCROLL>
     // PPUSCROLL takes two writes: the first is the X scroll and the second is the Y scroll. Whether
@@ -192,40 +162,40 @@ void PPU::cpuWrite(uint16_t addr, uint8_t data)
     // The high 5 bits indicate the coarse X/Y
     // The low 3 bits indicate the fine X/Y
     case 0x0005: // PPUSCROLL
-        if (address_latch_ == 0) {
-            fine_x_ = data & 0x07;
-            tram_addr_.coarse_x = data >> 3;
-            address_latch_ = 1;
+        if (state_->address_latch == 0) {
+            state_->fine_x = data & 0x07;
+            state_->tram_addr.coarse_x = data >> 3;
+            state_->address_latch = 1;
         }
         else {
-            tram_addr_.fine_y = data & 0x07;
-            tram_addr_.coarse_y = data >> 3;
-            address_latch_ = 0;
+            state_->tram_addr.fine_y = data & 0x07;
+            state_->tram_addr.coarse_y = data >> 3;
+            state_->address_latch = 0;
         }
         break;
     // The 16-bit address is written to PPUADDR one byte at a time, upper byte first. Whether this
     // is the first or second write is tracked internally by the w register, which is shared with
     // PPUSCROLL. Writing to PPUADDR register is limited in blanking area.
     case 0x0006: // PPUADDR
-        if (address_latch_ == 0) {
+        if (state_->address_latch == 0) {
             // If you have seen the 'Register Control' part in
             // <https://www.nesdev.org/wiki/PPU_scrolling#$2006_first_write_(w_is_0)>,
             // you will know the upper 2 bits isn't used so we use (data & 0x3F)
-            tram_addr_.reg
-                = ((static_cast<uint16_t>(data) & 0x3F) << 8) | (tram_addr_.reg & 0x00FF);
-            address_latch_ = 1;
+            state_->tram_addr.reg
+                = ((static_cast<uint16_t>(data) & 0x3F) << 8) | (state_->tram_addr.reg & 0x00FF);
+            state_->address_latch = 1;
         }
         else {
-            tram_addr_.reg = (tram_addr_.reg & 0xFF00) | static_cast<uint16_t>(data);
-            vram_addr_.reg = tram_addr_.reg;
-            address_latch_ = 0;
+            state_->tram_addr.reg = (state_->tram_addr.reg & 0xFF00) | static_cast<uint16_t>(data);
+            state_->vram_addr.reg = state_->tram_addr.reg;
+            state_->address_latch = 0;
         }
         break;
     case 0x0007: // PPUDATA
-        ppuWrite(vram_addr_.reg, data);
+        ppuWrite(state_->vram_addr.reg, data);
         // All writes from PPU data automatically increment the nametable
         // address depending upon the mode set in the control register.
-        vram_addr_.reg += (control_.vram_addr_mode ? 32 : 1);
+        state_->vram_addr.reg += (state_->control.vram_addr_mode ? 32 : 1);
         break;
     default:
         break;
@@ -237,69 +207,34 @@ uint8_t PPU::ppuRead(uint16_t addr, [[maybe_unused]] bool read_only)
     uint8_t data = 0x00;
     addr &= 0x3FFF;
 
-    if (cart_->ppuRead(addr, data)) {
-    }
-    // 2 pattern tables, per size 0x1000
-    else if (addr >= 0x0000 && addr <= 0x1FFF) {
-        int table_index = (addr & 0x1000) >> 12;
-        data = pattern_table_[table_index][addr & 0x0FFF];
+    /**
+     * The pattern table is divided into two 256-tile sections: $0000-$0FFF, nicknamed "left", and
+     * $1000-$1FFF, nicknamed "right". Both live on the cartridge, as CHR ROM or CHR RAM.
+     * @verbatim PPU addresses within the pattern tables can be decoded as follows:
+     *  DCBA98 76543210
+     *  ---------------
+     *  0HNNNN NNNNPyyy
+     *  |||||| |||||+++- T : Fine Y offset, the row number within a tile
+     *  |||||| ||||+---- P : Bit plane (0: less significant bit; 1: more significant bit)
+     *  ||++++-++++----- N : Tile number from name table
+     *  |+-------------- H : Half of pattern table (0: "left"; 1: "right")
+     *  +--------------- 0 : Pattern table is at $0000-$1FFF
+     * @verbatim
+     * @ref NES Dev wiki - PPU pattern tables: <https://www.nesdev.org/wiki/PPU_pattern_tables>
+     */
+    if (addr <= 0x1FFF) {
+        cart_->ppuRead(addr, data);
     }
-    // 4 name tables, per size 0x400
+    // 4 name tables, per size 0x400, $3000-$3EFF mirrors $2000-$2EFF
     // NES Dev wiki - PPU nametables: <https://www.nesdev.org/wiki/PPU_nametables>
-    else if (addr >= 0x2000 && addr <= 0x3EFF) {
-        addr &= 0x0FFF;
-        // Vertical
-        // $2000 equals $2800 and $2400 equals $2C00
-        if (cart_->mirror == Cartridge::MIRROR::VERTICAL) {
-            if (addr >= 0x0000 && addr <= 0x03FF) {
-                data = name_table_[0][addr & 0x03FF];
-            }
-            if (addr >= 0x0400 && addr <= 0x07FF) {
-                data = name_table_[1][addr & 0x03FF];
-            }
-            if (addr >= 0x0800 && addr <= 0x0BFF) {
-                data = name_table_[0][addr & 0x03FF];
-            }
-            if (addr >= 0x0C00 && addr <= 0x0FFF) {
-                data = name_table_[1][addr & 0x03FF];
-            }
-        }
-        // Horizontal
-        // $2000 equals $2400 and $2800 equals $2C00
-        else if (cart_->mirror == Cartridge::MIRROR::HORIZONTAL) {
-            if (addr >= 0x0000 && addr <= 0x03FF) {
-                data = name_table_[0][addr & 0x03FF];
-            }
-            if (addr >= 0x0400 && addr <= 0x07FF) {
-                data = name_table_[0][addr & 0x03FF];
-            }
-            if (addr >= 0x0800 && addr <= 0x0BFF) {
-                data = name_table_[1][addr & 0x03FF];
-            }
-            if (addr >= 0x0C00 && addr <= 0x0FFF) {
-                data = name_table_[1][addr & 0x03FF];
-            }
-        }
+    else if (addr <= 0x3EFF) {
+        data = name_table_page_[(addr >> 10) & 0x03][addr & 0x03FF];
     }
-    // palette RAM indexes
-    else if (addr >= 0x3F00 && addr <= 0x3FFF) {
-        // we only care about the lower 5 bits that relates to background or foreground colors
-        addr &= 0x001F;
-        // $3F10 is the mirror of universal background color stored in $3F00
-        if (addr == 0x0010) {
-            addr = 0x0000;
-        }
-        // What's more, we also need to deal with the mirrored palette colors
-        if (addr == 0x0014) {
-            addr = 0x0004;
-        }
-        if (addr == 0x0018) {
-            addr = 0x0008;
-        }
-        if (addr == 0x001C) {
-            addr = 0x000C;
-        }
-        data = palette_table_[addr] & (mask_.grayscale ? 0x30 : 0x3F);
+    // palette RAM indexes, we only care about the lower 5 bits that relates to background or
+    // foreground colors
+    else {
+        data = state_->palette_table[PALETTE_INDEX[addr & 0x001F]]
+               & (state_->mask.grayscale ? 0x30 : 0x3F);
     }
 
     return data;
@@ -309,108 +244,345 @@ void PPU::ppuWrite(uint16_t addr, uint8_t data)
 {
     addr &= 0x3FFF;
 
-    if (cart_->ppuWrite(addr, data)) {
-    }
-    // 2 pattern tables, per size 0x1000
-    else if (addr >= 0x0000 && addr <= 0x1FFF) {
-        int table_index = (addr & 0x1000) >> 12;
-        pattern_table_[table_index][addr & 0x0FFF] = data;
+    // 2 pattern tables, per size 0x1000, ignored for CHR ROM
+    if (addr <= 0x1FFF) {
+        cart_->ppuWrite(addr, data);
+        debug_dirty_.chr += 1;
     }
     // 4 name tables, per size 0x400
-    else if (addr >= 0x2000 && addr <= 0x3EFF) {
-        addr &= 0x0FFF;
-        if (cart_->mirror == Cartridge::MIRROR::VERTICAL) {
-            // Vertical
-            if (addr >= 0x0000 && addr <= 0x03FF) {
-                name_table_[0][addr & 0x03FF] = data;
-            }
-            if (addr >= 0x0400 && addr <= 0x07FF) {
-                name_table_[1][addr & 0x03FF] = data;
-            }
-            if (addr >= 0x0800 && addr <= 0x0BFF) {
-                name_table_[0][addr & 0x03FF] = data;
-            }
-            if (addr >= 0x0C00 && addr <= 0x0FFF) {
-                name_table_[1][addr & 0x03FF] = data;
-            }
-        }
-        else if (cart_->mirror == Cartridge::MIRROR::HORIZONTAL) {
-            // Horizontal
-            if (addr >= 0x0000 && addr <= 0x03FF) {
-                name_table_[0][addr & 0x03FF] = data;
-            }
-            if (addr >= 0x0400 && addr <= 0x07FF) {
-                name_table_[0][addr & 0x03FF] = data;
-            }
-            if (addr >= 0x0800 && addr <= 0x0BFF) {
-                name_table_[1][addr & 0x03FF] = data;
+    else if (addr <= 0x3EFF) {
+        name_table_page_[(addr >> 10) & 0x03][addr & 0x03FF] = data;
+        debug_dirty_.vram += 1;
+    }
+    // palette RAM indexes
+    else {
+        state_->palette_table[PALETTE_INDEX[addr & 0x001F]] = data;
+        debug_dirty_.palette += 1;
+    }
+}
+
+/**
+ * NES Dev wiki - Mirroring: <https://www.nesdev.org/wiki/Mirroring#Nametable_Mirroring>
+ *
+ * - Vertical:   $2000 equals $2800 and $2400 equals $2C00
+ * - Horizontal: $2000 equals $2400 and $2800 equals $2C00
+ * - One-screen: all four nametables point to the same physical table
+ */
+void PPU::updateMirroring()
+{
+    mirror_ = cart_->mirror;
+
+    uint8_t page[4]{0, 0, 0, 0};
+    switch (mirror_) {
+    case Cartridge::MIRROR::VERTICAL:
+        page[1] = page[3] = 1;
+        break;
+    case Cartridge::MIRROR::HORIZONTAL:
+        page[2] = page[3] = 1;
+        break;
+    case Cartridge::MIRROR::ONESCREEN_LO:
+        break;
+    case Cartridge::MIRROR::ONESCREEN_HI:
+        page[0] = page[1] = page[2] = page[3] = 1;
+        break;
+    }
+
+    for (int i = 0; i < 4; i += 1) {
+        name_table_page_[i] = state_->name_table[page[i]];
+    }
+    debug_dirty_.vram += 1;
+}
+
+/**
+ * NES Dev wiki - MMC3 scanline counter: <https://www.nesdev.org/wiki/MMC3#IRQ_Specifics>
+ *
+ * Pattern fetches only drive A12 high from the $1000 table and nametable fetches always pull it
+ * low again, too briefly for the M2 filter of the mapper. So a rising edge counts when the
+ * sprite fetches of dots 257-320 and the background fetches around them use different tables:
+ * - background at $0000, sprites at $1000: at the first sprite fetch, dot 260
+ * - background at $1000, sprites at $0000: at the first fetch of the next line, dot 324
+ * Unused sprite slots fetch tile $FF, which is in the $1000 table for 8x16 sprites.
+ */
+void PPU::checkA12Rise()
+{
+    if (!state_->mask.render_background && !state_->mask.render_sprites) {
+        return;
+    }
+    bool is_bg_high = state_->control.background_pattern_table_addr != 0;
+    bool is_sprite_high
+        = state_->control.sprite_size != 0 || state_->control.sprite_pattern_table_addr != 0;
+    if (is_bg_high == is_sprite_high) {
+        return;
+    }
+    if ((state_->cycle == 260) == is_sprite_high) {
+        cart_->ppuA12Rise();
+    }
+}
+
+void PPU::oamWrite(uint8_t addr, uint8_t data)
+{
+    if (render_worker_ != nullptr) {
+        logRenderEvent(RenderEvent::OAM_WRITE, addr, data);
+    }
+    storeOAM(addr, data);
+}
+
+void PPU::storeOAM(uint8_t addr, uint8_t data)
+{
+    reinterpret_cast<uint8_t *>(state_->oam)[addr] = data;
+    sprite_buckets_dirty_ = true;
+    debug_dirty_.oam += 1;
+}
+
+void PPU::rebuildSpriteBuckets()
+{
+    for (auto &bucket : sprite_buckets_) {
+        bucket.count = 0;
+    }
+
+    const int16_t sprite_height = state_->control.sprite_size ? 16 : 8;
+    for (uint8_t n_oam_entry = 0; n_oam_entry < 64; n_oam_entry += 1) {
+        // sprites are evaluated in OAM order, so lower indices always land in the bucket first
+        const int16_t top = state_->oam[n_oam_entry].y;
+        for (int16_t line = top; line < top + sprite_height && line < 240; line += 1) {
+            SpriteBucket &bucket = sprite_buckets_[line];
+            if (bucket.count < 8) {
+                bucket.index[bucket.count] = n_oam_entry;
             }
-            if (addr >= 0x0C00 && addr <= 0x0FFF) {
-                name_table_[1][addr & 0x03FF] = data;
+            if (bucket.count < 9) {
+                bucket.count += 1;
             }
         }
     }
-    // palette RAM indexes
-    else if (addr >= 0x3F00 && addr <= 0x3FFF) {
-        addr &= 0x001F;
-        if (addr == 0x0010) {
-            addr = 0x0000;
-        }
-        if (addr == 0x0014) {
-            addr = 0x0004;
+    sprite_buckets_dirty_ = false;
+}
+
+void PPU::setSpriteZeroHit()
+{
+    // The left edge of the screen has specific switches to control
+    // its appearance. This is used to smooth inconsistencies when
+    // scrolling (since sprites x coord must be >= 0)
+    if ((~(state_->mask.render_background_left | state_->mask.render_sprites_left)) != 0) {
+        if (state_->cycle >= 9 && state_->cycle < 258) {
+            state_->status.sprite_zero_hit = 1;
         }
-        if (addr == 0x0018) {
-            addr = 0x0008;
+    }
+    else {
+        if (state_->cycle >= 1 && state_->cycle < 258) {
+            state_->status.sprite_zero_hit = 1;
         }
-        if (addr == 0x001C) {
-            addr = 0x000C;
+    }
+}
+
+void PPU::setFrameSkip(uint8_t frames)
+{
+    frame_skip_ = frames;
+    frame_skip_count_ = 0;
+    is_frame_rendered_ = (render_worker_ == nullptr);
+}
+
+void PPU::setAdaptiveFrameSkip(bool enable, uint8_t max_skip)
+{
+    is_adaptive_frame_skip_ = enable;
+    max_frame_skip_ = max_skip;
+    frame_skip_count_ = 0;
+    frame_deadline_ = std::chrono::steady_clock::now();
+    is_frame_rendered_ = (render_worker_ == nullptr);
+}
+
+/**
+ * Called once per frame, right after the last dot, to decide if the next frame gets composed.
+ *
+ * The fixed setting renders one frame and then skips 'frame_skip_' frames. The adaptive setting
+ * keeps a real time deadline advancing by one NTSC frame (~16.64 ms) per emulated frame, and
+ * skips the next frame whenever the host is already past that deadline, but never more than
+ * 'max_frame_skip_' frames in a row so that the picture keeps updating. If the host falls behind
+ * by more than that, e.g. because emulation was paused, the deadline is pulled back to now.
+ */
+void PPU::decideFrameSkip()
+{
+    bool is_skip = false;
+
+    if (is_adaptive_frame_skip_) {
+        constexpr auto FRAME_PERIOD = std::chrono::nanoseconds(16639267);
+        auto now = std::chrono::steady_clock::now();
+        frame_deadline_ += FRAME_PERIOD;
+        if (now > frame_deadline_ + FRAME_PERIOD * max_frame_skip_) {
+            frame_deadline_ = now;
         }
-        palette_table_[addr] = data;
+        is_skip = now > frame_deadline_ && frame_skip_count_ < max_frame_skip_;
+    }
+    else {
+        is_skip = frame_skip_count_ < frame_skip_;
     }
+
+    frame_skip_count_ = is_skip ? frame_skip_count_ + 1 : 0;
+    is_frame_rendered_ = !is_skip;
 }
 
-void PPU::connectCartridge(const std::shared_ptr<Cartridge> &cartridge) { cart_ = cartridge; }
+/**
+ * Whether the coming dots of a frame that is not composed need the background tiles and the
+ * sprite patterns. Nothing but the collision-only sprite zero check reads them then, and it can
+ * only set the flag on dots 1-257 of a line with sprites in range, until the flag is set. The
+ * check runs on the sprites evaluated at dot 257 of the line before, the pre-render line clears
+ * the sprite shifters, and the vertical blank lines keep what line 239 left behind.
+ *
+ * Decided at dot 1 for the tiles of the line and the two tiles prefetched for the next one, the
+ * bucket of the next line is looked up ahead of its evaluation. After the evaluation at dot 257
+ * only the prefetch and the sprite pattern fetch are left, which alone refill the shifters.
+ * Scrolling, sprite evaluation and everything else the CPU can observe keep running.
+ */
+bool PPU::isLineRendered(bool is_line_start)
+{
+    const State &s = *state_;
+    if (is_frame_rendered_) {
+        return true;
+    }
+    if (s.status.sprite_zero_hit) {
+        return false;
+    }
+    if (s.sprite_count > 0) {
+        return true;
+    }
+    if (!is_line_start || s.scanline < 0) {
+        return false;
+    }
+    if (sprite_buckets_dirty_) {
+        rebuildSpriteBuckets();
+    }
+    return sprite_buckets_[s.scanline].count > 0;
+}
+
+void PPU::logRenderEvent(RenderEvent::Type type, uint16_t addr, uint8_t data)
+{
+    render_worker_->record({dot(), type, data, addr});
+}
+
+/**
+ * With a render worker attached this PPU keeps running every timing related part of the frame,
+ * but never composes pixels itself. Sprite zero hits are still resolved here by the collision-only
+ * path of the skipped frames, so PPUSTATUS stays exact for the CPU.
+ */
+void PPU::attachRenderWorker(PPURenderWorker *worker)
+{
+    render_worker_ = worker;
+    is_frame_rendered_ = (worker == nullptr);
+    frame_skip_count_ = 0;
+}
+
+std::unique_ptr<PPU> PPU::cloneForRendering(const std::shared_ptr<Cartridge> &cartridge) const
+{
+    // a fresh PPU with its own copy of the state, nothing else is shared with this one
+    auto ppu = std::make_unique<PPU>();
+    ppu->cart_ = cartridge;
+    ppu->copyStateFrom(*this);
+    return ppu;
+}
+
+void PPU::copyStateFrom(const PPU &ppu)
+{
+    *state_ = *ppu.state_;
+    syncState();
+}
+
+void PPU::replayRenderEvent(const RenderEvent &event)
+{
+    switch (event.type) {
+    case RenderEvent::REG_READ:
+        cpuRead(event.addr);
+        break;
+    case RenderEvent::REG_WRITE:
+        cpuWrite(event.addr, event.data);
+        break;
+    case RenderEvent::OAM_WRITE:
+        storeOAM(static_cast<uint8_t>(event.addr), event.data);
+        break;
+    case RenderEvent::CART_WRITE:
+        cart_->cpuWrite(event.addr, event.data);
+        syncMirroring();
+        break;
+    case RenderEvent::RESET:
+        cart_->reset();
+        reset();
+        break;
+    }
+}
+
+void PPU::syncState()
+{
+    if (cart_ != nullptr) {
+        updateMirroring();
+    }
+    sprite_buckets_dirty_ = true;
+    is_line_rendered_ = true;
+    debug_dirty_.chr += 1;
+    debug_dirty_.vram += 1;
+    debug_dirty_.palette += 1;
+    debug_dirty_.oam += 1;
+}
+
+void PPU::connectCartridge(const std::shared_ptr<Cartridge> &cartridge)
+{
+    cart_ = cartridge;
+    updateMirroring();
+    debug_dirty_.chr += 1;
+}
 
 void PPU::reset()
 {
-    fine_x_ = 0x00;
-    address_latch_ = 0x00;
-    data_buffer_ = 0x00;
-    scanline_ = 0;
-    cycle_ = 0;
-    status_.reg = 0x00;
-    mask_.reg = 0x00;
-    control_.reg = 0x00;
-    vram_addr_.reg = 0x0000;
-    tram_addr_.reg = 0x0000;
-    bg_next_tile_.id = 0x00;
-    bg_next_tile_.attribute = 0x00;
-    bg_next_tile_.lsb = 0x00;
-    bg_next_tile_.msb = 0x00;
-    bg_shifter_pattern_.lo = 0x0000;
-    bg_shifter_pattern_.hi = 0x0000;
-    bg_shifter_attribute_.lo = 0x0000;
-    bg_shifter_attribute_.hi = 0x0000;
+    if (render_worker_ != nullptr) {
+        logRenderEvent(RenderEvent::RESET, 0x0000, 0x00);
+    }
+    state_->fine_x = 0x00;
+    state_->address_latch = 0x00;
+    state_->data_buffer = 0x00;
+    state_->scanline = 0;
+    state_->cycle = 0;
+    state_->status.reg = 0x00;
+    state_->mask.reg = 0x00;
+    state_->control.reg = 0x00;
+    state_->vram_addr.reg = 0x0000;
+    state_->tram_addr.reg = 0x0000;
+    state_->bg_next_tile.id = 0x00;
+    state_->bg_next_tile.attribute = 0x00;
+    state_->bg_next_tile.lsb = 0x00;
+    state_->bg_next_tile.msb = 0x00;
+    state_->bg_shifter_pattern.lo = 0x0000;
+    state_->bg_shifter_pattern.hi = 0x0000;
+    state_->bg_shifter_attribute.lo = 0x0000;
+    state_->bg_shifter_attribute.hi = 0x0000;
 }
 
 void PPU::clock()
 {
+    // a local reference, unlike state_ it is not reloaded after every byte store
+    State &s = *state_;
+
+    // On a line isLineRendered() has ruled out, the dots between the coarse X increments do
+    // nothing the CPU could observe
+    if (!is_line_rendered_ && s.scanline < 240 && s.cycle >= 2 && s.cycle < 256
+        && (s.cycle & 0x07) != 0)
+    {
+        s.cycle += 1;
+        return;
+    }
+
     std::function<void()> transfer_address_x_func = [&]()
     {
         // Ony if rendering is enabled
-        if (mask_.render_background || mask_.render_sprites) {
-            vram_addr_.nametable_x = tram_addr_.nametable_x;
-            vram_addr_.coarse_x = tram_addr_.coarse_x;
+        if (s.mask.render_background || s.mask.render_sprites) {
+            s.vram_addr.nametable_x = s.tram_addr.nametable_x;
+            s.vram_addr.coarse_x = s.tram_addr.coarse_x;
         }
     };
 
     std::function<void()> transfer_address_y_func = [&]()
     {
         // Ony if rendering is enabled
-        if (mask_.render_background || mask_.render_sprites) {
-            vram_addr_.fine_y = tram_addr_.fine_y;
-            vram_addr_.nametable_y = tram_addr_.nametable_y;
-            vram_addr_.coarse_y = tram_addr_.coarse_y;
+        if (s.mask.render_background || s.mask.render_sprites) {
+            s.vram_addr.fine_y = s.tram_addr.fine_y;
+            s.vram_addr.nametable_y = s.tram_addr.nametable_y;
+            s.vram_addr.coarse_y = s.tram_addr.coarse_y;
         }
     };
 
@@ -421,23 +593,23 @@ void PPU::clock()
         //
         // If rendering is enabled, fine Y is incremented at dot 256 of each scanline, overflowing
         // to coarse Y, and finally adjusted to wrap among the nametables vertically.
-        if (mask_.render_background || mask_.render_sprites) {
-            if (vram_addr_.fine_y < 7) {
-                vram_addr_.fine_y += 1;
+        if (s.mask.render_background || s.mask.render_sprites) {
+            if (s.vram_addr.fine_y < 7) {
+                s.vram_addr.fine_y += 1;
             }
             else {
-                vram_addr_.fine_y = 0;
-                if (vram_addr_.coarse_y == 29) {
-                    vram_addr_.coarse_y = 0;
+                s.vram_addr.fine_y = 0;
+                if (s.vram_addr.coarse_y == 29) {
+                    s.vram_addr.coarse_y = 0;
                     // switch vertical nametable
-                    vram_addr_.nametable_y = ~vram_addr_.nametable_y;
+                    s.vram_addr.nametable_y = ~s.vram_addr.nametable_y;
                 }
                 // The bottom two rows do not contain tile information
-                else if (vram_addr_.coarse_y == 31) {
-                    vram_addr_.coarse_y = 0;
+                else if (s.vram_addr.coarse_y == 31) {
+                    s.vram_addr.coarse_y = 0;
                 }
                 else {
-                    vram_addr_.coarse_y += 1;
+                    s.vram_addr.coarse_y += 1;
                 }
             }
         }
@@ -449,14 +621,14 @@ void PPU::clock()
         // <https://www.nesdev.org/wiki/PPU_scrolling#Coarse_X_increment>
         //
         // only when render is enabled
-        if (mask_.render_background || mask_.render_sprites) {
-            if (vram_addr_.coarse_x == 31) {
-                vram_addr_.coarse_x = 0;
+        if (s.mask.render_background || s.mask.render_sprites) {
+            if (s.vram_addr.coarse_x == 31) {
+                s.vram_addr.coarse_x = 0;
                 // switch horizontal nametable
-                vram_addr_.nametable_x = ~vram_addr_.nametable_x;
+                s.vram_addr.nametable_x = ~s.vram_addr.nametable_x;
             }
             else {
-                vram_addr_.coarse_x += 1;
+                s.vram_addr.coarse_x += 1;
             }
         }
     };
@@ -466,42 +638,42 @@ void PPU::clock()
         // Each PPU cycle update we calculate one pixel.
         // Shifter is 16 bits wide, because the top 8 bits are the current 8 pixels being
         // drawn and the bottom 8 bits are the next 8 pixels to be drawn.
-        bg_shifter_pattern_.lo = (bg_shifter_pattern_.lo & 0xFF00) | bg_next_tile_.lsb;
-        bg_shifter_pattern_.hi = (bg_shifter_pattern_.hi & 0xFF00) | bg_next_tile_.msb;
+        s.bg_shifter_pattern.lo = (s.bg_shifter_pattern.lo & 0xFF00) | s.bg_next_tile.lsb;
+        s.bg_shifter_pattern.hi = (s.bg_shifter_pattern.hi & 0xFF00) | s.bg_next_tile.msb;
 
         // Attribute bits do not change per pixel, rather they change every 8 pixels
         // but are synchronized with the pattern shifters for convenience, so here
         // we take the bottom 2 bits of the attribute word which represent which
         // palette is being used for the current 8 pixels and the next 8 pixels, and
         // "inflate" them to 8 bit words.
-        bg_shifter_attribute_.lo = (bg_shifter_attribute_.lo & 0xFF00)
-                                   | ((bg_next_tile_.attribute & 0b01) != 0 ? 0xFF : 0x00);
-        bg_shifter_attribute_.hi = (bg_shifter_attribute_.hi & 0xFF00)
-                                   | ((bg_next_tile_.attribute & 0b10) != 0 ? 0xFF : 0x00);
+        s.bg_shifter_attribute.lo = (s.bg_shifter_attribute.lo & 0xFF00)
+                                    | ((s.bg_next_tile.attribute & 0b01) != 0 ? 0xFF : 0x00);
+        s.bg_shifter_attribute.hi = (s.bg_shifter_attribute.hi & 0xFF00)
+                                    | ((s.bg_next_tile.attribute & 0b10) != 0 ? 0xFF : 0x00);
     };
 
     // Every cycle the shifters storing pattern and attribute information shift
     // their contents by 1 bit, because PPU processes 1 pixel per cycle.
     std::function<void()> update_shifter_func = [&]()
     {
-        if (mask_.render_background) {
+        if (s.mask.render_background && is_line_rendered_) {
             // Shifting background tile pattern row
-            bg_shifter_pattern_.lo <<= 1;
-            bg_shifter_pattern_.hi <<= 1;
+            s.bg_shifter_pattern.lo <<= 1;
+            s.bg_shifter_pattern.hi <<= 1;
 
             // Shifting palette attributes 1
-            bg_shifter_attribute_.lo <<= 1;
-            bg_shifter_attribute_.hi <<= 1;
+            s.bg_shifter_attribute.lo <<= 1;
+            s.bg_shifter_attribute.hi <<= 1;
         }
 
-        if (mask_.render_sprites && cycle_ >= 1 && cycle_ < 258) {
-            for (int i = 0; i < sprite_count_; i++) {
-                if (sprite_per_scanline_[i].x > 0) {
-                    sprite_per_scanline_[i].x -= 1;
+        if (s.mask.render_sprites && s.cycle >= 1 && s.cycle < 258 && is_line_rendered_) {
+            for (int i = 0; i < s.sprite_count; i++) {
+                if (s.sprite_per_scanline[i].x > 0) {
+                    s.sprite_per_scanline[i].x -= 1;
                 }
                 else {
-                    sprite_shifter_pattern_lo_[i] <<= 1;
-                    sprite_shifter_pattern_hi_[i] <<= 1;
+                    s.sprite_shifter_pattern_lo[i] <<= 1;
+                    s.sprite_shifter_pattern_hi[i] <<= 1;
                 }
             }
         }
@@ -528,39 +700,47 @@ void PPU::clock()
     //
     // Please check <https://www.nesdev.org/w/images/default/4/4f/Ppu.svg> !!!
 
-    if (scanline_ >= -1 && scanline_ < 240) {
+    if (s.scanline >= -1 && s.scanline < 240) {
         //= Background Rendering
         // For odd frames, the cycle at the end of the scanline is skipped
-        if (scanline_ == 0 && cycle_ == 0) {
+        if (s.scanline == 0 && s.cycle == 0) {
             // replacing the idle tick at the beginning of the first visible scanline with the last
             // tick of the last dummy nametable fetch
-            cycle_ = 1;
+            s.cycle = 1;
         }
         // For even frames, the last cycle occurs normally.
-        if (scanline_ == -1 && cycle_ == 1) {
+        if (s.scanline == -1 && s.cycle == 1) {
             // start the new frame by clearing vertical blank flag
-            status_.vertical_blank = 0;
+            s.status.vertical_blank = 0;
             // Clear sprite overflow flag
-            status_.sprite_overflow = 0;
+            s.status.sprite_overflow = 0;
             // Clear the sprite zero hit flag
-            status_.sprite_zero_hit = 0;
+            s.status.sprite_zero_hit = 0;
             // Clear Shifters
             for (int i = 0; i < 8; i++) {
-                sprite_shifter_pattern_lo_[i] = 0;
-                sprite_shifter_pattern_hi_[i] = 0;
+                s.sprite_shifter_pattern_lo[i] = 0;
+                s.sprite_shifter_pattern_hi[i] = 0;
             }
         }
+        if (s.cycle == 1) {
+            is_line_rendered_ = isLineRendered(true);
+        }
 
         // tile fetch
-        if ((cycle_ >= 2 && cycle_ < 258) || (cycle_ >= 321 && cycle_ < 338)) {
+        if ((s.cycle >= 2 && s.cycle < 258) || (s.cycle >= 321 && s.cycle < 338)) {
             update_shifter_func();
 
-            // each event timing sequence takes  2 clock cycles
-            switch ((cycle_ - 1) % 8) {
+            // each event timing sequence takes  2 clock cycles, lines without fetches only move
+            // the scroll position on
+            int step = (s.cycle - 1) % 8;
+            if (!is_line_rendered_ && step != 7) {
+                step = -1;
+            }
+            switch (step) {
             case 0:
             {
                 load_shifter_func();
-                bg_next_tile_.id = ppuRead(0x2000 | (vram_addr_.reg & 0x0FFF));
+                s.bg_next_tile.id = ppuRead(0x2000 | (s.vram_addr.reg & 0x0FFF));
                 break;
             }
             case 2:
@@ -580,9 +760,9 @@ void PPU::clock()
                 // All attribute memory begins at 0x03C0 within a nametable, so OR with
                 // result to select target nametable, and attribute byte offset. Finally
                 // OR with 0x2000 to offset into nametable address space on PPU bus.
-                bg_next_tile_.attribute = ppuRead(
-                    0x23C0 | (vram_addr_.nametable_y << 11) | (vram_addr_.nametable_x << 10)
-                    | ((vram_addr_.coarse_y >> 2) << 3) | (vram_addr_.coarse_x >> 2));
+                s.bg_next_tile.attribute = ppuRead(
+                    0x23C0 | (s.vram_addr.nametable_y << 11) | (s.vram_addr.nametable_x << 10)
+                    | ((s.vram_addr.coarse_y >> 2) << 3) | (s.vram_addr.coarse_x >> 2));
 
                 // Right we've read the correct attribute byte for a specified address,
                 // but the byte itself is broken down further into the 2x2 tile groups
@@ -602,14 +782,14 @@ void PPU::clock()
                 // groups:
                 // - coarse Y(0b1x) means bottom half and coarse Y(0b0x) meas top half
                 // - coarse X(0bx1) means right half and coarse X(0bx0) meas right half
-                if ((vram_addr_.coarse_y & 0x02) != 0) {
-                    bg_next_tile_.attribute >>= 4;
+                if ((s.vram_addr.coarse_y & 0x02) != 0) {
+                    s.bg_next_tile.attribute >>= 4;
                 }
-                if ((vram_addr_.coarse_x & 0x02) != 0) {
-                    bg_next_tile_.attribute >>= 2;
+                if ((s.vram_addr.coarse_x & 0x02) != 0) {
+                    s.bg_next_tile.attribute >>= 2;
                 }
                 // Finally we only use the last two LSB
-                bg_next_tile_.attribute &= 0x03;
+                s.bg_next_tile.attribute &= 0x03;
             }
             case 4:
             {
@@ -626,16 +806,17 @@ void PPU::clock()
                 // |+-------------- H: Half of pattern table (0: "left"; 1: "right")
                 // +--------------- 0: Pattern table is at $0000-$1FFF
                 //
-                bg_next_tile_.lsb = ppuRead((control_.background_pattern_table_addr << 12)
-                                            + (static_cast<uint16_t>(bg_next_tile_.id) << 4)
-                                            + (vram_addr_.fine_y) + 0);
+                s.bg_next_tile.lsb = ppuRead((s.control.background_pattern_table_addr << 12)
+                                             + (static_cast<uint16_t>(s.bg_next_tile.id) << 4)
+                                             + (s.vram_addr.fine_y) + 0);
                 break;
             }
             case 6:
             {
-                bg_next_tile_.msb = ppuRead((control_.background_pattern_table_addr << 12)
-                                            + (static_cast<uint16_t>(bg_next_tile_.id) << 4)
-                                            + (vram_addr_.fine_y) + 8 /*offset to next bit plane*/);
+                s.bg_next_tile.msb = ppuRead((s.control.background_pattern_table_addr << 12)
+                                             + (static_cast<uint16_t>(s.bg_next_tile.id) << 4)
+                                             + (s.vram_addr.fine_y)
+                                             + 8 /*offset to next bit plane*/);
                 break;
             }
             case 7:
@@ -648,127 +829,127 @@ void PPU::clock()
             }
         }
 
-        if (cycle_ == 256) {
+        if (s.cycle == 256) {
             increment_scrolly_func();
         }
 
         // reset x position
-        if (cycle_ == 257) {
-            load_shifter_func();
+        if (s.cycle == 257) {
+            if (is_line_rendered_) {
+                load_shifter_func();
+            }
             transfer_address_x_func();
         }
 
         // Superfluous reads of tile id at end of scanline
-        if (cycle_ == 338 || cycle_ == 340) {
+        if ((s.cycle == 338 || s.cycle == 340) && is_line_rendered_) {
             // NES Dev wiki - Tile and attribute fetching:
             // <https://www.nesdev.org/wiki/PPU_scrolling#Tile_and_attribute_fetching>
             // Note: 0x2000 is the start address of nametable, whose size is 0x1000
-            bg_next_tile_.id = ppuRead(0x2000 | (vram_addr_.reg & 0x0FFF));
+            s.bg_next_tile.id = ppuRead(0x2000 | (s.vram_addr.reg & 0x0FFF));
+        }
+
+        // scanline counters of the cartridge, only two dots per line can raise A12
+        if ((s.cycle == 260 || s.cycle == 324) && cart_->isA12Watched()) {
+            checkA12Rise();
         }
 
         // reset y position
-        if (scanline_ == -1 && cycle_ >= 280 && cycle_ < 305) {
+        if (s.scanline == -1 && s.cycle >= 280 && s.cycle < 305) {
             transfer_address_y_func();
         }
 
         //= Foreground Rendering
         // Sprite evaluation for next scanline
-        if (cycle_ == 257 && scanline_ >= 0) {
-            // Hide a sprite by moving it down offscreen, by writing any values between #$EF-#$FF
-            std::memset(sprite_per_scanline_, 0xFF, 8 * sizeof(ObjectAttributeEntry));
-            // The NES supports a maximum number of sprites per scanline. Nominally
-            // this is 8 or fewer sprites.
-            sprite_count_ = 0;
-
+        if (s.cycle == 257 && s.scanline >= 0) {
             // clear out any residual information in sprite pattern shifters
             for (uint8_t i = 0; i < 8; i++) {
-                sprite_shifter_pattern_lo_[i] = 0;
-                sprite_shifter_pattern_hi_[i] = 0;
+                s.sprite_shifter_pattern_lo[i] = 0;
+                s.sprite_shifter_pattern_hi[i] = 0;
             }
 
-            uint8_t n_oam_entry = 0;
-            while (n_oam_entry < 64 && sprite_count_ < 9) {
-                int16_t diff
-                    = (static_cast<int16_t>(scanline_) - static_cast<int16_t>(OAM_[n_oam_entry].y));
-
-                if (diff >= 0 && diff < (control_.sprite_size ? 16 : 8)) {
-                    if (sprite_count_ < 8) {
-                        // Is this sprite sprite zero?
-                        if (n_oam_entry == 0) {
-                            sprite_zero_hit_possible_ = true;
-                        }
+            if (sprite_buckets_dirty_) {
+                rebuildSpriteBuckets();
+            }
 
-                        memcpy(&sprite_per_scanline_[sprite_count_], &OAM_[n_oam_entry],
-                               sizeof(ObjectAttributeEntry));
-                        sprite_count_ += 1;
-                    }
+            // The NES supports a maximum number of sprites per scanline. Nominally
+            // this is 8 or fewer sprites.
+            const SpriteBucket &bucket = sprite_buckets_[s.scanline];
+            s.sprite_count = bucket.count > 8 ? 8 : bucket.count;
+            for (uint8_t i = 0; i < s.sprite_count; i += 1) {
+                // Is this sprite sprite zero?
+                if (bucket.index[i] == 0) {
+                    s.sprite_zero_hit_possible = true;
                 }
-                n_oam_entry += 1;
-            } // End of sprite evaluation for next scanline
+                s.sprite_per_scanline[i] = s.oam[bucket.index[i]];
+            }
 
             // Set sprite overflow flag
-            status_.sprite_overflow = (sprite_count_ > 8);
+            s.status.sprite_overflow = (bucket.count > 8);
+
+            // the fetches for the next line are all that is left of this one
+            is_line_rendered_ = isLineRendered(false);
         }
 
         // one scanline end
-        if (cycle_ == 340) {
+        if (s.cycle == 340 && is_line_rendered_) {
             // now we need to prepare the sprite shifter with selected sprites
-            for (uint8_t i = 0; i < sprite_count_; i++) {
+            for (uint8_t i = 0; i < s.sprite_count; i++) {
                 uint8_t sprite_pattern_bits_lo;
                 uint8_t sprite_pattern_bits_hi;
                 uint16_t sprite_pattern_addr_lo;
                 uint16_t sprite_pattern_addr_hi;
 
                 // 8x8 Sprite Mode - The control register determines the pattern table
-                if (!control_.sprite_size) {
+                if (!s.control.sprite_size) {
                     // normal, no vertical flip
-                    if ((sprite_per_scanline_[i].attribute & 0x80) == 0) {
+                    if ((s.sprite_per_scanline[i].attribute & 0x80) == 0) {
                         sprite_pattern_addr_lo
-                            = (control_.sprite_pattern_table_addr << 12) // pattern table
-                              | (sprite_per_scanline_[i].id << 4)        // tile id * 16 bytes
-                              | (scanline_ - sprite_per_scanline_[i].y); // row in cell?(0~7)
+                            = (s.control.sprite_pattern_table_addr << 12)  // pattern table
+                              | (s.sprite_per_scanline[i].id << 4)         // tile id * 16 bytes
+                              | (s.scanline - s.sprite_per_scanline[i].y); // row in cell?(0~7)
                     }
                     // flip vertically, upside down
                     else {
-                        sprite_pattern_addr_lo = (control_.sprite_pattern_table_addr << 12)
-                                                 | (sprite_per_scanline_[i].id << 4)
-                                                 | (7 - (scanline_ - sprite_per_scanline_[i].y));
+                        sprite_pattern_addr_lo = (s.control.sprite_pattern_table_addr << 12)
+                                                 | (s.sprite_per_scanline[i].id << 4)
+                                                 | (7 - (s.scanline - s.sprite_per_scanline[i].y));
                     }
                 }
                 // 8x16 Sprite Mode - The sprite attribute determines the pattern table
                 else {
                     // normal
-                    if ((sprite_per_scanline_[i].attribute & 0x80) == 0) {
+                    if ((s.sprite_per_scanline[i].attribute & 0x80) == 0) {
                         // top half tile
-                        if (scanline_ - sprite_per_scanline_[i].y < 8) {
+                        if (s.scanline - s.sprite_per_scanline[i].y < 8) {
                             sprite_pattern_addr_lo
-                                = ((sprite_per_scanline_[i].id & 0x01) << 12) // pattern table
-                                  | ((sprite_per_scanline_[i].id & 0xFE) << 4)
-                                  | ((scanline_ - sprite_per_scanline_[i].y) & 0x07);
+                                = ((s.sprite_per_scanline[i].id & 0x01) << 12) // pattern table
+                                  | ((s.sprite_per_scanline[i].id & 0xFE) << 4)
+                                  | ((s.scanline - s.sprite_per_scanline[i].y) & 0x07);
                         }
                         // bottom half tile
                         else {
                             sprite_pattern_addr_lo
-                                = ((sprite_per_scanline_[i].id & 0x01) << 12) // pattern table
-                                  | (((sprite_per_scanline_[i].id & 0xFE) + 1) << 4)
-                                  | ((scanline_ - sprite_per_scanline_[i].y) & 0x07);
+                                = ((s.sprite_per_scanline[i].id & 0x01) << 12) // pattern table
+                                  | (((s.sprite_per_scanline[i].id & 0xFE) + 1) << 4)
+                                  | ((s.scanline - s.sprite_per_scanline[i].y) & 0x07);
                         }
                     }
                     // flip vertically
                     else {
                         // top half tile
-                        if (scanline_ - sprite_per_scanline_[i].y < 8) {
+                        if (s.scanline - s.sprite_per_scanline[i].y < 8) {
                             sprite_pattern_addr_lo
-                                = ((sprite_per_scanline_[i].id & 0x01) << 12) // pattern table
-                                  | ((sprite_per_scanline_[i].id & 0xFE) << 4)
-                                  | (7 - (scanline_ - sprite_per_scanline_[i].y) & 0x07);
+                                = ((s.sprite_per_scanline[i].id & 0x01) << 12) // pattern table
+                                  | ((s.sprite_per_scanline[i].id & 0xFE) << 4)
+                                  | (7 - (s.scanline - s.sprite_per_scanline[i].y) & 0x07);
                         }
                         // bottom half tile
                         else {
                             sprite_pattern_addr_lo
-                                = ((sprite_per_scanline_[i].id & 0x01) << 12) // pattern table
-                                  | (((sprite_per_scanline_[i].id & 0xFE) + 1) << 4)
-                                  | (7 - (scanline_ - sprite_per_scanline_[i].y) & 0x07);
+                                = ((s.sprite_per_scanline[i].id & 0x01) << 12) // pattern table
+                                  | (((s.sprite_per_scanline[i].id & 0xFE) + 1) << 4)
+                                  | (7 - (s.scanline - s.sprite_per_scanline[i].y) & 0x07);
                         }
                     }
                 }
@@ -780,7 +961,7 @@ void PPU::clock()
 
                 // If the sprite is flipped horizontally, we need to flip the
                 // pattern bytes.
-                if ((sprite_per_scanline_[i].attribute & 0x40) != 0) {
+                if ((s.sprite_per_scanline[i].attribute & 0x40) != 0) {
                     // https://stackoverflow.com/a/2602885
                     auto flip_byte = [](uint8_t b)
                     {
@@ -792,139 +973,155 @@ void PPU::clock()
                     sprite_pattern_bits_lo = flip_byte(sprite_pattern_bits_lo);
                     sprite_pattern_bits_hi = flip_byte(sprite_pattern_bits_hi);
                 }
-                sprite_shifter_pattern_lo_[i] = sprite_pattern_bits_lo;
-                sprite_shifter_pattern_hi_[i] = sprite_pattern_bits_hi;
+                s.sprite_shifter_pattern_lo[i] = sprite_pattern_bits_lo;
+                s.sprite_shifter_pattern_hi[i] = sprite_pattern_bits_hi;
             }
         }
     }
 
     // Post-render scanline
-    if (scanline_ == 240) {
+    if (s.scanline == 240) {
         ; // idle
     }
 
     // Vertical blanking lines
-    if (scanline_ >= 241 && scanline_ < 261) {
-        if (scanline_ == 241 && cycle_ == 1) {
-            status_.vertical_blank = 1;
-            if (control_.enable_nmi) {
-                nmi = true;
+    if (s.scanline >= 241 && s.scanline < 261) {
+        if (s.scanline == 241 && s.cycle == 1) {
+            s.status.vertical_blank = 1;
+            if (s.control.enable_nmi) {
+                s.nmi = true;
             }
         }
     }
 
-    // Composition - We now have background pixel information for this cycle
-    // At this point we are only interested in background
-
-    //= Background
-    uint8_t bg_pixel = 0x00;   // The 2-bit pixel index
-    uint8_t bg_palette = 0x00; // The 3-bit palette index
-    if (mask_.render_background) {
-        uint16_t bit_mux = 0x8000 >> fine_x_;
-
-        // Select Plane pixels by extracting from the shifter
-        // at the required location.
-        auto p0_pixel = static_cast<uint8_t>((bg_shifter_pattern_.lo & bit_mux) > 0);
-        auto p1_pixel = static_cast<uint8_t>((bg_shifter_pattern_.hi & bit_mux) > 0);
-
-        // Combine to form pixel index
-        bg_pixel = (p1_pixel << 1) | p0_pixel;
-        // Get palette
-        auto bg_pal0 = static_cast<uint8_t>((bg_shifter_attribute_.lo & bit_mux) > 0);
-        auto bg_pal1 = static_cast<uint8_t>((bg_shifter_attribute_.hi & bit_mux) > 0);
-        bg_palette = (bg_pal1 << 1) | bg_pal0;
-    }
-
-    //= Foreground
-    uint8_t fg_pixel = 0x00;    // The 2-bit pixel index
-    uint8_t fg_palette = 0x00;  // The 3-bit palette index
-    uint8_t fg_priority = 0x00; // A bit of the sprite attribute indicates if its
-                                // more important than the background
-    if (mask_.render_sprites) {
-        sprite_zero_being_rendered_ = false;
-
-        for (uint8_t i = 0; i < sprite_count_; i++) {
-            // scanline cycle has "collided" with sprite, shifters taking over
-            if (sprite_per_scanline_[i].x == 0) {
-                auto fg_pixel_lo = static_cast<uint8_t>((sprite_shifter_pattern_lo_[i] & 0x80) > 0);
-                auto fg_pixel_hi = static_cast<uint8_t>((sprite_shifter_pattern_hi_[i] & 0x80) > 0);
-                fg_pixel = (fg_pixel_hi << 1) | fg_pixel_lo;
-
-                fg_palette = (sprite_per_scanline_[i].attribute & 0x03) + 0x04;
-                fg_priority = static_cast<uint8_t>((sprite_per_scanline_[i].attribute & 0x20) == 0);
-
-                // rendering non-transparent pixel
-                if (fg_pixel != 0) {
-                    // Is this sprite zero?
-                    if (i == 0) {
-                        sprite_zero_being_rendered_ = true;
+    // On skipped frames the picture is never looked at, so palette lookup, priority muxing and the
+    // framebuffer write are left out. Only the sprite zero collision has to be resolved because
+    // the game can observe it through PPUSTATUS.
+    if (!is_frame_rendered_) {
+        if (s.sprite_zero_hit_possible && s.sprite_count > 0 && s.sprite_per_scanline[0].x == 0
+            && (s.mask.render_background & s.mask.render_sprites) != 0)
+        {
+            uint16_t bit_mux = 0x8000 >> s.fine_x;
+            bool bg_opaque = ((s.bg_shifter_pattern.lo | s.bg_shifter_pattern.hi) & bit_mux) != 0;
+            bool fg_opaque
+                = ((s.sprite_shifter_pattern_lo[0] | s.sprite_shifter_pattern_hi[0]) & 0x80) != 0;
+            if (bg_opaque && fg_opaque) {
+                setSpriteZeroHit();
+            }
+        }
+    }
+    else {
+        // Composition - We now have background pixel information for this cycle
+        // At this point we are only interested in background
+
+        //= Background
+        uint8_t bg_pixel = 0x00;   // The 2-bit pixel index
+        uint8_t bg_palette = 0x00; // The 3-bit palette index
+        if (s.mask.render_background) {
+            uint16_t bit_mux = 0x8000 >> s.fine_x;
+
+            // Select Plane pixels by extracting from the shifter
+            // at the required location.
+            auto p0_pixel = static_cast<uint8_t>((s.bg_shifter_pattern.lo & bit_mux) > 0);
+            auto p1_pixel = static_cast<uint8_t>((s.bg_shifter_pattern.hi & bit_mux) > 0);
+
+            // Combine to form pixel index
+            bg_pixel = (p1_pixel << 1) | p0_pixel;
+            // Get palette
+            auto bg_pal0 = static_cast<uint8_t>((s.bg_shifter_attribute.lo & bit_mux) > 0);
+            auto bg_pal1 = static_cast<uint8_t>((s.bg_shifter_attribute.hi & bit_mux) > 0);
+            bg_palette = (bg_pal1 << 1) | bg_pal0;
+        }
+
+        //= Foreground
+        uint8_t fg_pixel = 0x00;    // The 2-bit pixel index
+        uint8_t fg_palette = 0x00;  // The 3-bit palette index
+        uint8_t fg_priority = 0x00; // A bit of the sprite attribute indicates if its
+                                    // more important than the background
+        if (s.mask.render_sprites) {
+            s.sprite_zero_being_rendered = false;
+
+            for (uint8_t i = 0; i < s.sprite_count; i++) {
+                // scanline cycle has "collided" with sprite, shifters taking over
+                if (s.sprite_per_scanline[i].x == 0) {
+                    auto fg_pixel_lo
+                        = static_cast<uint8_t>((s.sprite_shifter_pattern_lo[i] & 0x80) > 0);
+                    auto fg_pixel_hi
+                        = static_cast<uint8_t>((s.sprite_shifter_pattern_hi[i] & 0x80) > 0);
+                    fg_pixel = (fg_pixel_hi << 1) | fg_pixel_lo;
+
+                    fg_palette = (s.sprite_per_scanline[i].attribute & 0x03) + 0x04;
+                    fg_priority
+                        = static_cast<uint8_t>((s.sprite_per_scanline[i].attribute & 0x20) == 0);
+
+                    // rendering non-transparent pixel
+                    if (fg_pixel != 0) {
+                        // Is this sprite zero?
+                        if (i == 0) {
+                            s.sprite_zero_being_rendered = true;
+                        }
+                        break;
                     }
-                    break;
                 }
             }
         }
-    }
 
-    // Now we have a background pixel and a foreground pixel. They need
-    // to be combined.
+        // Now we have a background pixel and a foreground pixel. They need
+        // to be combined.
 
-    uint8_t pixel = 0x00;
-    uint8_t palette = 0x00;
+        uint8_t pixel = 0x00;
+        uint8_t palette = 0x00;
 
-    // both bg and fg are transparent
-    if (bg_pixel == 0 && fg_pixel == 0) {
-        pixel = 0;
-        palette = 0;
-    }
+        // both bg and fg are transparent
+        if (bg_pixel == 0 && fg_pixel == 0) {
+            pixel = 0;
+            palette = 0;
+        }
 
-    else if (bg_pixel != 0 && fg_pixel == 0) {
-        pixel = bg_pixel;
-        palette = bg_palette;
-    }
-    else if (bg_pixel == 0 && fg_pixel != 0) {
-        pixel = fg_pixel;
-        palette = fg_palette;
-    }
-    else {
-        if (fg_priority != 0U) {
+        else if (bg_pixel != 0 && fg_pixel == 0) {
+            pixel = bg_pixel;
+            palette = bg_palette;
+        }
+        else if (bg_pixel == 0 && fg_pixel != 0) {
             pixel = fg_pixel;
             palette = fg_palette;
         }
         else {
-            pixel = bg_pixel;
-            palette = bg_palette;
-        }
+            if (fg_priority != 0U) {
+                pixel = fg_pixel;
+                palette = fg_palette;
+            }
+            else {
+                pixel = bg_pixel;
+                palette = bg_palette;
+            }
 
-        // Sprite Zero Hit detection
-        if (sprite_zero_hit_possible_ && sprite_zero_being_rendered_) {
-            if ((mask_.render_background & mask_.render_sprites) != 0) {
-                // The left edge of the screen has specific switches to control
-                // its appearance. This is used to smooth inconsistencies when
-                // scrolling (since sprites x coord must be >= 0)
-                if ((~(mask_.render_background_left | mask_.render_sprites_left)) != 0) {
-                    if (cycle_ >= 9 && cycle_ < 258) {
-                        status_.sprite_zero_hit = 1;
-                    }
-                }
-                else {
-                    if (cycle_ >= 1 && cycle_ < 258) {
-                        status_.sprite_zero_hit = 1;
-                    }
+            // Sprite Zero Hit detection
+            if (s.sprite_zero_hit_possible && s.sprite_zero_being_rendered) {
+                if ((s.mask.render_background & s.mask.render_sprites) != 0) {
+                    setSpriteZeroHit();
                 }
             }
         }
-    }
 
-    vscreen_main_->setPixel(cycle_ - 1, scanline_, getColorFromPaletteMemory(palette, pixel));
+        vscreen_main_->setPixel(s.cycle - 1, s.scanline,
+                                getColorFromPaletteMemory(palette, pixel));
+    }
 
     // advance rendering
-    cycle_ += 1;
-    if (cycle_ >= 341) {
-        cycle_ = 0;
-        scanline_ += 1;
-        if (scanline_ >= 261) {
-            scanline_ = -1;
-            frame_complete_ = true;
+    s.cycle += 1;
+    if (s.cycle >= 341) {
+        s.cycle = 0;
+        s.scanline += 1;
+        if (s.scanline >= 261) {
+            s.scanline = -1;
+            s.frame_complete = true;
+            if (render_worker_ != nullptr) {
+                render_worker_->submitFrame();
+            }
+            else if (frame_skip_ != 0 || is_adaptive_frame_skip_) {
+                decideFrameSkip();
+            }
         }
     }
 }
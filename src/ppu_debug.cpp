@@ -0,0 +1,306 @@
+#include "tinynes/ppu.h"
+#include "tinynes/palette_color.h"
+#include "tinynes/vscreen.h"
+
+#include <memory>
+
+namespace tn
+{
+
+/**
+ * Debug views only read the PPU memory, they never go through the grayscale mask or any other
+ * state that affects the picture drawn by the game. Pixel 0 of every palette shows the universal
+ * background color, the same as on screen.
+ */
+uint8_t PPU::getDebugColorIndex(uint8_t palette, uint8_t pixel)
+{
+    if (pixel == 0) {
+        palette = 0;
+    }
+    return state_->palette_table[PALETTE_INDEX[((palette << 2) + pixel) & 0x1F]] & 0x3F;
+}
+
+/**
+ * According to NES Dev wiki description, PPU has a pattern table to define the shapes of tiles that
+ * makes update the backgrounds and sprites. Generally, each tile in pattern table is 16 bytes, made
+ * of two planes. So we can individually divide them to LSB plane and MSB plane, where the tiles in
+ * each plane are 8 bytes size, occupying 8x8 pixels.
+ *
+ * LSB and MSB tile combines and provide 4 types of pixel functions:
+ * - 00: transparent color
+ * - 01: color index 1
+ * - 10: color index 2
+ * - 11: color index 3
+ *
+ * The planes are stored as 8 bytes of LSB, followed by 8 bytes of MSB.
+ *
+ * According to [PPU memory map]<https://www.nesdev.org/wiki/PPU_memory_map>, the pattern table is
+ * divided into two 256-tile sections: $0000-$0FFF, nicknamed "left", and $1000-$1FFF, nicknamed
+ * "right".
+ *
+ * @param idx pattern table index, 0 'left', 1 'right'
+ * @ref NES Dev wiki - PPU pattern tables: <https://www.nesdev.org/wiki/PPU_pattern_tables>
+ * @warning Don't forget to call update() function after you require the updated pattern table
+ *          sprite.
+ * @return Vscreen smart shared pointer used for drawing
+ */
+std::shared_ptr<VScreen> PPU::vScreenPatternTable(uint8_t idx, uint8_t palette)
+{
+    DebugView &view = debug_pattern_table_[idx & 0x01];
+    if (view.screen == nullptr) {
+        view.screen = std::make_shared<VScreen>(128, 128, sf::Color::Black);
+    }
+
+    DebugStamp stamp;
+    stamp.chr = debug_dirty_.chr;
+    stamp.chr_map = cart_ != nullptr ? cart_->chrMapGeneration() : 0;
+    stamp.palette = debug_dirty_.palette;
+    stamp.param = palette;
+    if (view.is_valid && view.stamp == stamp) {
+        return view.screen;
+    }
+
+    for (uint16_t ytile = 0; ytile < 16; ytile += 1) {
+        for (uint16_t xtile = 0; xtile < 16; xtile += 1) {
+            // each tile is 16 bytes !!!
+            uint16_t offset = ytile * 256 + xtile * 16;
+
+            // now loop through the 8x8 pixels  tile
+            for (uint16_t row = 0; row < 8; row += 1) {
+                // If you get confused with the following code, please look at "Bit Planes" example
+                // on <https://www.nesdev.org/wiki/PPU_pattern_tables>. 'ppuRead' read 1 byte each
+                // time.
+                uint8_t tile_lsb = ppuRead(idx * 0x1000 + offset + row + 0x0000, true);
+                uint8_t tile_msb = ppuRead(idx * 0x1000 + offset + row + 0x0008, true);
+
+                for (uint16_t col = 0; col < 8; col += 1) {
+                    uint8_t pixel = ((tile_msb & 0x01) << 1) | (tile_lsb & 0x01);
+                    tile_lsb >>= 1;
+                    tile_msb >>= 1;
+
+                    view.screen->setPixel(xtile * 8 + (7 - col), // inverse to draw pixels from left
+                                          ytile * 8 + row,
+                                          sf::Color(COLORS[getDebugColorIndex(palette, pixel)]));
+                }
+            }
+        }
+    }
+
+    view.stamp = stamp;
+    view.is_valid = true;
+    return view.screen;
+}
+
+/**
+ * Draw one of the four logical nametables ($2000, $2400, $2800, $2C00) after mirroring, using the
+ * background pattern table selected in PPUCTRL. The visible 256x240 scroll window is outlined on
+ * top of it, it may wrap around into the neighbouring nametables.
+ *
+ * @ref NES Dev wiki - PPU nametables: <https://www.nesdev.org/wiki/PPU_nametables>
+ * @ref NES Dev wiki - PPU attribute tables: <https://www.nesdev.org/wiki/PPU_attribute_tables>
+ */
+std::shared_ptr<VScreen> PPU::vScreenNameTable(uint8_t idx)
+{
+    idx &= 0x03;
+    DebugNameTableView &view = debug_name_table_[idx];
+    if (view.screen == nullptr) {
+        view.screen = std::make_shared<VScreen>(256, 240, sf::Color::Black);
+        view.color_index.resize(256 * 240);
+    }
+
+    DebugStamp stamp;
+    stamp.chr = debug_dirty_.chr;
+    stamp.chr_map = cart_ != nullptr ? cart_->chrMapGeneration() : 0;
+    stamp.vram = debug_dirty_.vram;
+    stamp.palette = debug_dirty_.palette;
+    stamp.param = state_->control.background_pattern_table_addr;
+
+    // The scroll written by the game for the next frame lives in 't' and fine x
+    const uint32_t scroll = (static_cast<uint32_t>(state_->fine_x) << 16) | state_->tram_addr.reg;
+
+    if (view.is_valid && view.stamp == stamp) {
+        if (view.scroll != scroll) {
+            drawScrollWindow(idx, true);
+            view.scroll = scroll;
+            drawScrollWindow(idx, false);
+        }
+        return view.screen;
+    }
+
+    const uint8_t *page = name_table_page_[idx];
+    const uint16_t pattern_base = state_->control.background_pattern_table_addr << 12;
+    for (uint16_t ytile = 0; ytile < 30; ytile += 1) {
+        for (uint16_t xtile = 0; xtile < 32; xtile += 1) {
+            uint16_t tile_id = page[ytile * 32 + xtile];
+            // one attribute byte covers 4x4 tiles, 2 bits per 2x2 tile group
+            uint8_t attribute = page[0x03C0 + (ytile >> 2) * 8 + (xtile >> 2)];
+            uint8_t palette = (attribute >> (((ytile & 0x02) << 1) | (xtile & 0x02))) & 0x03;
+
+            for (uint16_t row = 0; row < 8; row += 1) {
+                uint8_t tile_lsb = ppuRead(pattern_base + (tile_id << 4) + row + 0x0000, true);
+                uint8_t tile_msb = ppuRead(pattern_base + (tile_id << 4) + row + 0x0008, true);
+
+                for (uint16_t col = 0; col < 8; col += 1) {
+                    uint8_t pixel = ((tile_msb & 0x80) >> 6) | ((tile_lsb & 0x80) >> 7);
+                    tile_lsb <<= 1;
+                    tile_msb <<= 1;
+
+                    uint32_t x = xtile * 8 + col;
+                    uint32_t y = ytile * 8 + row;
+                    uint8_t color_index = getDebugColorIndex(palette, pixel);
+                    view.color_index[y * 256 + x] = color_index;
+                    view.screen->setPixel(x, y, sf::Color(COLORS[color_index]));
+                }
+            }
+        }
+    }
+
+    view.stamp = stamp;
+    view.is_valid = true;
+    view.scroll = scroll;
+    drawScrollWindow(idx, false);
+    return view.screen;
+}
+
+/**
+ * The four nametables form a 512x480 plane. Walk the outline of the 256x240 window starting at
+ * the scroll position and draw the part of it which falls into nametable 'idx'. With 'restore'
+ * set, the pixels under the outline are put back from the decoded nametable instead.
+ */
+void PPU::drawScrollWindow(uint8_t idx, bool restore)
+{
+    DebugNameTableView &view = debug_name_table_[idx];
+
+    LoopyRegister scroll;
+    scroll.reg = view.scroll & 0xFFFF;
+    const uint32_t left = scroll.nametable_x * 256 + scroll.coarse_x * 8 + (view.scroll >> 16);
+    const uint32_t top = scroll.nametable_y * 240 + scroll.coarse_y * 8 + scroll.fine_y;
+
+    auto plot = [&](uint32_t gx, uint32_t gy)
+    {
+        gx %= 512;
+        gy %= 480;
+        if ((gx / 256) + (gy / 240) * 2 != idx) {
+            return;
+        }
+        uint32_t x = gx % 256;
+        uint32_t y = gy % 240;
+        view.screen->setPixel(x, y,
+                              restore ? sf::Color(COLORS[view.color_index[y * 256 + x]])
+                                      : sf::Color(255, 0, 255));
+    };
+
+    for (uint32_t i = 0; i < 256; i += 1) {
+        plot(left + i, top);
+        plot(left + i, top + 239);
+    }
+    for (uint32_t i = 0; i < 240; i += 1) {
+        plot(left, top + i);
+        plot(left + 255, top + i);
+    }
+}
+
+/**
+ * Palette RAM as two rows of 16 swatches, background palettes on top and sprite palettes below.
+ *
+ * @ref NES Dev wiki - PPU palettes: <https://www.nesdev.org/wiki/PPU_palettes>
+ */
+std::shared_ptr<VScreen> PPU::vScreenPalette()
+{
+    DebugView &view = debug_palette_;
+    if (view.screen == nullptr) {
+        view.screen = std::make_shared<VScreen>(128, 16, sf::Color::Black);
+    }
+
+    DebugStamp stamp;
+    stamp.palette = debug_dirty_.palette;
+    if (view.is_valid && view.stamp == stamp) {
+        return view.screen;
+    }
+
+    for (uint8_t entry = 0; entry < 32; entry += 1) {
+        sf::Color color(COLORS[state_->palette_table[PALETTE_INDEX[entry]] & 0x3F]);
+        uint32_t x0 = (entry & 0x0F) * 8;
+        uint32_t y0 = (entry >> 4) * 8;
+        for (uint32_t y = 0; y < 8; y += 1) {
+            for (uint32_t x = 0; x < 8; x += 1) {
+                view.screen->setPixel(x0 + x, y0 + y, color);
+            }
+        }
+    }
+
+    view.stamp = stamp;
+    view.is_valid = true;
+    return view.screen;
+}
+
+/**
+ * All 64 OAM sprites in an 8x8 grid. Every cell is 8x16 pixels so that 8x16 sprites fit as well,
+ * flipping and sprite palettes are applied the same way as when they are rendered.
+ *
+ * @ref NES Dev wiki - PPU OAM: <https://www.nesdev.org/wiki/PPU_OAM>
+ */
+std::shared_ptr<VScreen> PPU::vScreenSprites()
+{
+    DebugView &view = debug_sprites_;
+    if (view.screen == nullptr) {
+        view.screen = std::make_shared<VScreen>(64, 128, sf::Color::Black);
+    }
+
+    DebugStamp stamp;
+    stamp.chr = debug_dirty_.chr;
+    stamp.chr_map = cart_ != nullptr ? cart_->chrMapGeneration() : 0;
+    stamp.palette = debug_dirty_.palette;
+    stamp.oam = debug_dirty_.oam;
+    stamp.param = (state_->control.sprite_size << 1) | state_->control.sprite_pattern_table_addr;
+    if (view.is_valid && view.stamp == stamp) {
+        return view.screen;
+    }
+
+    const uint8_t sprite_height = state_->control.sprite_size ? 16 : 8;
+    const sf::Color backdrop(COLORS[getDebugColorIndex(0, 0)]);
+    for (uint8_t n = 0; n < 64; n += 1) {
+        const ObjectAttributeEntry &sprite = state_->oam[n];
+        const uint32_t x0 = (n & 0x07) * 8;
+        const uint32_t y0 = (n >> 3) * 16;
+        const uint8_t palette = (sprite.attribute & 0x03) + 0x04;
+
+        for (uint8_t row = 0; row < 16; row += 1) {
+            if (row >= sprite_height) {
+                for (uint8_t col = 0; col < 8; col += 1) {
+                    view.screen->setPixel(x0 + col, y0 + row, backdrop);
+                }
+                continue;
+            }
+
+            // flip vertically
+            uint8_t tile_row = (sprite.attribute & 0x80) != 0 ? sprite_height - 1 - row : row;
+            uint16_t tile_addr = 0;
+            if (sprite_height == 8) {
+                tile_addr = (state_->control.sprite_pattern_table_addr << 12) | (sprite.id << 4);
+            }
+            else {
+                tile_addr = ((sprite.id & 0x01) << 12)
+                            | (((sprite.id & 0xFE) + (tile_row >> 3)) << 4);
+            }
+            uint8_t tile_lsb = ppuRead(tile_addr + (tile_row & 0x07) + 0x0000, true);
+            uint8_t tile_msb = ppuRead(tile_addr + (tile_row & 0x07) + 0x0008, true);
+
+            for (uint8_t col = 0; col < 8; col += 1) {
+                // flip horizontally
+                uint8_t bit = (sprite.attribute & 0x40) != 0 ? col : 7 - col;
+                uint8_t pixel = (((tile_msb >> bit) & 0x01) << 1) | ((tile_lsb >> bit) & 0x01);
+                view.screen->setPixel(x0 + col, y0 + row,
+                                      pixel == 0 ? backdrop
+                                                 : sf::Color(COLORS[getDebugColorIndex(palette,
+                                                                                       pixel)]));
+            }
+        }
+    }
+
+    view.stamp = stamp;
+    view.is_valid = true;
+    return view.screen;
+}
+
+} // namespace tn
@@ -0,0 +1,108 @@
+#include "tinynes/ppu_render_worker.h"
+#include "tinynes/cartridge.h"
+#include "tinynes/state_stream.h"
+#include "tinynes/vscreen.h"
+
+namespace tn
+{
+
+PPURenderWorker::PPURenderWorker(const PPU &ppu, const std::shared_ptr<Cartridge> &cartridge)
+    : shadow_cart_(cartridge->clone())
+{
+    shadow_ = ppu.cloneForRendering(shadow_cart_);
+    front_ = std::make_shared<VScreen>(256, 240, sf::Color::Black);
+    // a whole frame of register traffic rarely exceeds a few thousand events
+    recording_.reserve(4096);
+    replaying_.reserve(4096);
+    thread_ = std::thread(&PPURenderWorker::run, this);
+}
+
+PPURenderWorker::~PPURenderWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        is_quit_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+void PPURenderWorker::submitFrame()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    // the previous frame must be finished before its log buffer can be reused
+    cv_.wait(lock, [this] { return !is_busy_; });
+
+    // the shadow has just completed the frame before this one, publish it
+    if (is_frame_ready_) {
+        shadow_->swapMainScreen(front_);
+    }
+    recording_.swap(replaying_);
+    recording_.clear();
+    is_busy_ = true;
+    lock.unlock();
+    cv_.notify_all();
+}
+
+void PPURenderWorker::restart(const PPU &ppu, const Cartridge &cartridge)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return !is_busy_; });
+    // the events so far belong to the frame the restore has discarded, and until the shadow has
+    // composed a frame of the new state the last published one stays up
+    recording_.clear();
+    is_frame_ready_ = false;
+    cart_state_.clear();
+    StateWriter writer(cart_state_);
+    cartridge.saveState(writer);
+    StateReader reader(cart_state_.data(), cart_state_.size());
+    shadow_cart_->loadState(reader);
+    shadow_->copyStateFrom(ppu);
+}
+
+std::shared_ptr<VScreen> PPURenderWorker::vScreenMain()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return front_;
+}
+
+void PPURenderWorker::run()
+{
+    while (true) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return is_busy_ || is_quit_; });
+        if (is_quit_) {
+            return;
+        }
+        lock.unlock();
+
+        replay();
+
+        lock.lock();
+        is_busy_ = false;
+        is_frame_ready_ = true;
+        lock.unlock();
+        cv_.notify_all();
+    }
+}
+
+void PPURenderWorker::replay()
+{
+    // events were recorded after the emulated PPU had processed the dot before 'event.dot', which
+    // is exactly the moment the shadow reaches that dot
+    size_t idx = 0;
+    shadow_->setFrameState(false);
+    while (!shadow_->getFrameState()) {
+        while (idx < replaying_.size() && replaying_[idx].dot == shadow_->dot()) {
+            shadow_->replayRenderEvent(replaying_[idx]);
+            idx += 1;
+        }
+        shadow_->clock();
+    }
+    // never expected while both PPUs stay in lockstep, but keep the shadow state complete
+    for (; idx < replaying_.size(); idx += 1) {
+        shadow_->replayRenderEvent(replaying_[idx]);
+    }
+}
+
+} // namespace tn
@@ -0,0 +1,194 @@
+#include "tinynes/resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tn
+{
+
+namespace
+{
+
+constexpr double PI = 3.14159265358979323846;
+
+double blackman(double x)
+{
+    // 'x' in [0, 1]
+    return 0.42 - 0.5 * std::cos(2.0 * PI * x) + 0.08 * std::cos(4.0 * PI * x);
+}
+
+double sinc(double x)
+{
+    return std::fabs(x) < 1e-12 ? 1.0 : std::sin(PI * x) / (PI * x);
+}
+
+} // namespace
+
+void Resampler::HalfBand::design()
+{
+    constexpr int32_t HALF = TAPS / 2;
+    double sum = 0.0;
+    for (int32_t i = 0; i < static_cast<int32_t>(TAPS); i += 1) {
+        int32_t n = i - HALF;
+        // a half-band filter is exactly zero at every even offset but the center
+        double c = (n != 0 && n % 2 == 0) ? 0.0 : 0.5 * sinc(0.5 * n);
+        c *= blackman(static_cast<double>(i + 1) / (TAPS + 1));
+        coeff[i] = static_cast<float>(c);
+        sum += c;
+    }
+    for (auto &c : coeff) {
+        c = static_cast<float>(c / sum);
+    }
+    clear();
+}
+
+void Resampler::HalfBand::clear()
+{
+    std::fill(std::begin(history), std::end(history), 0.0F);
+    pos = 0;
+    is_odd = false;
+}
+
+bool Resampler::HalfBand::push(float sample, float &output)
+{
+    history[pos] = sample;
+    history[pos + TAPS] = sample;
+    pos = (pos + 1 == TAPS) ? 0 : pos + 1;
+
+    is_odd = !is_odd;
+    if (is_odd) {
+        return false;
+    }
+
+    // 'pos' is the oldest sample now
+    const float *window = &history[pos];
+    float acc = 0.0F;
+    for (uint32_t i = 0; i < TAPS; i += 1) {
+        acc += window[i] * coeff[i];
+    }
+    output = acc;
+    return true;
+}
+
+Resampler::Resampler()
+{
+    stage1_.design();
+    stage2_.design();
+    setRates(1789773.0 / 2.0, 44100.0);
+}
+
+void Resampler::setRates(double input_rate, double output_rate)
+{
+    input_rate_ = input_rate / 4.0;
+    output_rate_ = output_rate;
+
+    // low pass at 90% of the output Nyquist frequency, relative to the decimated input rate
+    double cutoff = 0.45 * output_rate_ / input_rate_;
+    taps_ = static_cast<uint32_t>(std::ceil(ZERO_CROSSINGS / cutoff)) & ~3U;
+    taps_ = std::max(taps_, 8U);
+
+    kernel_.assign(static_cast<size_t>(PHASES + 1) * taps_, 0.0F);
+    for (uint32_t phase = 0; phase <= PHASES; phase += 1) {
+        double frac = static_cast<double>(phase) / PHASES;
+        float *row = &kernel_[static_cast<size_t>(phase) * taps_];
+        for (uint32_t tap = 0; tap < taps_; tap += 1) {
+            // the output sample lies 'frac' after the center tap
+            double t = static_cast<double>(tap) - (taps_ / 2.0 - 1.0) - frac;
+            double w = (t + taps_ / 2.0) / taps_;
+            double c = 2.0 * cutoff * sinc(2.0 * cutoff * t) * blackman(std::clamp(w, 0.0, 1.0));
+            row[tap] = static_cast<float>(c);
+        }
+    }
+
+    setRatio(ratio_);
+    clear();
+}
+
+void Resampler::setRatio(double ratio)
+{
+    ratio_ = ratio;
+    step_ = input_rate_ / (output_rate_ * ratio_);
+}
+
+void Resampler::clear()
+{
+    stage1_.clear();
+    stage2_.clear();
+    buf_.assign(taps_, 0.0F);
+    pos_ = 0.0;
+}
+
+void Resampler::push(int32_t level, uint32_t count)
+{
+    float sample = static_cast<float>(level);
+    float decimated = 0.0F;
+    for (uint32_t i = 0; i < count; i += 1) {
+        if (stage1_.push(sample, decimated)) {
+            pushDecimated(decimated);
+        }
+    }
+}
+
+void Resampler::pushDecimated(float sample)
+{
+    float output = 0.0F;
+    if (stage2_.push(sample, output)) {
+        buf_.push_back(output);
+    }
+}
+
+uint32_t Resampler::inputNeeded() const
+{
+    size_t needed = static_cast<size_t>(pos_) + taps_ + 1;
+    if (needed <= buf_.size()) {
+        return 0;
+    }
+    // every decimated sample takes 4 inputs, minus those already waiting in the half-band stages
+    uint32_t missing = static_cast<uint32_t>(needed - buf_.size());
+    return missing * 4 - (stage1_.is_odd ? 1 : 0) - (stage2_.is_odd ? 2 : 0);
+}
+
+uint32_t Resampler::samplesAvailable() const
+{
+    size_t end = static_cast<size_t>(pos_) + taps_ + 1;
+    if (end > buf_.size()) {
+        return 0;
+    }
+    return static_cast<uint32_t>((buf_.size() - end) / step_) + 1;
+}
+
+float Resampler::readSample()
+{
+    auto idx = static_cast<size_t>(pos_);
+    double frac = (pos_ - static_cast<double>(idx)) * PHASES;
+    auto phase = static_cast<uint32_t>(frac);
+    auto mix = static_cast<float>(frac - phase);
+
+    // interpolate between the two closest phases. The compiler may not reorder a float sum, so
+    // each dot product keeps four partial sums that map to one vector register, 'taps_' is a
+    // multiple of 4 for this
+    const float *x = &buf_[idx];
+    const float *c0 = &kernel_[static_cast<size_t>(phase) * taps_];
+    const float *c1 = c0 + taps_;
+    float sum0[4] = {};
+    float sum1[4] = {};
+    for (uint32_t tap = 0; tap < taps_; tap += 4) {
+        for (uint32_t lane = 0; lane < 4; lane += 1) {
+            sum0[lane] += x[tap + lane] * c0[tap + lane];
+            sum1[lane] += x[tap + lane] * c1[tap + lane];
+        }
+    }
+    float acc0 = (sum0[0] + sum0[1]) + (sum0[2] + sum0[3]);
+    float acc1 = (sum1[0] + sum1[1]) + (sum1[2] + sum1[3]);
+
+    pos_ += step_;
+    // drop consumed input once in a while instead of on every sample
+    auto consumed = static_cast<size_t>(pos_);
+    if (consumed >= 1024) {
+        buf_.erase(buf_.begin(), buf_.begin() + static_cast<std::ptrdiff_t>(consumed));
+        pos_ -= static_cast<double>(consumed);
+    }
+    return acc0 + (acc1 - acc0) * mix;
+}
+
+} // namespace tn
@@ -0,0 +1,300 @@
+#include "tinynes/rewind.h"
+#include "tinynes/bus.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace tn
+{
+
+namespace
+{
+
+// zero runs shorter than this stay inside a literal, a new pair would cost more than the zeros
+constexpr std::size_t MIN_ZERO_RUN = 4;
+
+void putVarint(std::vector<uint8_t> &out, std::size_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getVarint(const uint8_t *&data, const uint8_t *end, std::size_t &value)
+{
+    value = 0;
+    for (uint32_t shift = 0; data != end && shift < 64; shift += 7) {
+        uint8_t byte = *data++;
+        value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t countZeros(const uint8_t *data, std::size_t idx, std::size_t size)
+{
+    std::size_t start = idx;
+    // eight at a time through the long untouched stretches of RAM and VRAM
+    for (uint64_t word = 0; idx + 8 <= size; idx += 8) {
+        std::memcpy(&word, data + idx, sizeof(word));
+        if (word != 0) {
+            break;
+        }
+    }
+    while (idx < size && data[idx] == 0) {
+        idx += 1;
+    }
+    return idx - start;
+}
+
+// The size, then pairs of a zero run and a literal run, all lengths as LEB128 varints
+void encodeRuns(const std::vector<uint8_t> &delta, std::vector<uint8_t> &out)
+{
+    out.clear();
+    putVarint(out, delta.size());
+    std::size_t idx = 0;
+    while (idx < delta.size()) {
+        std::size_t zeros = countZeros(delta.data(), idx, delta.size());
+        idx += zeros;
+        std::size_t literal = idx;
+        while (idx < delta.size()) {
+            if (delta[idx] != 0) {
+                idx += 1;
+                continue;
+            }
+            std::size_t run = countZeros(delta.data(), idx, delta.size());
+            if (run >= MIN_ZERO_RUN || idx + run == delta.size()) {
+                break;
+            }
+            idx += run;
+        }
+        putVarint(out, zeros);
+        putVarint(out, idx - literal);
+        out.insert(out.end(), delta.begin() + literal, delta.begin() + idx);
+    }
+}
+
+// 'state' becomes 'base' XOR the decoded runs, an empty base stands for all zeros
+bool decodeRuns(const std::vector<uint8_t> &data, const std::vector<uint8_t> &base,
+                std::vector<uint8_t> &state)
+{
+    const uint8_t *src = data.data();
+    const uint8_t *end = src + data.size();
+    std::size_t size = 0;
+    if (!getVarint(src, end, size) || (!base.empty() && base.size() != size)) {
+        return false;
+    }
+    if (base.empty()) {
+        state.assign(size, 0);
+    }
+    else {
+        state = base;
+    }
+    std::size_t pos = 0;
+    while (src != end) {
+        std::size_t zeros = 0;
+        std::size_t literal = 0;
+        if (!getVarint(src, end, zeros) || !getVarint(src, end, literal)) {
+            return false;
+        }
+        pos += zeros;
+        if (pos > size || literal > size - pos || literal > static_cast<std::size_t>(end - src)) {
+            return false;
+        }
+        for (std::size_t idx = 0; idx < literal; idx += 1) {
+            state[pos + idx] ^= src[idx];
+        }
+        pos += literal;
+        src += literal;
+    }
+    return true;
+}
+
+} // namespace
+
+Rewind::Rewind(Bus &bus, std::size_t memory_limit, uint32_t keyframe_interval)
+    : bus_(bus), memory_limit_(memory_limit),
+      keyframe_interval_(std::max<uint32_t>(keyframe_interval, 1))
+{
+    thread_ = std::thread(&Rewind::run, this);
+}
+
+Rewind::~Rewind()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        is_quit_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+void Rewind::capture()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> state;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!free_buffers_.empty()) {
+            state = std::move(free_buffers_.back());
+            free_buffers_.pop_back();
+        }
+    }
+    bool is_saved = bus_.saveState(state);
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (!is_saved) {
+        free_buffers_.push_back(std::move(state));
+        return;
+    }
+    pending_.push_back(std::move(state));
+    captures_ += 1;
+    capture_us_ += std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - start).count();
+    lock.unlock();
+    cv_.notify_all();
+}
+
+bool Rewind::stepBack(uint32_t frames)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    waitIdle(lock);
+    if (ring_.size() < 2 || frames == 0) {
+        return false;
+    }
+    std::size_t steps = std::min<std::size_t>(frames, ring_.size() - 1);
+    for (std::size_t idx = 0; idx < steps; idx += 1) {
+        bytes_ -= ring_.back().data.size();
+        ring_.pop_back();
+    }
+
+    // the newest keyframe may just have been dropped, decode the one the target refers to
+    std::size_t target = ring_.size() - 1;
+    std::size_t keyframe = target;
+    while (!ring_[keyframe].is_keyframe) {
+        keyframe -= 1;
+    }
+    bytes_ -= keyframe_.size();
+    bool is_ok = decodeRuns(ring_[keyframe].data, {}, keyframe_);
+    bytes_ += keyframe_.size();
+    since_keyframe_ = static_cast<uint32_t>(target - keyframe + 1);
+    if (is_ok && target != keyframe) {
+        is_ok = decodeRuns(ring_[target].data, keyframe_, delta_);
+    }
+    else {
+        delta_ = keyframe_;
+    }
+    lock.unlock();
+
+    return is_ok && bus_.loadState(delta_);
+}
+
+void Rewind::clear()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    waitIdle(lock);
+    ring_.clear();
+    keyframe_.clear();
+    since_keyframe_ = 0;
+    bytes_ = 0;
+}
+
+Rewind::Stats Rewind::stats() const
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    waitIdle(lock);
+    Stats stats;
+    stats.frames = ring_.size();
+    stats.bytes = bytes_;
+    stats.capture_us = captures_ > 0 ? capture_us_ / captures_ : 0.0;
+    stats.compress_us = encoded_ > 0 ? compress_us_ / encoded_ : 0.0;
+    stats.ratio = raw_bytes_ > 0 ? static_cast<double>(encoded_bytes_) / raw_bytes_ : 0.0;
+    return stats;
+}
+
+void Rewind::run()
+{
+    while (true) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return !pending_.empty() || is_quit_; });
+        if (is_quit_) {
+            return;
+        }
+        std::vector<uint8_t> state = std::move(pending_.front());
+        pending_.pop_front();
+        is_busy_ = true;
+        std::size_t keyframe_size = keyframe_.size();
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        Entry entry = encode(state);
+        double elapsed = std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        // a keyframe replaces the raw copy of the previous one
+        bytes_ += entry.data.size() + keyframe_.size() - keyframe_size;
+        raw_bytes_ += state.size();
+        encoded_bytes_ += entry.data.size();
+        encoded_ += 1;
+        compress_us_ += elapsed;
+        ring_.push_back(std::move(entry));
+        while (bytes_ > memory_limit_ && dropOldest()) {
+        }
+        free_buffers_.push_back(std::move(state));
+        is_busy_ = false;
+        lock.unlock();
+        cv_.notify_all();
+    }
+}
+
+Rewind::Entry Rewind::encode(const std::vector<uint8_t> &state)
+{
+    Entry entry;
+    entry.is_keyframe = since_keyframe_ == 0 || since_keyframe_ >= keyframe_interval_
+                        || state.size() != keyframe_.size();
+    if (entry.is_keyframe) {
+        keyframe_ = state;
+        since_keyframe_ = 0;
+        encodeRuns(state, scratch_);
+    }
+    else {
+        delta_.resize(state.size());
+        for (std::size_t idx = 0; idx < state.size(); idx += 1) {
+            delta_[idx] = state[idx] ^ keyframe_[idx];
+        }
+        encodeRuns(delta_, scratch_);
+    }
+    since_keyframe_ += 1;
+    entry.data.assign(scratch_.begin(), scratch_.end());
+    return entry;
+}
+
+bool Rewind::dropOldest()
+{
+    if (ring_.empty()) {
+        return false;
+    }
+    auto next = std::find_if(ring_.begin() + 1, ring_.end(),
+                             [](const Entry &entry) { return entry.is_keyframe; });
+    if (next == ring_.end()) {
+        return false;
+    }
+    for (auto it = ring_.begin(); it != next; ++it) {
+        bytes_ -= it->data.size();
+    }
+    ring_.erase(ring_.begin(), next);
+    return true;
+}
+
+void Rewind::waitIdle(std::unique_lock<std::mutex> &lock) const
+{
+    cv_.wait(lock, [this] { return pending_.empty() && !is_busy_; });
+}
+
+} // namespace tn
@@ -0,0 +1,46 @@
+#include "tinynes/rom_database.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace tn
+{
+
+namespace
+{
+
+// Sorted by CRC. Only add dumps whose checksum has been verified against the file.
+constexpr RomDatabaseEntry ENTRIES[] = {
+    // nestest, nesfiles/nestest.nes
+    {0x158B0388, 0, 0, 0, 0, 0, 0, 0},
+    // Donkey Kong, nesfiles/donkey_kong.nes
+    {0x6F97C721, 0, 0, 0, 0, 0, 0, 0},
+    // Super Mario Bros., nesfiles/smb.nes
+    {0x8E2BD25C, 0, 0, 1, 0, 0, 0, 0},
+};
+
+constexpr bool isSorted()
+{
+    for (std::size_t idx = 1; idx < std::size(ENTRIES); idx += 1) {
+        if (ENTRIES[idx - 1].crc >= ENTRIES[idx].crc) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(isSorted(), "ROM database entries must be sorted by CRC without duplicates");
+
+} // namespace
+
+const RomDatabaseEntry *findRomDatabaseEntry(uint32_t crc)
+{
+    const RomDatabaseEntry *it = std::lower_bound(
+        std::begin(ENTRIES), std::end(ENTRIES), crc,
+        [](const RomDatabaseEntry &entry, uint32_t value) { return entry.crc < value; });
+    if (it == std::end(ENTRIES) || it->crc != crc) {
+        return nullptr;
+    }
+    return it;
+}
+
+} // namespace tn
@@ -0,0 +1,127 @@
+#include "tinynes/rom_image.h"
+#include "tinynes/crc32.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace tn
+{
+
+namespace
+{
+
+// Images by content, and by the identity of files they have been loaded from so that loading
+// the same file again neither maps nor hashes it
+using FileId = std::tuple<dev_t, ino_t, off_t, time_t>;
+std::mutex cache_mutex;
+std::unordered_map<uint32_t, std::weak_ptr<const RomImage>> cache;
+std::map<FileId, std::weak_ptr<const RomImage>> file_cache;
+
+} // namespace
+
+std::shared_ptr<const RomImage> RomImage::load(std::string_view filename)
+{
+    int fd = ::open(std::string(filename).c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("RomImage cannot open {}", filename);
+        return nullptr;
+    }
+    struct stat st{};
+    void *addr = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        FileId id{st.st_dev, st.st_ino, st.st_size, st.st_mtime};
+        std::unique_lock<std::mutex> lock(cache_mutex);
+        auto it = file_cache.find(id);
+        if (it != file_cache.end()) {
+            if (std::shared_ptr<const RomImage> image = it->second.lock()) {
+                lock.unlock();
+                ::close(fd);
+                return image;
+            }
+        }
+        lock.unlock();
+        addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        spdlog::error("RomImage cannot map {}", filename);
+        return nullptr;
+    }
+
+    const auto *data = static_cast<const uint8_t *>(addr);
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    uint32_t hash = size > HASH_OFFSET ? crc32(data + HASH_OFFSET, size - HASH_OFFSET) : 0;
+
+    FileId id{st.st_dev, st.st_ino, st.st_size, st.st_mtime};
+    // declared before the lock so that it is released after it, it may be the last owner
+    std::shared_ptr<const RomImage> cached;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(hash);
+    if (it != cache.end()) {
+        cached = it->second.lock();
+        if (cached != nullptr && cached->size() == size
+            && std::memcmp(cached->data(), data, size) == 0)
+        {
+            ::munmap(addr, size);
+            file_cache[id] = cached;
+            return cached;
+        }
+    }
+    std::shared_ptr<const RomImage> image(new RomImage(data, size, hash));
+    cache[hash] = image;
+    file_cache[id] = image;
+    return image;
+}
+
+uint32_t RomImage::crc(std::size_t offset, std::size_t size) const
+{
+    if (offset == HASH_OFFSET && size + HASH_OFFSET == size_) {
+        return hash_;
+    }
+    std::lock_guard<std::mutex> lock(crc_mutex_);
+    if (!is_crc_valid_ || crc_offset_ != offset || crc_size_ != size) {
+        crc_ = crc32(data_ + offset, size);
+        crc_offset_ = offset;
+        crc_size_ = size;
+        is_crc_valid_ = true;
+    }
+    return crc_;
+}
+
+std::size_t RomImage::cachedCount()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    std::size_t count = 0;
+    for (const auto &entry : cache) {
+        count += entry.second.expired() ? 0 : 1;
+    }
+    return count;
+}
+
+RomImage::~RomImage()
+{
+    ::munmap(const_cast<uint8_t *>(data_), size_);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(hash_);
+    // a colliding image may have replaced this entry
+    if (it != cache.end() && it->second.expired()) {
+        cache.erase(it);
+    }
+    for (auto file = file_cache.begin(); file != file_cache.end();) {
+        file = file->second.expired() ? file_cache.erase(file) : std::next(file);
+    }
+}
+
+} // namespace tn
@@ -0,0 +1,329 @@
+#include "tinynes/rom_library.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+
+namespace tn
+{
+
+namespace
+{
+
+constexpr char INDEX_MAGIC[4] = {'T', 'N', 'L', 'I'};
+// bump whenever the record layout or the meaning of Cartridge::Info changes
+constexpr uint32_t INDEX_VERSION = 1;
+
+struct IndexHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+};
+
+// one per entry, the paths follow all records back to back
+struct IndexRecord
+{
+    uint64_t size;
+    int64_t mtime_ns;
+    uint32_t crc;
+    uint32_t prg_rom_size;
+    uint32_t chr_rom_size;
+    uint32_t prg_ram_size;
+    uint32_t prg_nvram_size;
+    uint32_t chr_ram_size;
+    uint32_t chr_nvram_size;
+    uint16_t mapper;
+    uint16_t path_length;
+    uint8_t submapper;
+    uint8_t flags;
+    uint8_t mirror;
+    uint8_t region;
+};
+static_assert(std::is_trivially_copyable_v<IndexRecord> && sizeof(IndexRecord) == 56);
+
+enum IndexFlag : uint8_t
+{
+    VALID = 0x01,
+    NES2 = 0x02,
+    DATABASE_MATCH = 0x04,
+    TRAINER = 0x08,
+    BATTERY = 0x10,
+    FOUR_SCREEN = 0x20,
+};
+
+IndexRecord toRecord(const RomLibrary::Entry &entry)
+{
+    const Cartridge::Info &info = entry.info;
+    IndexRecord record{};
+    record.size = entry.size;
+    record.mtime_ns = entry.mtime_ns;
+    record.crc = info.crc;
+    record.prg_rom_size = info.prg_rom_size;
+    record.chr_rom_size = info.chr_rom_size;
+    record.prg_ram_size = info.prg_ram_size;
+    record.prg_nvram_size = info.prg_nvram_size;
+    record.chr_ram_size = info.chr_ram_size;
+    record.chr_nvram_size = info.chr_nvram_size;
+    record.mapper = info.mapper;
+    record.path_length = static_cast<uint16_t>(entry.path.size());
+    record.submapper = info.submapper;
+    record.flags = (entry.is_valid ? VALID : 0) | (info.is_nes2 ? NES2 : 0)
+                   | (info.is_database_match ? DATABASE_MATCH : 0)
+                   | (info.has_trainer ? TRAINER : 0) | (info.has_battery ? BATTERY : 0)
+                   | (info.is_four_screen ? FOUR_SCREEN : 0);
+    record.mirror = static_cast<uint8_t>(info.mirror);
+    record.region = static_cast<uint8_t>(info.region);
+    return record;
+}
+
+RomLibrary::Entry fromRecord(const IndexRecord &record, std::string path)
+{
+    RomLibrary::Entry entry;
+    entry.path = std::move(path);
+    entry.size = record.size;
+    entry.mtime_ns = record.mtime_ns;
+    entry.is_valid = (record.flags & VALID) != 0;
+    Cartridge::Info &info = entry.info;
+    info.is_nes2 = (record.flags & NES2) != 0;
+    info.is_database_match = (record.flags & DATABASE_MATCH) != 0;
+    info.crc = record.crc;
+    info.mapper = record.mapper;
+    info.submapper = record.submapper;
+    info.prg_rom_size = record.prg_rom_size;
+    info.chr_rom_size = record.chr_rom_size;
+    info.prg_ram_size = record.prg_ram_size;
+    info.prg_nvram_size = record.prg_nvram_size;
+    info.chr_ram_size = record.chr_ram_size;
+    info.chr_nvram_size = record.chr_nvram_size;
+    info.has_trainer = (record.flags & TRAINER) != 0;
+    info.has_battery = (record.flags & BATTERY) != 0;
+    info.is_four_screen = (record.flags & FOUR_SCREEN) != 0;
+    info.mirror = static_cast<Cartridge::MIRROR>(record.mirror);
+    info.region = static_cast<Cartridge::Region>(record.region);
+    return entry;
+}
+
+bool isNesFile(const std::filesystem::path &path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".nes";
+}
+
+// Maps the file just long enough to read its header and checksum. The size is taken from the
+// open file, it may have changed since the directory scan looked at it.
+bool readFile(const std::string &path, Cartridge::Info &info)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    void *addr = MAP_FAILED;
+    std::size_t size = 0;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = static_cast<std::size_t>(st.st_size);
+        addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+    bool is_valid = Cartridge::readInfo(static_cast<const uint8_t *>(addr), size, info);
+    ::munmap(addr, size);
+    return is_valid;
+}
+
+} // namespace
+
+RomLibrary::RomLibrary(std::string_view index_file) : index_file_(index_file)
+{
+    if (!index_file_.empty() && !load()) {
+        entries_.clear();
+    }
+}
+
+RomLibrary::ScanStats RomLibrary::scan(const std::vector<std::string> &directories,
+                                       unsigned threads)
+{
+    namespace fs = std::filesystem;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::string> paths;
+    for (const std::string &dir : directories) {
+        std::error_code ec;
+        auto it = fs::recursive_directory_iterator(
+            dir, fs::directory_options::skip_permission_denied, ec);
+        if (ec) {
+            spdlog::warn("RomLibrary cannot scan {}: {}", dir, ec.message());
+            continue;
+        }
+        for (; it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && isNesFile(it->path())) {
+                paths.push_back(it->path().string());
+            }
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+    ScanStats stats;
+    stats.files = paths.size();
+    std::vector<Entry> entries(paths.size());
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> parsed{0};
+    std::atomic<std::size_t> invalid{0};
+    // workers only read the old entries and each one fills its own slots of the new ones
+    auto work = [&]() {
+        for (std::size_t idx = next.fetch_add(1); idx < paths.size(); idx = next.fetch_add(1)) {
+            Entry &entry = entries[idx];
+            entry.path = std::move(paths[idx]);
+            struct stat st{};
+            if (::stat(entry.path.c_str(), &st) != 0) {
+                invalid.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            entry.size = static_cast<uint64_t>(st.st_size);
+            entry.mtime_ns = int64_t{st.st_mtim.tv_sec} * 1000000000 + st.st_mtim.tv_nsec;
+
+            auto old = std::lower_bound(
+                entries_.begin(), entries_.end(), entry.path,
+                [](const Entry &lhs, const std::string &rhs) { return lhs.path < rhs; });
+            if (old != entries_.end() && old->path == entry.path && old->size == entry.size
+                && old->mtime_ns == entry.mtime_ns)
+            {
+                entry.is_valid = old->is_valid;
+                entry.info = old->info;
+            }
+            else {
+                entry.is_valid = readFile(entry.path, entry.info);
+                parsed.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!entry.is_valid) {
+                invalid.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, paths.size()));
+    std::vector<std::thread> pool;
+    for (unsigned idx = 1; idx < threads; idx += 1) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    entries_ = std::move(entries);
+    stats.parsed = parsed;
+    stats.invalid = invalid;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.seconds = elapsed.count();
+    return stats;
+}
+
+const RomLibrary::Entry *RomLibrary::findByCRC(uint32_t crc) const
+{
+    auto it = std::find_if(entries_.begin(), entries_.end(), [crc](const Entry &entry) {
+        return entry.is_valid && entry.info.crc == crc;
+    });
+    return it != entries_.end() ? &*it : nullptr;
+}
+
+bool RomLibrary::load()
+{
+    std::FILE *file = std::fopen(index_file_.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    IndexHeader header{};
+    struct stat st{};
+    bool is_ok = ::fstat(::fileno(file), &st) == 0
+                 && std::fread(&header, sizeof(header), 1, file) == 1
+                 && std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+                 && header.version == INDEX_VERSION;
+    // a damaged count must not size the records beyond what the file can hold
+    auto file_size = static_cast<uint64_t>(st.st_size);
+    is_ok = is_ok && file_size >= sizeof(header)
+            && header.count <= (file_size - sizeof(header)) / sizeof(IndexRecord);
+    std::vector<IndexRecord> records(is_ok ? header.count : 0);
+    is_ok = is_ok
+            && std::fread(records.data(), sizeof(IndexRecord), records.size(), file)
+                   == records.size();
+    std::string path;
+    for (std::size_t idx = 0; is_ok && idx < records.size(); idx += 1) {
+        path.resize(records[idx].path_length);
+        is_ok = std::fread(path.data(), 1, path.size(), file) == path.size();
+        entries_.push_back(fromRecord(records[idx], path));
+    }
+    std::fclose(file);
+    if (!is_ok) {
+        spdlog::warn("RomLibrary ignores the outdated or damaged index {}", index_file_);
+        return false;
+    }
+    // the scan looks entries up by path
+    std::sort(entries_.begin(), entries_.end(),
+              [](const Entry &lhs, const Entry &rhs) { return lhs.path < rhs.path; });
+    return true;
+}
+
+bool RomLibrary::save() const
+{
+    if (index_file_.empty()) {
+        return false;
+    }
+    std::vector<IndexRecord> records;
+    records.reserve(entries_.size());
+    for (const Entry &entry : entries_) {
+        if (entry.path.size() <= UINT16_MAX) {
+            records.push_back(toRecord(entry));
+        }
+    }
+    IndexHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.count = static_cast<uint32_t>(records.size());
+
+    // readers never see a half written index
+    std::string tmp_file = index_file_ + ".tmp";
+    std::FILE *file = std::fopen(tmp_file.c_str(), "wb");
+    if (file == nullptr) {
+        spdlog::error("RomLibrary cannot write {}", tmp_file);
+        return false;
+    }
+    bool is_ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+                 && std::fwrite(records.data(), sizeof(IndexRecord), records.size(), file)
+                        == records.size();
+    for (const Entry &entry : entries_) {
+        if (is_ok && entry.path.size() <= UINT16_MAX) {
+            is_ok = std::fwrite(entry.path.data(), 1, entry.path.size(), file) == entry.path.size();
+        }
+    }
+    is_ok = std::fclose(file) == 0 && is_ok;
+    if (!is_ok || std::rename(tmp_file.c_str(), index_file_.c_str()) != 0) {
+        spdlog::error("RomLibrary cannot write {}", index_file_);
+        std::remove(tmp_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace tn
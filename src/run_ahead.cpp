@@ -0,0 +1,72 @@
+#include "tinynes/run_ahead.h"
+#include "tinynes/vscreen.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace tn
+{
+
+RunAhead::RunAhead(Bus &bus, uint32_t frames) : bus_(bus)
+{
+    setFrames(frames);
+}
+
+RunAhead::~RunAhead()
+{
+    setFrames(0);
+}
+
+void RunAhead::setFrames(uint32_t frames)
+{
+    frames_ = std::min(frames, MAX_FRAMES);
+    // the frames of the bus are only shown while run-ahead is off
+    bus_.ppu().setFrameRendered(frames_ == 0);
+    is_ahead_ = false;
+}
+
+void RunAhead::update()
+{
+    is_ahead_ = false;
+    if (frames_ == 0 || bus_.isPlayerMode() || bus_.cartridge() == nullptr) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (bus_.cartridge() != cart_) {
+        cart_ = bus_.cartridge();
+        ahead_.insertCartridge(cart_->clone());
+    }
+    if (!bus_.saveState(state_) || !ahead_.loadState(state_)) {
+        return;
+    }
+    // the controller state came along, the frames ahead see the latest input
+    for (uint32_t frame = 1; frame <= frames_; frame += 1) {
+        ahead_.ppu().setFrameRendered(frame == frames_);
+        do {
+            ahead_.clock();
+        } while (!ahead_.ppu().getFrameState());
+        ahead_.ppu().setFrameState(false);
+    }
+    is_ahead_ = true;
+
+    updates_ += 1;
+    ahead_frames_ += frames_;
+    update_us_ += std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - start).count();
+}
+
+std::shared_ptr<VScreen> RunAhead::vScreenMain()
+{
+    return is_ahead_ ? ahead_.ppu().vScreenMain() : bus_.ppu().vScreenMain();
+}
+
+RunAhead::Stats RunAhead::stats() const
+{
+    Stats stats;
+    stats.frames = updates_;
+    stats.update_us = updates_ > 0 ? update_us_ / updates_ : 0.0;
+    stats.frame_us = ahead_frames_ > 0 ? update_us_ / ahead_frames_ : 0.0;
+    return stats;
+}
+
+} // namespace tn
@@ -0,0 +1,170 @@
+#include "tinynes/save_file.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace tn
+{
+
+namespace
+{
+
+// The thread is only started with the first save file, most games have no battery
+class Flusher
+{
+public:
+    static Flusher &instance()
+    {
+        static Flusher flusher;
+        return flusher;
+    }
+
+    ~Flusher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_stop_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // false if another save file of this process already maps the same file
+    bool add(SaveFile *file, uint64_t device, uint64_t inode)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Entry &entry : files_) {
+            if (entry.device == device && entry.inode == inode) {
+                return false;
+            }
+        }
+        files_.push_back({file, device, inode});
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&Flusher::run, this);
+        }
+        return true;
+    }
+
+    // waits for a flush of 'file' in progress
+    void remove(SaveFile *file)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        files_.erase(std::remove_if(files_.begin(), files_.end(),
+                                    [file](const Entry &entry) { return entry.file == file; }),
+                     files_.end());
+    }
+
+    void setInterval(std::chrono::milliseconds interval)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            interval_ = std::max(interval, std::chrono::milliseconds(1));
+        }
+        cv_.notify_one();
+    }
+
+    std::chrono::milliseconds interval()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return interval_;
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!is_stop_) {
+            cv_.wait_for(lock, interval_);
+            for (const Entry &entry : files_) {
+                entry.file->flush();
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        SaveFile *file;
+        uint64_t device;
+        uint64_t inode;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Entry> files_;
+    std::chrono::milliseconds interval_{1000};
+    bool is_stop_{false};
+    std::thread thread_;
+};
+
+} // namespace
+
+SaveFile::SaveFile(std::string_view filename, std::size_t size)
+{
+    int fd = ::open(std::string(filename).c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        spdlog::error("SaveFile cannot open {}", filename);
+        return;
+    }
+    // never shrink, the file may hold more than this board uses
+    struct stat st{};
+    bool is_sized = ::fstat(fd, &st) == 0
+                    && (static_cast<std::size_t>(st.st_size) >= size
+                        || ::ftruncate(fd, static_cast<off_t>(size)) == 0);
+    void *addr = MAP_FAILED;
+    if (is_sized && size > 0) {
+        addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        spdlog::error("SaveFile cannot map {}", filename);
+        return;
+    }
+    // two running games writing the same battery RAM would corrupt each other's saves
+    if (!Flusher::instance().add(this, st.st_dev, st.st_ino)) {
+        spdlog::warn("SaveFile {} is already in use", filename);
+        ::munmap(addr, size);
+        return;
+    }
+    data_ = static_cast<uint8_t *>(addr);
+    size_ = size;
+}
+
+SaveFile::~SaveFile()
+{
+    if (data_ == nullptr) {
+        return;
+    }
+    Flusher::instance().remove(this);
+    flush();
+    ::munmap(data_, size_);
+}
+
+void SaveFile::flush()
+{
+    // a write racing with this is either covered by the msync or marks the file dirty again,
+    // acquire pairs with the release in markDirty()
+    if (is_dirty_.exchange(false, std::memory_order_acquire)) {
+        ::msync(data_, size_, MS_SYNC);
+    }
+}
+
+void SaveFile::setFlushInterval(std::chrono::milliseconds interval)
+{
+    Flusher::instance().setInterval(interval);
+}
+
+std::chrono::milliseconds SaveFile::flushInterval() { return Flusher::instance().interval(); }
+
+} // namespace tn
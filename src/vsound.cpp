@@ -1,65 +1,137 @@
 #include "tinynes/vsound.h"
 #include "tinynes/bus.h"
 #include <SFML/Config.hpp>
-#include <cmath>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 namespace tn
 {
 
-void VSound::init(sf::Int16 length, sf::Uint32 channel_count, sf::Uint32 sample_rate,
+VSound::~VSound()
+{
+    if (nes_ != nullptr && nes_->audioSink() == this) {
+        nes_->setAudioSink(nullptr);
+    }
+}
+
+void VSound::init(sf::Uint32 latency_ms, sf::Uint32 channel_count, sf::Uint32 sample_rate,
                   std::shared_ptr<Bus> nes)
 {
-    samples_.resize(length, 0);
-    current_sample_ = 0;
+    latency_ms = std::clamp<sf::Uint32>(latency_ms, 10, 100);
+    target_frames_ = static_cast<std::size_t>(sample_rate) * latency_ms / 1000;
+    // twice the target, so a late audio thread does not make the emulator overrun at once
+    queue_ = std::make_unique<RingBuffer<sf::Int16>>(target_frames_ * 2);
+
+    // the device pulls a quarter of the target latency at a time
+    std::size_t chunk_frames = std::max<std::size_t>(target_frames_ / 4, 64);
+    mono_.assign(chunk_frames, 0);
+    samples_.assign(chunk_frames * channel_count, 0);
+    last_sample_ = 0;
+    underrun_count_ = 0;
+    overrun_count_ = 0;
+    sync_.reset(target_frames_);
     initialize(channel_count, sample_rate);
 
     nes_ = std::move(nes);
-    nes_->setAudioSampleFrequency(sample_rate);
+    nes_->setAudioSink(this);
 
-    spdlog::info("Virtual Sound: channel num {}, sample rate {}, buffer size {}", getChannelCount(),
-                 getSampleRate(), samples_.size());
+    spdlog::info("Virtual Sound: channel num {}, sample rate {}, latency {} ms ({} frames), "
+                 "chunk size {}",
+                 getChannelCount(), getSampleRate(), latency_ms, target_frames_, mono_.size());
 }
 
-bool VSound::onGetData(Chunk &data)
+sf::Int16 VSound::toInt16(float sample)
+{
+    return static_cast<sf::Int16>(std::clamp(sample, -1.0f, 1.0f) * MAX_SAMPLE);
+}
+
+void VSound::fill()
 {
-    auto get_mixer_sample = [&]()
-    {
+    std::size_t queued = queue_->size();
+    for (; queued < target_frames_; queued += 1) {
         while (!nes_->clock()) {
         };
-        return static_cast<float>(nes_->getAudioSample());
-    };
+    }
+    nes_->flushAudio();
+}
 
-    auto clip = [](float sample, float max)
-    {
-        if (sample >= 0.0) {
-            return std::fmin(sample, max);
-        }
-        return std::fmax(sample, -max);
-    };
+bool VSound::runFrame()
+{
+    // the display runs much faster than the NES, drop frames instead of overrunning
+    if (queue_->size() > target_frames_ * 3 / 2) {
+        return false;
+    }
+
+    // fill() stops on a sample, not on a frame, and usually runs past a vblank: without this the
+    // loop below would return after one clock with an almost empty frame
+    nes_->ppu().setFrameState(false);
+    do {
+        nes_->clock();
+    }
+    while (!nes_->ppu().getFrameState());
+    nes_->ppu().setFrameState(false);
+    nes_->flushAudio();
 
-    int len = samples_.size();
-    for (int i = 0; i < len; ++i) {
-        samples_[i] = 0;
+    nes_->setAudioSampleRatio(sync_.update(queue_->size()));
+
+    // the display runs much slower than the NES, catch up before the device runs dry
+    if (queue_->size() < target_frames_ / 2) {
+        fill();
     }
+    return true;
+}
 
-    data.samples = &samples_[current_sample_];
+void VSound::write(const float *samples, std::size_t count)
+{
+    constexpr std::size_t BLOCK_SIZE = 256;
+    sf::Int16 block[BLOCK_SIZE];
 
-    for (size_t n = 0; n < samples_.size(); n += getChannelCount()) {
-        for (uint32_t c = 0; c < getChannelCount(); c += 1) {
-            samples_[n + c] = clip(get_mixer_sample(), 1.0) * max_sample_;
+    while (count > 0) {
+        std::size_t block_size = std::min(count, BLOCK_SIZE);
+        for (std::size_t i = 0; i < block_size; i += 1) {
+            block[i] = toInt16(samples[i]);
         }
+        std::size_t pushed = queue_->push(block, block_size);
+        if (pushed < block_size) {
+            overrun_count_.fetch_add(block_size - pushed, std::memory_order_relaxed);
+        }
+        samples += block_size;
+        count -= block_size;
+    }
+}
+
+bool VSound::onGetData(Chunk &data)
+{
+    std::size_t frames = queue_->pop(mono_.data(), mono_.size());
+    if (frames > 0) {
+        last_sample_ = mono_[frames - 1];
+    }
+    if (frames < mono_.size()) {
+        // hold the last level instead of dropping to zero, a step would be audible as a click
+        underrun_count_.fetch_add(1, std::memory_order_relaxed);
+        std::fill(mono_.begin() + frames, mono_.end(), last_sample_);
     }
-    data.sampleCount = samples_.size();
-    current_sample_ = 0;
 
+    uint32_t channel_count = getChannelCount();
+    if (channel_count == 1) {
+        data.samples = mono_.data();
+        data.sampleCount = mono_.size();
+        return true;
+    }
+
+    // the same mono frame goes to every output channel
+    for (std::size_t n = 0; n < mono_.size(); n += 1) {
+        std::fill_n(&samples_[n * channel_count], channel_count, mono_[n]);
+    }
+    data.samples = samples_.data();
+    data.sampleCount = samples_.size();
     return true;
 }
 
-void VSound::onSeek(sf::Time timeOffset)
+void VSound::onSeek([[maybe_unused]] sf::Time timeOffset)
 {
-    current_sample_
-        = static_cast<std::size_t>(timeOffset.asSeconds() * getSampleRate() * getChannelCount());
+    // a live stream cannot seek, restart from whatever the emulator produces next
+    queue_->clear();
 }
 
-} // namespace tn
\ No newline at end of file
+} // namespace tn
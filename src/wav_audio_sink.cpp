@@ -0,0 +1,150 @@
+#include "tinynes/wav_audio_sink.h"
+
+#include <algorithm>
+#include <limits>
+#include <spdlog/spdlog.h>
+#include <string>
+
+namespace tn
+{
+
+WavAudioSink::WavAudioSink(std::string_view filename, uint32_t sample_rate, Format format)
+    : sample_rate_(sample_rate), format_(format)
+{
+    file_ = std::fopen(std::string(filename).c_str(), "wb");
+    if (file_ == nullptr) {
+        spdlog::error("Audio sink cannot open {}", filename);
+        return;
+    }
+    if (format_ == Format::WAV) {
+        // sizes are unknown until close(), a player still accepts the file if it is cut short
+        writeHeader(0);
+    }
+
+    front_.reserve(BUFFER_SAMPLES);
+    back_.reserve(BUFFER_SAMPLES);
+    thread_ = std::thread(&WavAudioSink::run, this);
+}
+
+WavAudioSink::~WavAudioSink() { close(); }
+
+void WavAudioSink::write(const float *samples, std::size_t count)
+{
+    if (file_ == nullptr) {
+        return;
+    }
+    for (std::size_t i = 0; i < count; i += 1) {
+        float sample = std::clamp(samples[i], -1.0f, 1.0f);
+        front_.push_back(static_cast<int16_t>(sample * 32767.0f));
+        if (front_.size() == BUFFER_SAMPLES) {
+            submit();
+        }
+    }
+    samples_written_ += count;
+}
+
+void WavAudioSink::submit()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return !is_busy_; });
+    front_.swap(back_);
+    front_.clear();
+    is_busy_ = true;
+    lock.unlock();
+    cv_.notify_all();
+}
+
+void WavAudioSink::flush()
+{
+    if (file_ == nullptr) {
+        return;
+    }
+    if (!front_.empty()) {
+        submit();
+    }
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return !is_busy_; });
+    std::fflush(file_);
+}
+
+void WavAudioSink::close()
+{
+    if (file_ == nullptr) {
+        return;
+    }
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        is_quit_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+
+    if (format_ == Format::WAV) {
+        // a RIFF chunk cannot describe more than 4 GiB of data
+        uint64_t data_bytes = samples_written_ * sizeof(int16_t);
+        writeHeader(static_cast<uint32_t>(
+            std::min<uint64_t>(data_bytes, std::numeric_limits<uint32_t>::max() - 36)));
+    }
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void WavAudioSink::run()
+{
+    while (true) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return is_busy_ || is_quit_; });
+        if (!is_busy_ && is_quit_) {
+            return;
+        }
+        lock.unlock();
+
+        if (std::fwrite(back_.data(), sizeof(int16_t), back_.size(), file_) != back_.size()) {
+            spdlog::error("Audio sink write failed");
+        }
+
+        lock.lock();
+        is_busy_ = false;
+        lock.unlock();
+        cv_.notify_all();
+    }
+}
+
+// WAVE format: <http://soundfile.sapp.org/doc/WaveFormat/>, all fields are little endian
+void WavAudioSink::writeHeader(uint32_t data_bytes)
+{
+    auto put16 = [](uint8_t *p, uint16_t val)
+    {
+        p[0] = val & 0xFF;
+        p[1] = val >> 8;
+    };
+    auto put32 = [](uint8_t *p, uint32_t val)
+    {
+        for (int i = 0; i < 4; i += 1, val >>= 8) {
+            p[i] = val & 0xFF;
+        }
+    };
+
+    constexpr uint16_t CHANNELS = 1;
+    constexpr uint16_t BITS = 16;
+    uint8_t header[44] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                          'f', 'm', 't', ' ', 0, 0, 0, 0, 0, 0, 0, 0,
+                          0,   0,   0,   0,   0, 0, 0, 0, 0, 0, 0, 0,
+                          'd', 'a', 't', 'a', 0, 0, 0, 0};
+    put32(&header[4], 36 + data_bytes);
+    put32(&header[16], 16); // PCM format chunk size
+    put16(&header[20], 1);  // PCM
+    put16(&header[22], CHANNELS);
+    put32(&header[24], sample_rate_);
+    put32(&header[28], sample_rate_ * CHANNELS * BITS / 8);
+    put16(&header[32], CHANNELS * BITS / 8);
+    put16(&header[34], BITS);
+    put32(&header[40], data_bytes);
+
+    std::fseek(file_, 0, SEEK_SET);
+    std::fwrite(header, 1, sizeof(header), file_);
+    std::fseek(file_, 0, SEEK_END);
+}
+
+} // namespace tn
@@ -0,0 +1,197 @@
+#include "tinynes/bus.h"
+#include "tinynes/nsf.h"
+#include "tinynes/wav_audio_sink.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+// Renders NSF tracks to WAV files as fast as the host allows, without a PPU or an audio device,
+// and reports the render speed as a multiple of real time.
+//
+// usage: nsf_render <file.nsf> [-t track] [-a] [-s seconds] [-r rate] [-o output] [-S]
+//                   [-m mask] [-z mask]
+//   -t  1-based track to render, the starting song of the file by default
+//   -a  render all tracks, output files get a _NN suffix
+//   -s  seconds per track, 150 by default
+//   -r  sample rate, 44100 by default
+//   -o  output file name, <file>.wav by default
+//   -S  also write one stem per channel, suffixed _pulse1, _pulse2, _triangle, _noise, _dmc
+//   -m  mute mask, bit 0 pulse 1, bit 1 pulse 2, bit 2 triangle, bit 3 noise, bit 4 DMC
+//   -z  solo mask, same bits
+
+namespace
+{
+
+struct Options
+{
+    std::string input;
+    std::string output;
+    int track{0};
+    bool is_all{false};
+    uint32_t seconds{150};
+    uint32_t sample_rate{44100};
+    bool is_stems{false};
+    uint8_t mute_mask{0};
+    uint8_t solo_mask{0};
+};
+
+constexpr const char *STEM_NAMES[tn::APU::CHANNEL_COUNT] = {"pulse1", "pulse2", "triangle",
+                                                             "noise", "dmc"};
+
+void usage()
+{
+    std::fprintf(stderr, "usage: nsf_render <file.nsf> [-t track] [-a] [-s seconds] [-r rate] "
+                         "[-o output] [-S] [-m mask] [-z mask]\n");
+}
+
+bool parse(int argc, char *argv[], Options &opt)
+{
+    for (int idx = 1; idx < argc; idx += 1) {
+        std::string arg = argv[idx];
+        bool has_value = idx + 1 < argc;
+        if (arg == "-a") {
+            opt.is_all = true;
+        }
+        else if (arg == "-S") {
+            opt.is_stems = true;
+        }
+        else if (arg == "-m" && has_value) {
+            opt.mute_mask = static_cast<uint8_t>(std::strtol(argv[++idx], nullptr, 0));
+        }
+        else if (arg == "-z" && has_value) {
+            opt.solo_mask = static_cast<uint8_t>(std::strtol(argv[++idx], nullptr, 0));
+        }
+        else if (arg == "-t" && has_value) {
+            opt.track = std::atoi(argv[++idx]);
+        }
+        else if (arg == "-s" && has_value) {
+            opt.seconds = static_cast<uint32_t>(std::atoi(argv[++idx]));
+        }
+        else if (arg == "-r" && has_value) {
+            opt.sample_rate = static_cast<uint32_t>(std::atoi(argv[++idx]));
+        }
+        else if (arg == "-o" && has_value) {
+            opt.output = argv[++idx];
+        }
+        else if (arg[0] != '-' && opt.input.empty()) {
+            opt.input = arg;
+        }
+        else {
+            return false;
+        }
+    }
+    if (opt.output.empty()) {
+        std::size_t dot = opt.input.find_last_of('.');
+        opt.output = opt.input.substr(0, dot) + ".wav";
+    }
+    return !opt.input.empty() && opt.seconds > 0 && opt.sample_rate > 0;
+}
+
+std::string suffixed(const std::string &output, const std::string &suffix)
+{
+    std::size_t dot = output.find_last_of('.');
+    if (dot == std::string::npos) {
+        return output + suffix;
+    }
+    return output.substr(0, dot) + suffix + output.substr(dot);
+}
+
+std::string trackFileName(const std::string &output, int track)
+{
+    char suffix[8];
+    std::snprintf(suffix, sizeof(suffix), "_%02d", track + 1);
+    return suffixed(output, suffix);
+}
+
+// returns the wall clock time in seconds
+double renderTrack(tn::Bus &bus, uint8_t track, const std::string &filename,
+                   const Options &opt)
+{
+    tn::WavAudioSink sink(filename, opt.sample_rate);
+    if (!sink.isOpen()) {
+        return 0.0;
+    }
+    bus.setAudioSink(&sink);
+
+    std::array<std::unique_ptr<tn::WavAudioSink>, tn::APU::CHANNEL_COUNT> stems;
+    if (opt.is_stems) {
+        for (uint8_t ch = 0; ch < tn::APU::CHANNEL_COUNT; ch += 1) {
+            stems[ch] = std::make_unique<tn::WavAudioSink>(
+                suffixed(filename, std::string("_") + STEM_NAMES[ch]), opt.sample_rate);
+            bus.setAudioStemSink(static_cast<tn::APU::Channel>(ch), stems[ch].get());
+        }
+    }
+    bus.playTrack(track);
+
+    uint64_t samples = static_cast<uint64_t>(opt.sample_rate) * opt.seconds;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t n = 0; n < samples;) {
+        if (bus.clock()) {
+            n += 1;
+        }
+    }
+    bus.flushAudio();
+    bus.setAudioSink(nullptr);
+    sink.close();
+    for (uint8_t ch = 0; ch < tn::APU::CHANNEL_COUNT && opt.is_stems; ch += 1) {
+        bus.setAudioStemSink(static_cast<tn::APU::Channel>(ch), nullptr);
+        stems[ch]->close();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+
+    auto nsf = std::make_shared<tn::NSF>(opt.input);
+    if (!nsf->isNsfFileLoaded()) {
+        return 1;
+    }
+
+    int first = opt.track > 0 ? opt.track - 1 : nsf->startingSong();
+    int last = first;
+    if (opt.is_all) {
+        first = 0;
+        last = nsf->totalSongs() - 1;
+    }
+    if (first < 0 || last >= nsf->totalSongs()) {
+        std::fprintf(stderr, "track out of range, the file has %d tracks\n", nsf->totalSongs());
+        return 1;
+    }
+
+    tn::Bus bus;
+    bus.insertNSF(nsf);
+    bus.setAudioMuteMask(opt.mute_mask);
+    bus.setAudioSoloMask(opt.solo_mask);
+
+    double total_wall = 0.0;
+    double total_audio = 0.0;
+    for (int track = first; track <= last; track += 1) {
+        std::string filename = opt.is_all ? trackFileName(opt.output, track) : opt.output;
+        double wall = renderTrack(bus, static_cast<uint8_t>(track), filename, opt);
+        if (wall <= 0.0) {
+            return 1;
+        }
+        std::printf("track %2d: %u s of audio in %.2f s, %.1fx real time -> %s\n", track + 1,
+                    opt.seconds, wall, opt.seconds / wall, filename.c_str());
+        total_wall += wall;
+        total_audio += opt.seconds;
+    }
+    if (last > first) {
+        std::printf("total: %.0f s of audio in %.2f s, %.1fx real time\n", total_audio,
+                    total_wall, total_audio / total_wall);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "tinynes/rom_library.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Indexes the .nes files under the given directories and reports the scan speed. With an index
+// file, later runs only read the files which changed since.
+//
+// usage: rom_scan [-i index] [-j threads] [-l] <directory>...
+//   -i  index file to load and update, none by default
+//   -j  worker threads, one per hardware thread by default
+//   -l  list the indexed files
+
+namespace
+{
+
+struct Options
+{
+    std::vector<std::string> directories;
+    std::string index_file;
+    unsigned threads{0};
+    bool is_list{false};
+};
+
+void usage()
+{
+    std::fprintf(stderr, "usage: rom_scan [-i index] [-j threads] [-l] <directory>...\n");
+}
+
+bool parse(int argc, char *argv[], Options &opt)
+{
+    for (int idx = 1; idx < argc; idx += 1) {
+        std::string arg = argv[idx];
+        bool has_value = idx + 1 < argc;
+        if (arg == "-l") {
+            opt.is_list = true;
+        }
+        else if (arg == "-i" && has_value) {
+            opt.index_file = argv[++idx];
+        }
+        else if (arg == "-j" && has_value) {
+            opt.threads = static_cast<unsigned>(std::atoi(argv[++idx]));
+        }
+        else if (arg[0] != '-') {
+            opt.directories.push_back(arg);
+        }
+        else {
+            return false;
+        }
+    }
+    return !opt.directories.empty();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+
+    tn::RomLibrary library(opt.index_file);
+    tn::RomLibrary::ScanStats stats = library.scan(opt.directories, opt.threads);
+    if (!opt.index_file.empty() && !library.save()) {
+        return 1;
+    }
+
+    if (opt.is_list) {
+        for (const tn::RomLibrary::Entry &entry : library.entries()) {
+            if (!entry.is_valid) {
+                std::printf("invalid                          %s\n", entry.path.c_str());
+                continue;
+            }
+            const tn::Cartridge::Info &info = entry.info;
+            std::printf("%08X mapper %3u PRG %4uK CHR %4uK%s %s\n", info.crc, info.mapper,
+                        info.prg_rom_size / 1024, info.chr_rom_size / 1024,
+                        info.has_battery ? " B" : "  ", entry.path.c_str());
+        }
+    }
+    std::printf("%zu files, %zu read, %zu invalid in %.3f s, %.0f files/s\n", stats.files,
+                stats.parsed, stats.invalid, stats.seconds, stats.filesPerSecond());
+    return 0;
+}